@@ -16,6 +16,7 @@
         "-lopencv_core",
         "-lopencv_imgproc",
         "-lopencv_highgui",
+        "-lopencv_videoio",
 	"-L/usr/local/lib"
       ],
 
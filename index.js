@@ -6,6 +6,8 @@ const EncodeType = cv.EncodeType;
 const BorderType = cv.BorderType;
 const Channel = cv.Channel;
 const Conversion = cv.Conversion;
+const Interpolation = cv.Interpolation;
+const YUVFormat = cv.YUVFormat;
 
 class Matrix {
 
@@ -19,6 +21,14 @@ class Matrix {
     }
   }
 
+  static fromShared(handle) {
+    return matrix(cv.Matrix.fromShared(handle));
+  }
+
+  static releaseShared(handle) {
+    return cv.Matrix.releaseShared(handle);
+  }
+
   get native() {
     return this._native;
   }
@@ -35,6 +45,10 @@ class Matrix {
     return this.native.type;
   }
 
+  get readOnly() {
+    return this.native.readOnly;
+  }
+
   crop(...args) {
     return asyncWrap(this.native, this.native.crop, args);
   }
@@ -51,6 +65,14 @@ class Matrix {
     return wrap(this.native, this.native.set, args, this);
   }
 
+  setMany(tiles, ...args) {
+    return asyncWrap(this.native, this.native.setMany, [nativeTiles(tiles), ...args], this);
+  }
+
+  setManySync(tiles, ...args) {
+    return wrap(this.native, this.native.setMany, [nativeTiles(tiles), ...args], this);
+  }
+
   add(...args) {
     return asyncWrap(this.native, this.native.add, args, this);
   }
@@ -79,6 +101,14 @@ class Matrix {
     return wrap(this.native, this.native.clone, args);
   }
 
+  share() {
+    return this.native.share();
+  }
+
+  release() {
+    this.native.release();
+  }
+
   toString() {
     return JSON.stringify(this);
   }
@@ -95,6 +125,18 @@ class Matrix {
     return this.native.toBuffer();
   }
 
+  toTypedArray() {
+    return this.native.toTypedArray();
+  }
+
+  convertTo(...args) {
+    return asyncWrap(this.native, this.native.convertTo, args);
+  }
+
+  convertToSync(...args) {
+    return wrap(this.native, this.native.convertTo, args);
+  }
+
   toJSON() {
     return {
       width: this.width,
@@ -105,6 +147,201 @@ class Matrix {
   }
 }
 
+class VideoReader {
+
+  constructor(native) {
+    this._native = native;
+  }
+
+  get native() {
+    return this._native;
+  }
+
+  get width() {
+    return this.native.width;
+  }
+
+  get height() {
+    return this.native.height;
+  }
+
+  get fps() {
+    return this.native.fps;
+  }
+
+  get frameCount() {
+    return this.native.frameCount;
+  }
+
+  read() {
+    return asyncWrap(this.native, this.native.read, []);
+  }
+
+  readSync() {
+    return wrap(this.native, this.native.read, []);
+  }
+
+  close() {
+    this.native.close();
+  }
+
+  [Symbol.asyncIterator]() {
+    return {
+      next: () => {
+        return this.read().then(frame => {
+          if (frame) {
+            return {value: frame, done: false};
+          } else {
+            this.close();
+            return {value: undefined, done: true};
+          }
+        });
+      },
+
+      return: () => {
+        this.close();
+        return Promise.resolve({value: undefined, done: true});
+      }
+    };
+  }
+}
+
+class VideoWriter {
+
+  constructor(native) {
+    this._native = native;
+  }
+
+  get native() {
+    return this._native;
+  }
+
+  write(...args) {
+    return asyncWrap(this.native, this.native.write, args);
+  }
+
+  writeSync(...args) {
+    return wrap(this.native, this.native.write, args);
+  }
+
+  close(...args) {
+    return asyncWrap(this.native, this.native.close, args);
+  }
+
+  closeSync(...args) {
+    return wrap(this.native, this.native.close, args);
+  }
+}
+
+class Warp {
+
+  constructor(native) {
+    this._native = native;
+  }
+
+  get native() {
+    return this._native;
+  }
+
+  get width() {
+    return this.native.width;
+  }
+
+  get height() {
+    return this.native.height;
+  }
+
+  apply(...args) {
+    return asyncWrap(this.native, this.native.apply, args);
+  }
+
+  applySync(...args) {
+    return wrap(this.native, this.native.apply, args);
+  }
+}
+
+class Transform {
+
+  constructor(matrix) {
+    this._native = new cv.Transform(matrix instanceof Matrix ? matrix.native : matrix);
+  }
+
+  get native() {
+    return this._native;
+  }
+
+  scale(...args) {
+    return wrap(this.native, this.native.scale, args, this);
+  }
+
+  rotate(...args) {
+    return wrap(this.native, this.native.rotate, args, this);
+  }
+
+  translate(...args) {
+    return wrap(this.native, this.native.translate, args, this);
+  }
+
+  flipLeftRight() {
+    return wrap(this.native, this.native.flipLeftRight, [], this);
+  }
+
+  flipUpDown() {
+    return wrap(this.native, this.native.flipUpDown, [], this);
+  }
+
+  compose(other) {
+    return wrap(this.native, this.native.compose, [other instanceof Transform ? other.native : other], this);
+  }
+
+  invert() {
+    return wrap(this.native, this.native.invert, [], this);
+  }
+
+  toMatrix() {
+    return wrap(this.native, this.native.toMatrix, []);
+  }
+
+  apply(...args) {
+    return asyncWrap(this.native, this.native.apply, args);
+  }
+
+  applySync(...args) {
+    return wrap(this.native, this.native.apply, args);
+  }
+}
+
+class HashIndex {
+
+  constructor() {
+    this._native = new cv.HashIndex();
+  }
+
+  get native() {
+    return this._native;
+  }
+
+  get size() {
+    return this.native.size;
+  }
+
+  add(...args) {
+    return asyncWrap(this.native, this.native.add, args);
+  }
+
+  addSync(...args) {
+    return wrap(this.native, this.native.add, args);
+  }
+
+  query(...args) {
+    return asyncWrap(this.native, this.native.query, args);
+  }
+
+  querySync(...args) {
+    return wrap(this.native, this.native.query, args);
+  }
+}
+
 function matrix(...args) {
   return new Matrix(...args);
 }
@@ -121,6 +358,14 @@ function drawLine(...args) {
   return wrap(cv, cv.drawLine, args);
 }
 
+function composite(base, ...args) {
+  return asyncWrap(cv, cv.composite, [base, ...args], base);
+}
+
+function compositeSync(base, ...args) {
+  return wrap(cv, cv.composite, [base, ...args], base);
+}
+
 function waitKey(...args) {
   return wrap(cv, cv.waitKey, args);
 }
@@ -129,6 +374,34 @@ function rotationMatrix(...args) {
   return wrap(cv, cv.rotationMatrix, args);
 }
 
+function setImageCacheLimit(...args) {
+  return wrap(cv, cv.setImageCacheLimit, args);
+}
+
+function clearImageCache(...args) {
+  return wrap(cv, cv.clearImageCache, args);
+}
+
+function imageCacheStats(...args) {
+  return wrap(cv, cv.imageCacheStats, args);
+}
+
+function openVideo(...args) {
+  return asyncWrap(cv, cv.openVideo, args).then(native => new VideoReader(native));
+}
+
+function openVideoSync(...args) {
+  return new VideoReader(wrap(cv, cv.openVideo, args));
+}
+
+function createVideoWriter(...args) {
+  return asyncWrap(cv, cv.createVideoWriter, args).then(native => new VideoWriter(native));
+}
+
+function createVideoWriterSync(...args) {
+  return new VideoWriter(wrap(cv, cv.createVideoWriter, args));
+}
+
 function readImage(...args) {
   return asyncWrap(cv, cv.readImage, args);
 }
@@ -153,6 +426,14 @@ function decodeImageSync(...args) {
   return wrap(cv, cv.decodeImage, args);
 }
 
+function probeImage(...args) {
+  return asyncWrap(cv, cv.probeImage, args);
+}
+
+function probeImageSync(...args) {
+  return wrap(cv, cv.probeImage, args);
+}
+
 function writeImage(...args) {
   return asyncWrap(cv, cv.writeImage, args);
 }
@@ -161,6 +442,22 @@ function writeImageSync(...args) {
   return wrap(cv, cv.writeImage, args);
 }
 
+function fromYUV(...args) {
+  return asyncWrap(cv, cv.fromYUV, args);
+}
+
+function fromYUVSync(...args) {
+  return wrap(cv, cv.fromYUV, args);
+}
+
+function toYUV(...args) {
+  return asyncWrap(cv, cv.toYUV, args);
+}
+
+function toYUVSync(...args) {
+  return wrap(cv, cv.toYUV, args);
+}
+
 function encodeImage(...args) {
   return asyncWrap(cv, cv.encodeImage, args);
 }
@@ -177,6 +474,14 @@ function resizeSync(...args) {
   return wrap(cv, cv.resize, args);
 }
 
+function resizeMany(...args) {
+  return asyncWrap(cv, cv.resizeMany, args);
+}
+
+function resizeManySync(...args) {
+  return wrap(cv, cv.resizeMany, args);
+}
+
 function warpAffine(...args) {
   return asyncWrap(cv, cv.warpAffine, args);
 }
@@ -185,6 +490,14 @@ function warpAffineSync(...args) {
   return wrap(cv, cv.warpAffine, args);
 }
 
+function createWarp(...args) {
+  return asyncWrap(cv, cv.createWarp, args).then(native => new Warp(native));
+}
+
+function createWarpSync(...args) {
+  return new Warp(wrap(cv, cv.createWarp, args));
+}
+
 function flipUpDown(...args) {
   return asyncWrap(cv, cv.flipUpDown, args);
 }
@@ -225,6 +538,26 @@ function lookupSync(...args) {
   return wrap(cv, cv.lookup, args);
 }
 
+function composeLookups(...args) {
+  return wrap(cv, cv.composeLookups, args);
+}
+
+function lookup3d(...args) {
+  return asyncWrap(cv, cv.lookup3d, args);
+}
+
+function lookup3dSync(...args) {
+  return wrap(cv, cv.lookup3d, args);
+}
+
+function readCubeLut(...args) {
+  return asyncWrap(cv, cv.readCubeLut, args);
+}
+
+function readCubeLutSync(...args) {
+  return wrap(cv, cv.readCubeLut, args);
+}
+
 function gaussianBlur(...args) {
   return asyncWrap(cv, cv.gaussianBlur, args);
 }
@@ -241,18 +574,156 @@ function colorTemperatureSync(...args) {
   return wrap(cv, cv.colorTemperature, args);
 }
 
+function stats(...args) {
+  return asyncWrap(cv, cv.stats, args);
+}
+
+function statsSync(...args) {
+  return wrap(cv, cv.stats, args);
+}
+
+function histogram(...args) {
+  return asyncWrap(cv, cv.histogram, args);
+}
+
+function histogramSync(...args) {
+  return wrap(cv, cv.histogram, args);
+}
+
+function countNonZero(...args) {
+  return asyncWrap(cv, cv.countNonZero, args);
+}
+
+function countNonZeroSync(...args) {
+  return wrap(cv, cv.countNonZero, args);
+}
+
+function equalizeHist(...args) {
+  return asyncWrap(cv, cv.equalizeHist, args);
+}
+
+function equalizeHistSync(...args) {
+  return wrap(cv, cv.equalizeHist, args);
+}
+
+function clahe(...args) {
+  return asyncWrap(cv, cv.clahe, args);
+}
+
+function claheSync(...args) {
+  return wrap(cv, cv.clahe, args);
+}
+
+function perceptualHash(...args) {
+  return asyncWrap(cv, cv.perceptualHash, args);
+}
+
+function perceptualHashSync(...args) {
+  return wrap(cv, cv.perceptualHash, args);
+}
+
+function hashDistance(...args) {
+  return wrap(cv, cv.hashDistance, args);
+}
+
+function compare(...args) {
+  return asyncWrap(cv, cv.compare, args);
+}
+
+function compareSync(...args) {
+  return wrap(cv, cv.compare, args);
+}
+
+function extractPatches(...args) {
+  return asyncWrap(cv, cv.extractPatches, args);
+}
+
+function extractPatchesSync(...args) {
+  return wrap(cv, cv.extractPatches, args);
+}
+
+function nms(...args) {
+  return asyncWrap(cv, cv.nms, args);
+}
+
+function nmsSync(...args) {
+  return wrap(cv, cv.nms, args);
+}
+
+function boxIoU(...args) {
+  return asyncWrap(cv, cv.boxIoU, args);
+}
+
+function boxIoUSync(...args) {
+  return wrap(cv, cv.boxIoU, args);
+}
+
+function clipBoxes(...args) {
+  return asyncWrap(cv, cv.clipBoxes, args);
+}
+
+function clipBoxesSync(...args) {
+  return wrap(cv, cv.clipBoxes, args);
+}
+
+function mapMatrix(...args) {
+  return asyncWrap(cv, cv.mapMatrix, args);
+}
+
+function mapMatrixSync(...args) {
+  return wrap(cv, cv.mapMatrix, args);
+}
+
+function saveMatrix(...args) {
+  return asyncWrap(cv, cv.saveMatrix, args);
+}
+
+function saveMatrixSync(...args) {
+  return wrap(cv, cv.saveMatrix, args);
+}
+
 function rotate(image, opt) {
   return new Promise((resolve, reject) => {
-    const {transformation, warpOptions} = rotateShared(image, opt);
-    warpAffine(image, transformation, warpOptions).then(resolve).catch(reject);
+    const turns = quarterTurns(opt);
+
+    if (turns !== null) {
+      asyncWrap(cv, cv.rotateQuarterTurns, [image, turns]).then(resolve).catch(reject);
+    } else {
+      const {transformation, warpOptions} = rotateShared(image, opt);
+      warpAffine(image, transformation, warpOptions).then(resolve).catch(reject);
+    }
   });
 }
 
 function rotateSync(image, opt) {
+  const turns = quarterTurns(opt);
+
+  if (turns !== null) {
+    return wrap(cv, cv.rotateQuarterTurns, [image, turns]);
+  }
+
   const {transformation, warpOptions} = rotateShared(image, opt);
   return warpAffineSync(image, transformation, warpOptions);
 }
 
+// Rotations around the image center by a multiple of 90 degrees don't need to be
+// interpolated. Returns the number of counter-clockwise quarter turns or null.
+function quarterTurns(opt) {
+  let angle = NaN;
+
+  if (typeof opt === 'number') {
+    angle = opt;
+  } else if (typeof opt === 'object' && opt && typeof opt.xCenter !== 'number' && typeof opt.yCenter !== 'number') {
+    angle = opt.angle || 0;
+  }
+
+  if (angle % 90 !== 0) {
+    return null;
+  }
+
+  return ((angle / 90) % 4 + 4) % 4;
+}
+
 function rotateShared(image, opt) {
   let rot;
   let warpOpt = {};
@@ -322,10 +793,26 @@ function asyncWrap(obj, method, args, returnValue) {
   });
 }
 
+function nativeTiles(tiles) {
+  if (!Array.isArray(tiles)) {
+    return tiles;
+  }
+
+  return tiles.map(tile => {
+    if (tile && tile.source instanceof Matrix) {
+      return Object.assign({}, tile, {source: tile.source.native});
+    } else {
+      return tile;
+    }
+  });
+}
+
 function wrapMatrices(args) {
   return args.map(arg => {
     if (arg instanceof Matrix) {
       return arg.native;
+    } else if (Array.isArray(arg)) {
+      return wrapMatrices(arg);
     } else {
       return arg;
     }
@@ -344,32 +831,58 @@ function unwrapMatrices(args) {
 
 module.exports = {
   Matrix,
+  VideoReader,
+  VideoWriter,
+  HashIndex,
+  Warp,
+  Transform,
   ImageType,
   EncodeType,
   BorderType,
   Conversion,
   Channel,
+  Interpolation,
+  YUVFormat,
   Rect,
 
   matrix,
   showImage,
   drawRectangle,
   drawLine,
+  composite,
+  compositeSync,
   waitKey,
   readImage,
   readImageSync,
+  setImageCacheLimit,
+  clearImageCache,
+  imageCacheStats,
+  openVideo,
+  openVideoSync,
+  createVideoWriter,
+  createVideoWriterSync,
   convertColor,
   convertColorSync,
   decodeImage,
   decodeImageSync,
+  probeImage,
+  probeImageSync,
   writeImage,
   writeImageSync,
   encodeImage,
   encodeImageSync,
+  fromYUV,
+  fromYUVSync,
+  toYUV,
+  toYUVSync,
   resize,
   resizeSync,
+  resizeMany,
+  resizeManySync,
   warpAffine,
   warpAffineSync,
+  createWarp,
+  createWarpSync,
   rotationMatrix,
   rotate,
   rotateSync,
@@ -383,8 +896,40 @@ module.exports = {
   mergeSync,
   lookup,
   lookupSync,
+  composeLookups,
+  lookup3d,
+  lookup3dSync,
+  readCubeLut,
+  readCubeLutSync,
   gaussianBlur,
   gaussianBlurSync,
   colorTemperature,
-  colorTemperatureSync
+  colorTemperatureSync,
+  stats,
+  statsSync,
+  histogram,
+  histogramSync,
+  countNonZero,
+  countNonZeroSync,
+  equalizeHist,
+  equalizeHistSync,
+  clahe,
+  claheSync,
+  perceptualHash,
+  perceptualHashSync,
+  hashDistance,
+  compare,
+  compareSync,
+  extractPatches,
+  extractPatchesSync,
+  nms,
+  nmsSync,
+  boxIoU,
+  boxIoUSync,
+  clipBoxes,
+  clipBoxesSync,
+  mapMatrix,
+  mapMatrixSync,
+  saveMatrix,
+  saveMatrixSync
 };
\ No newline at end of file
@@ -0,0 +1,346 @@
+#ifndef SIMPLE_CV_HASH_INDEX_H
+#define SIMPLE_CV_HASH_INDEX_H
+
+#include <nan.h>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include "async.h"
+#include "perceptualHash.h"
+
+struct HashMatch {
+  double id;
+  uint64_t hash;
+  int distance;
+};
+
+/**
+ * BK-tree over 64 bit hashes with the Hamming distance as the metric. Each child
+ * is stored with its distance to the parent, and by the triangle inequality only
+ * children whose distance is within `maxDistance` of the query's distance to the
+ * parent can contain matches.
+ */
+class BKTree {
+
+public:
+
+  BKTree()
+    : count(0) {
+  }
+
+  void add(uint64_t hash, double id) {
+    ++count;
+
+    if (nodes.empty()) {
+      nodes.push_back(Node(hash, id));
+      return;
+    }
+
+    size_t current = 0;
+
+    while (true) {
+      auto distance = hammingDistance(hash, nodes[current].hash);
+
+      if (distance == 0) {
+        nodes[current].ids.push_back(id);
+        return;
+      }
+
+      auto& children = nodes[current].children;
+      auto child = std::find_if(children.begin(), children.end(), [distance](const std::pair<int, size_t>& it) {
+        return it.first == distance;
+      });
+
+      if (child == children.end()) {
+        children.push_back(std::make_pair(distance, nodes.size()));
+        // Invalidates `children`.
+        nodes.push_back(Node(hash, id));
+        return;
+      }
+
+      current = child->second;
+    }
+  }
+
+  std::vector<HashMatch> query(uint64_t hash, int maxDistance) const {
+    std::vector<HashMatch> matches;
+    std::vector<size_t> stack;
+
+    if (!nodes.empty()) {
+      stack.push_back(0);
+    }
+
+    while (!stack.empty()) {
+      auto& node = nodes[stack.back()];
+      stack.pop_back();
+
+      auto distance = hammingDistance(hash, node.hash);
+
+      if (distance <= maxDistance) {
+        for (auto id : node.ids) {
+          matches.push_back(HashMatch { id, node.hash, distance });
+        }
+      }
+
+      for (auto& child : node.children) {
+        if (child.first >= distance - maxDistance && child.first <= distance + maxDistance) {
+          stack.push_back(child.second);
+        }
+      }
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const HashMatch& a, const HashMatch& b) {
+      return a.distance < b.distance;
+    });
+
+    return matches;
+  }
+
+  size_t size() const {
+    return count;
+  }
+
+private:
+
+  struct Node {
+    uint64_t hash;
+    std::vector<double> ids;
+    std::vector<std::pair<int, size_t>> children;
+
+    Node(uint64_t hash, double id)
+      : hash(hash)
+      , ids(1, id) {
+    }
+  };
+
+  std::vector<Node> nodes;
+  size_t count;
+};
+
+/**
+ * The tree is shared with the async workers so that it stays alive
+ * even if the JS object is garbage collected during a batch operation.
+ */
+struct HashIndexData {
+  std::mutex mutex;
+  BKTree tree;
+};
+
+class HashIndex : public Nan::ObjectWrap {
+
+public:
+
+  static NAN_MODULE_INIT(init) {
+    v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+
+    tpl->SetClassName(Nan::New("__NativeHashIndex").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    Nan::SetPrototypeMethod(tpl, "add", add);
+    Nan::SetPrototypeMethod(tpl, "query", query);
+
+    Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("size").ToLocalChecked(), getSize);
+
+    Nan::Set(target, Nan::New("HashIndex").ToLocalChecked(), Nan::GetFunction(tpl).ToLocalChecked());
+  }
+
+private:
+
+  HashIndex()
+    : data(std::make_shared<HashIndexData>()) {
+  }
+
+  ~HashIndex() {
+    // Nothing to do here.
+  }
+
+  static NAN_METHOD(New) {
+    if (!info.IsConstructCall()) {
+      Nan::ThrowError("Class constructor HashIndex cannot be invoked without 'new'");
+      return;
+    }
+
+    auto index = new HashIndex();
+    index->Wrap(info.This());
+    info.GetReturnValue().Set(info.This());
+  }
+
+  static NAN_GETTER(getSize) {
+    auto data = Nan::ObjectWrap::Unwrap<HashIndex>(info.Holder())->data;
+    std::lock_guard<std::mutex> lock(data->mutex);
+    info.GetReturnValue().Set(Nan::New(static_cast<double>(data->tree.size())));
+  }
+
+  /**
+   * Reads a hash or an array of hashes.
+   */
+  static bool getHashes(v8::Local<v8::Value> value, std::vector<uint64_t>& hashes) {
+    Nan::HandleScope scope;
+    uint64_t hash;
+
+    if (!value->IsArray()) {
+      if (!parseHash(value, hash)) {
+        return false;
+      }
+
+      hashes.push_back(hash);
+      return true;
+    }
+
+    auto arr = value.As<v8::Array>();
+
+    for (unsigned i = 0; i < arr->Length(); ++i) {
+      if (!parseHash(Nan::Get(arr, i).ToLocalChecked(), hash)) {
+        return false;
+      }
+
+      hashes.push_back(hash);
+    }
+
+    return true;
+  }
+
+  /**
+   * add(hash, id)
+   * add(hash, id, callback)
+   * add([hash, ...], [id, ...])
+   * add([hash, ...], [id, ...], callback)
+   */
+  static NAN_METHOD(add) {
+    auto data = Nan::ObjectWrap::Unwrap<HashIndex>(info.Holder())->data;
+
+    if (info.Length() < 2 || info.Length() > 3) {
+      Nan::ThrowError("expected at least two arguments (hash, id) and at most three arguments (hash, id, callback)");
+      return;
+    }
+
+    std::vector<uint64_t> hashes;
+    std::vector<double> ids;
+
+    if (!getHashes(info[0], hashes)) {
+      Nan::ThrowError("first argument (hash) must be a hash returned by cv.perceptualHash or an array of them");
+      return;
+    }
+
+    if (info[0]->IsArray()) {
+      if (!info[1]->IsArray() || info[1].As<v8::Array>()->Length() != hashes.size()) {
+        Nan::ThrowError("second argument (id) must be an array of numbers with one id per hash");
+        return;
+      }
+
+      auto arr = info[1].As<v8::Array>();
+
+      for (unsigned i = 0; i < arr->Length(); ++i) {
+        auto id = Nan::Get(arr, i).ToLocalChecked();
+
+        if (!id->IsNumber()) {
+          Nan::ThrowError("second argument (id) must be an array of numbers with one id per hash");
+          return;
+        }
+
+        ids.push_back(Nan::To<double>(id).FromJust());
+      }
+    } else if (info[1]->IsNumber()) {
+      ids.push_back(Nan::To<double>(info[1]).FromJust());
+    } else {
+      Nan::ThrowError("second argument (id) must be a number");
+      return;
+    }
+
+    if (info.Length() == 3 && !info[2]->IsFunction()) {
+      Nan::ThrowError("third argument (callback) must be a function");
+      return;
+    }
+
+    maybeAsyncOp<int>(info, [data, hashes, ids]() {
+      std::lock_guard<std::mutex> lock(data->mutex);
+
+      for (size_t i = 0; i < hashes.size(); ++i) {
+        data->tree.add(hashes[i], ids[i]);
+      }
+
+      return 0;
+    }, [](const int&) {
+      return Nan::Null();
+    });
+  }
+
+  /**
+   * query(hash, maxDistance)
+   * query(hash, maxDistance, callback)
+   * query([hash, ...], maxDistance)
+   * query([hash, ...], maxDistance, callback)
+   */
+  static NAN_METHOD(query) {
+    auto data = Nan::ObjectWrap::Unwrap<HashIndex>(info.Holder())->data;
+
+    if (info.Length() < 2 || info.Length() > 3) {
+      Nan::ThrowError("expected at least two arguments (hash, maxDistance) and at most three arguments (hash, maxDistance, callback)");
+      return;
+    }
+
+    std::vector<uint64_t> hashes;
+
+    if (!getHashes(info[0], hashes)) {
+      Nan::ThrowError("first argument (hash) must be a hash returned by cv.perceptualHash or an array of them");
+      return;
+    }
+
+    if (!info[1]->IsInt32() || Nan::To<int>(info[1]).FromJust() < 0) {
+      Nan::ThrowError("second argument (maxDistance) must be a non-negative integer");
+      return;
+    }
+
+    if (info.Length() == 3 && !info[2]->IsFunction()) {
+      Nan::ThrowError("third argument (callback) must be a function");
+      return;
+    }
+
+    auto batch = info[0]->IsArray();
+    auto maxDistance = Nan::To<int>(info[1]).FromJust();
+
+    maybeAsyncOp<std::vector<std::vector<HashMatch>>>(info, [data, hashes, maxDistance]() {
+      std::lock_guard<std::mutex> lock(data->mutex);
+      std::vector<std::vector<HashMatch>> results;
+
+      for (auto hash : hashes) {
+        results.push_back(data->tree.query(hash, maxDistance));
+      }
+
+      return results;
+    }, [batch](const std::vector<std::vector<HashMatch>>& results) -> v8::Local<v8::Value> {
+      auto arr = Nan::New<v8::Array>(results.size());
+
+      for (unsigned i = 0; i < results.size(); ++i) {
+        Nan::Set(arr, i, matchesToArray(results[i]));
+      }
+
+      if (batch) {
+        return arr;
+      }
+
+      return Nan::Get(arr, 0).ToLocalChecked();
+    });
+  }
+
+  static v8::Local<v8::Array> matchesToArray(const std::vector<HashMatch>& matches) {
+    Nan::EscapableHandleScope scope;
+    auto arr = Nan::New<v8::Array>(matches.size());
+
+    for (unsigned i = 0; i < matches.size(); ++i) {
+      auto obj = Nan::New<v8::Object>();
+
+      Nan::Set(obj, Nan::New("id").ToLocalChecked(), Nan::New(matches[i].id));
+      Nan::Set(obj, Nan::New("hash").ToLocalChecked(), Nan::New(formatHash(matches[i].hash)).ToLocalChecked());
+      Nan::Set(obj, Nan::New("distance").ToLocalChecked(), Nan::New(matches[i].distance));
+
+      Nan::Set(arr, i, obj);
+    }
+
+    return scope.Escape(arr);
+  }
+
+  std::shared_ptr<HashIndexData> data;
+};
+
+#endif // SIMPLE_CV_HASH_INDEX_H
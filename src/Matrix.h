@@ -7,6 +7,78 @@
 #include "constants.h"
 #include "utils.h"
 #include "async.h"
+#include "sharedMatrix.h"
+
+struct BlitTile {
+  cv::Mat source;
+  cv::Rect rect;
+};
+
+/**
+ * Resizes (if needed) and copies tiles whose destination rects don't overlap.
+ */
+class BlitBody : public cv::ParallelLoopBody {
+
+public:
+
+  BlitBody(cv::Mat& target, const std::vector<BlitTile>& tiles, const std::vector<size_t>& indices)
+    : target(target)
+    , tiles(tiles)
+    , indices(indices) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    for (int i = range.start; i < range.end; ++i) {
+      auto& tile = tiles[indices[i]];
+      cv::Mat dst = target(tile.rect);
+
+      if (tile.source.size() == tile.rect.size()) {
+        tile.source.copyTo(dst);
+      } else {
+        auto shrink = tile.source.cols > tile.rect.width || tile.source.rows > tile.rect.height;
+        cv::resize(tile.source, dst, tile.rect.size(), 0, 0, shrink ? cv::INTER_AREA : cv::INTER_CUBIC);
+      }
+    }
+  }
+
+private:
+
+  cv::Mat& target;
+  const std::vector<BlitTile>& tiles;
+  const std::vector<size_t>& indices;
+};
+
+/**
+ * Copies the tiles in order so that later tiles are drawn over earlier ones. Each tile is
+ * put in the first group after all groups containing earlier tiles it overlaps. The tiles
+ * of a group don't overlap and are copied in parallel.
+ */
+void blitTiles(cv::Mat target, const std::vector<BlitTile>& tiles) {
+  std::vector<std::vector<size_t>> groups;
+  std::vector<size_t> groupOf(tiles.size());
+
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    size_t group = 0;
+
+    for (size_t j = 0; j < i; ++j) {
+      if ((tiles[i].rect & tiles[j].rect).area() > 0) {
+        group = std::max(group, groupOf[j] + 1);
+      }
+    }
+
+    if (group == groups.size()) {
+      groups.push_back(std::vector<size_t>());
+    }
+
+    groups[group].push_back(i);
+    groupOf[i] = group;
+  }
+
+  for (auto& group : groups) {
+    BlitBody body(target, tiles, group);
+    cv::parallel_for_(cv::Range(0, static_cast<int>(group.size())), body);
+  }
+}
 
 class Matrix : public Nan::ObjectWrap {
 
@@ -21,15 +93,24 @@ public:
     Nan::SetPrototypeMethod(tpl, "toArray", toArray);
     Nan::SetPrototypeMethod(tpl, "toBuffers", toBuffers);
     Nan::SetPrototypeMethod(tpl, "toBuffer", toBuffer);
+    Nan::SetPrototypeMethod(tpl, "toTypedArray", toTypedArray);
+    Nan::SetPrototypeMethod(tpl, "convertTo", convertTo);
     Nan::SetPrototypeMethod(tpl, "crop", crop);
     Nan::SetPrototypeMethod(tpl, "set", set);
+    Nan::SetPrototypeMethod(tpl, "setMany", setMany);
     Nan::SetPrototypeMethod(tpl, "clone", clone);
     Nan::SetPrototypeMethod(tpl, "add", add);
     Nan::SetPrototypeMethod(tpl, "mul", mul);
+    Nan::SetPrototypeMethod(tpl, "share", share);
+    Nan::SetPrototypeMethod(tpl, "release", release);
+
+    Nan::SetMethod(tpl, "fromShared", fromShared);
+    Nan::SetMethod(tpl, "releaseShared", releaseShared);
 
     Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("height").ToLocalChecked(), getHeight);
     Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("width").ToLocalChecked(), getWidth);
     Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("type").ToLocalChecked(), getType);
+    Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("readOnly").ToLocalChecked(), getReadOnly);
 
     constructor().Reset(Nan::GetFunction(tpl).ToLocalChecked());
 
@@ -46,19 +127,18 @@ public:
     return scope.Escape(matrix);
   }
 
-  static v8::Local<v8::Object> create(cv::Mat data) {
+  static v8::Local<v8::Object> create(cv::Mat data, bool readOnly = false) {
     Nan::EscapableHandleScope scope;
 
-    if (data.type() != ImageTypeGray
-        && data.type() != ImageTypeFloat
-        && data.type() != ImageTypeBGR
-        && data.type() != ImageTypeBGRA) {
-
+    if (!isImageType(data.type())) {
       throw std::runtime_error("invalid image type");
     }
 
     auto matrix = Matrix::create();
-    Nan::ObjectWrap::Unwrap<Matrix>(matrix)->mat() = data;
+    auto wrapped = Nan::ObjectWrap::Unwrap<Matrix>(matrix);
+
+    wrapped->mat() = data;
+    wrapped->_readOnly = readOnly;
 
     return scope.Escape(matrix);
   }
@@ -94,22 +174,73 @@ public:
     return Nan::ObjectWrap::Unwrap<Matrix>(value->ToObject())->mat();
   }
 
+  // Read-only matrices share their data with the image cache and must not be modified in-place.
+  static bool isReadOnly(v8::Local<v8::Value> value) {
+    return Nan::ObjectWrap::Unwrap<Matrix>(value->ToObject())->_readOnly;
+  }
+
+  // Returns the matrix for in-place modification. See `writableMat`.
+  static cv::Mat getWritable(v8::Local<v8::Value> value) {
+    return Nan::ObjectWrap::Unwrap<Matrix>(value->ToObject())->writableMat();
+  }
+
   cv::Mat& mat() {
     return _mat;
   }
 
+  /**
+   * Reports the pixel data of `matrix` to V8 as external memory so that the garbage
+   * collector runs often enough when lots of large matrices are created outside the
+   * JS heap. The memory is given back when the matrix is released or collected.
+   */
+  static void trackExternalMemory(v8::Local<v8::Object> matrix) {
+    auto wrapped = Nan::ObjectWrap::Unwrap<Matrix>(matrix);
+
+    wrapped->untrackExternalMemory();
+    wrapped->_externalMemory = static_cast<int64_t>(wrapped->_mat.total() * wrapped->_mat.elemSize());
+    Nan::AdjustExternalMemory(wrapped->_externalMemory);
+  }
+
+  /**
+   * Crop views and their parents are copy-on-write: they share the pixel data until one
+   * of them is modified in-place. The modified one gets its own copy first unless it's
+   * the only remaining owner of the data. Must be called before taking other references
+   * to `_mat` since those also count as owners.
+   */
+  cv::Mat& writableMat() {
+    if (_cow && (!_mat.u || _mat.u->refcount > 1)) {
+      _mat = _mat.clone();
+    }
+
+    _cow = false;
+    return _mat;
+  }
+
 private:
 
   Matrix()
-    : _mat() {
+    : _mat()
+    , _readOnly(false)
+    , _cow(false)
+    , _externalMemory(0) {
   }
 
   Matrix(int width, int height, int type = ImageTypeGray)
-    : _mat(height, width, type) {
+    : _mat(height, width, type)
+    , _readOnly(false)
+    , _cow(false)
+    , _externalMemory(0) {
   }
 
   ~Matrix() {
-    // Nothing to do here.
+    untrackExternalMemory();
+  }
+
+  void untrackExternalMemory() {
+    if (_externalMemory != 0) {
+      Nan::AdjustExternalMemory(-_externalMemory);
+      _externalMemory = 0;
+    }
   }
 
   static NAN_METHOD(New) {
@@ -208,8 +339,8 @@ private:
         type = ::get<int>(args, "type");
       }
 
-      if (type != ImageTypeGray && type != ImageTypeBGR && type != ImageTypeFloat) {
-        Nan::ThrowError("type must be one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.Float]");
+      if (!isImageType(type)) {
+        Nan::ThrowError((std::string("type must be one of ") + ImageTypeNames).c_str());
         return;
       }
 
@@ -241,20 +372,9 @@ private:
             return;
           }
 
-          if (type == ImageTypeFloat) {
-            mat.at<double>(i) = Nan::To<double>(item).FromJust();
-          } else if (type == ImageTypeGray) {
-            mat.at<uchar>(i) = static_cast<uchar>(Nan::To<int>(item).FromJust());
-          } else if (type == ImageTypeBGR) {
-            auto blue = Nan::Get(data, i).ToLocalChecked();
-            auto green = Nan::Get(data, i + size).ToLocalChecked();
-            auto red = Nan::Get(data, i + 2 * size).ToLocalChecked();
-
-            mat.at<cv::Vec3b>(i) = cv::Vec3b(
-              static_cast<uchar>(Nan::To<int>(blue).FromJust()),
-              static_cast<uchar>(Nan::To<int>(green).FromJust()),
-              static_cast<uchar>(Nan::To<int>(red).FromJust())
-            );
+          // The data is given one channel at a time: all blue values first, then green and so on.
+          for (int c = 0; c < mat.channels(); ++c) {
+            setElement(mat, i, c, Nan::Get(data, i + c * size).ToLocalChecked());
           }
         }
       }
@@ -274,17 +394,12 @@ private:
       }
 
       if (info.Length() > 2) {
-        if (!info[2]->IsInt32()) {
-          Nan::ThrowError("the third argument (type) must be one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA, cv.ImageType.Float]");
+        if (!info[2]->IsInt32() || !isImageType(Nan::To<int>(info[2]).FromJust())) {
+          Nan::ThrowError((std::string("the third argument (type) must be one of ") + ImageTypeNames).c_str());
           return;
         }
 
         type = Nan::To<int>(info[2]).FromJust();
-
-        if (type != ImageTypeGray && type != ImageTypeBGR && type != ImageTypeBGRA && type != ImageTypeFloat) {
-          Nan::ThrowError("the third argument (type) must be one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.Float]");
-          return;
-        }
       }
 
       Matrix *matrix = new Matrix(width, height, type);
@@ -311,24 +426,21 @@ private:
     info.GetReturnValue().Set(Nan::New(mat->_mat.type()));
   }
 
+  static NAN_GETTER(getReadOnly) {
+    Matrix* mat = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder());
+    info.GetReturnValue().Set(Nan::New(mat->_readOnly));
+  }
+
   static NAN_METHOD(toArray) {
     Matrix* mat = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder());
 
     auto self = mat->mat();
-    auto type = self.type();
     auto size = self.cols * self.rows;
-    auto arr = v8::Array::New(info.GetIsolate(), static_cast<int>(self.total()));
+    auto arr = v8::Array::New(info.GetIsolate(), static_cast<int>(self.total() * self.channels()));
 
     for (int c = 0; c < self.channels(); ++c) {
       for (int i = 0; i < size; ++i) {
-        if (type == ImageTypeFloat) {
-          Nan::Set(arr, i, Nan::New(self.at<double>(i)));
-        } else if (type == ImageTypeGray) {
-          Nan::Set(arr, i, Nan::New(self.at<uchar>(i)));
-        } else {
-          auto pixel = self.at<cv::Vec3b>(i);
-          Nan::Set(arr, c * size + i, Nan::New(pixel[c]));
-        }
+        Nan::Set(arr, c * size + i, Nan::New(getElement(self, i, c)));
       }
     }
 
@@ -336,7 +448,7 @@ private:
   }
 
   static NAN_METHOD(toBuffers) {
-    cv::Mat self = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder())->mat();
+    cv::Mat self = continuous(Nan::ObjectWrap::Unwrap<Matrix>(info.Holder())->mat());
     v8::Local<v8::Value> ret;
 
     auto size = static_cast<unsigned>(self.total());
@@ -443,6 +555,24 @@ private:
         Nan::Set(arr, 2, redChannel);
         Nan::Set(arr, 3, alphaChannel);
 
+        ret = arr;
+      } else {
+        std::vector<cv::Mat> channels;
+        cv::split(self, channels);
+
+        auto arr = Nan::New<v8::Array>(channels.size());
+
+        for (unsigned c = 0; c < channels.size(); ++c) {
+          auto obj = Nan::New<v8::Object>();
+          auto bytes = static_cast<unsigned>(channels[c].total() * channels[c].elemSize());
+          auto buffer = Nan::CopyBuffer(reinterpret_cast<char *>(channels[c].data), bytes).ToLocalChecked();
+
+          Nan::Set(obj, Nan::New("data").ToLocalChecked(), buffer);
+          Nan::Set(obj, Nan::New("channel").ToLocalChecked(), Nan::New(channelId(self, c)));
+
+          Nan::Set(arr, c, obj);
+        }
+
         ret = arr;
       }
 
@@ -453,22 +583,107 @@ private:
   }
 
   static NAN_METHOD(toBuffer) {
-    cv::Mat self = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder())->mat();
+    cv::Mat self = continuous(Nan::ObjectWrap::Unwrap<Matrix>(info.Holder())->mat());
 
-    auto size = static_cast<unsigned>(self.total() * self.channels());
+    auto size = static_cast<unsigned>(self.total() * self.elemSize());
     auto data = reinterpret_cast<char *>(self.data);
     auto buffer = Nan::CopyBuffer(data, size).ToLocalChecked();
 
     info.GetReturnValue().Set(buffer);
   }
 
+  /**
+   * Copies the pixels into a typed array that matches the depth of the matrix:
+   * Uint8Array, Uint16Array, Float32Array or Float64Array. The channels are
+   * interleaved like in `toBuffer`.
+   */
+  static NAN_METHOD(toTypedArray) {
+    cv::Mat self = continuous(Nan::ObjectWrap::Unwrap<Matrix>(info.Holder())->mat());
+
+    auto length = self.total() * self.channels();
+
+    try {
+      switch (self.depth()) {
+        case CV_16U:
+          info.GetReturnValue().Set(newTypedArray<v8::Uint16Array>(self.ptr<ushort>(), length));
+          break;
+        case CV_32F:
+          info.GetReturnValue().Set(newTypedArray<v8::Float32Array>(self.ptr<float>(), length));
+          break;
+        case CV_64F:
+          info.GetReturnValue().Set(newTypedArray<v8::Float64Array>(self.ptr<double>(), length));
+          break;
+        default:
+          info.GetReturnValue().Set(newTypedArray<v8::Uint8Array>(self.ptr<uchar>(), length));
+          break;
+      }
+    } catch (std::exception& err) {
+      Nan::ThrowError(err.what());
+    }
+  }
+
+  /**
+   * convertTo(type)
+   * convertTo(type, callback)
+   * convertTo(type, {scale?, offset?})
+   * convertTo(type, {scale?, offset?}, callback)
+   */
+  static NAN_METHOD(convertTo) {
+    cv::Mat self = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder())->mat();
+
+    if (info.Length() < 1 || info.Length() > 3) {
+      Nan::ThrowError("expected at least one argument (type) and at most three arguments (type, opt, callback)");
+      return;
+    }
+
+    if (!info[0]->IsInt32() || !isImageType(Nan::To<int>(info[0]).FromJust())) {
+      Nan::ThrowError((std::string("first argument (type) must be one of ") + ImageTypeNames).c_str());
+      return;
+    }
+
+    auto type = Nan::To<int>(info[0]).FromJust();
+    auto scale = 1.0;
+    auto offset = 0.0;
+
+    if (CV_MAT_CN(type) != self.channels()) {
+      Nan::ThrowError("first argument (type) must have the same number of channels as the matrix. Use convertColor to change the number of channels");
+      return;
+    }
+
+    if (info.Length() >= 2 && info[1]->IsObject() && !info[1]->IsFunction()) {
+      auto opt = info[1];
+
+      if (has(opt, "scale")) {
+        scale = get<double>(opt, "scale");
+      }
+
+      if (has(opt, "offset")) {
+        offset = get<double>(opt, "offset");
+      }
+    }
+
+    maybeAsyncOp<cv::Mat>(info, [self, type, scale, offset]() {
+      cv::Mat output;
+      self.convertTo(output, type, scale, offset);
+      return output;
+    }, [](const cv::Mat& result) {
+      return Matrix::create(result);
+    });
+  }
+
   static NAN_METHOD(clone) {
     Matrix* mat = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder());
     info.GetReturnValue().Set(Matrix::create(mat->mat().clone()));
   }
 
   static NAN_METHOD(set) {
-    cv::Mat self = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder())->mat();
+    auto matrix = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder());
+    const cv::Mat& self = matrix->mat();
+
+    if (Matrix::isReadOnly(info.Holder())) {
+      Nan::ThrowError("the matrix is read-only");
+      return;
+    }
 
     if (info.Length() < 2 || info.Length() > 3) {
       Nan::ThrowError("expected at least two argument (matrix, point) and at most three arguments (matrix, point, callback)");
@@ -510,19 +725,107 @@ private:
       return;
     }
 
-    maybeAsyncOp<int>(info, [self, mat, x, y, w, h]() {
-      mat.copyTo(self(cv::Rect(x, y, w, h)));
+    cv::Mat target = matrix->writableMat();
+
+    maybeAsyncOp<int>(info, [target, mat, x, y, w, h]() {
+      mat.copyTo(target(cv::Rect(x, y, w, h)));
       return 0;
     }, [](const int&) {
       return Nan::Null();
     });
   }
 
-  static NAN_METHOD(crop) {
-    cv::Mat self = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder())->mat();
+  /**
+   * setMany([{source, x, y, width?, height?}, ...])
+   * setMany([{source, x, y, width?, height?}, ...], callback)
+   */
+  static NAN_METHOD(setMany) {
+    auto matrix = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder());
+    const cv::Mat& self = matrix->mat();
+
+    if (Matrix::isReadOnly(info.Holder())) {
+      Nan::ThrowError("the matrix is read-only");
+      return;
+    }
 
     if (info.Length() < 1 || info.Length() > 2) {
-      Nan::ThrowError("expected at least one argument (rect) and at most two arguments (rect, callback)");
+      Nan::ThrowError("expected at least one argument (tiles) and at most two arguments (tiles, callback)");
+      return;
+    }
+
+    if (!info[0]->IsArray()) {
+      Nan::ThrowError("first argument (tiles) must be an array of {source, x, y, width?, height?} objects");
+      return;
+    }
+
+    if (info.Length() == 2 && !info[1]->IsFunction()) {
+      Nan::ThrowError("second argument (callback) must be a function");
+      return;
+    }
+
+    auto arr = info[0].As<v8::Array>();
+    std::vector<BlitTile> tiles;
+
+    for (unsigned i = 0; i < arr->Length(); ++i) {
+      auto value = Nan::Get(arr, i).ToLocalChecked();
+
+      if (!value->IsObject() || !has(value, "source") || !Matrix::isMatrix(getValue(value, "source")) || !isPoint(value)) {
+        Nan::ThrowError("first argument (tiles) must be an array of {source, x, y, width?, height?} objects");
+        return;
+      }
+
+      BlitTile tile;
+      tile.source = Matrix::get(getValue(value, "source"));
+      tile.rect = cv::Rect(getPoint<int>(value), tile.source.size());
+
+      if (has(value, "width")) {
+        tile.rect.width = get<int>(value, "width");
+      }
+
+      if (has(value, "height")) {
+        tile.rect.height = get<int>(value, "height");
+      }
+
+      if (tile.source.type() != self.type()) {
+        Nan::ThrowError("the type of source matrix must be the same as the target matrix");
+        return;
+      }
+
+      auto& r = tile.rect;
+
+      if (!isInside(r, self.size())) {
+        std::ostringstream msg;
+        msg << "tiles[" << i << "] (x=" << r.x << ".." << (static_cast<int64_t>(r.x) + r.width) << ", y=" << r.y << ".." << (static_cast<int64_t>(r.y) + r.height) << ") goes outside the matrix bounds (w=" << self.cols << ", h=" << self.rows << ")";
+        Nan::ThrowError(msg.str().c_str());
+        return;
+      }
+
+      tiles.push_back(tile);
+    }
+
+    cv::Mat target = matrix->writableMat();
+
+    maybeAsyncOp<int>(info, [target, tiles]() {
+      blitTiles(target, tiles);
+      return 0;
+    }, [](const int&) {
+      return Nan::Null();
+    });
+  }
+
+  /**
+   * crop(rect)
+   * crop(rect, callback)
+   * crop(rect, {view?})
+   * crop(rect, {view?}, callback)
+   */
+  static NAN_METHOD(crop) {
+    auto matrix = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder());
+    cv::Mat self = matrix->mat();
+    auto view = false;
+
+    if (info.Length() < 1 || info.Length() > 3) {
+      Nan::ThrowError("expected at least one argument (rect) and at most three arguments (rect, opt, callback)");
       return;
     }
 
@@ -533,11 +836,20 @@ private:
       return;
     }
 
-    if (info.Length() == 2 && !info[1]->IsFunction()) {
+    if (info.Length() >= 2 && info[1]->IsObject() && !info[1]->IsFunction()) {
+      if (has(info[1], "view")) {
+        view = get<bool>(info[1], "view");
+      }
+    } else if (info.Length() == 2 && !info[1]->IsFunction()) {
       Nan::ThrowError("second argument (callback) must be a function");
       return;
     }
 
+    if (info.Length() == 3 && !info[2]->IsFunction()) {
+      Nan::ThrowError("third argument (callback) must be a function");
+      return;
+    }
+
     int matWidth = self.size().width;
     int matHeight = self.size().height;
 
@@ -554,15 +866,34 @@ private:
       return;
     }
 
-    maybeAsyncOp<cv::Mat>(info, [self, cropRect]() {
+    if (view && self.u) {
+      // Matrices without a reference count (external data) can't tell if they are shared
+      // so only the view is made copy-on-write.
+      matrix->_cow = true;
+    }
+
+    maybeAsyncOp<cv::Mat>(info, [self, cropRect, view]() {
+      if (view) {
+        // The ROI header keeps the parent's data alive.
+        return self(cropRect);
+      }
+
       return self(cropRect).clone();
-    }, [](const cv::Mat& result) {
-      return Matrix::create(result);
+    }, [view](const cv::Mat& result) {
+      auto cropped = Matrix::create(result);
+      Nan::ObjectWrap::Unwrap<Matrix>(cropped)->_cow = view;
+      return cropped;
     });
   }
 
   static NAN_METHOD(add) {
-    cv::Mat self = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder())->mat();
+    auto matrix = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder());
+    const cv::Mat& self = matrix->mat();
+
+    if (Matrix::isReadOnly(info.Holder())) {
+      Nan::ThrowError("the matrix is read-only");
+      return;
+    }
 
     if (info.Length() < 1 || info.Length() > 2) {
       Nan::ThrowError("expected at least one argument (matrix|color|number) and at most two arguments (matrix|color|number, callback)");
@@ -594,13 +925,15 @@ private:
       return;
     }
 
-    maybeAsyncOp<int>(info, [self, argType, numberArg, matArg, colorArg]() {
+    cv::Mat target = matrix->writableMat();
+
+    maybeAsyncOp<int>(info, [target, argType, numberArg, matArg, colorArg]() {
       if (argType == 0) {
-        self += matArg;
+        target += matArg;
       } else if (argType == 1) {
-        self += numberArg;
+        target += numberArg;
       } else {
-        self += colorArg;
+        target += colorArg;
       }
 
       return 0;
@@ -610,7 +943,13 @@ private:
   }
 
   static NAN_METHOD(mul) {
-    cv::Mat self = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder())->mat();
+    auto matrix = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder());
+    const cv::Mat& self = matrix->mat();
+
+    if (Matrix::isReadOnly(info.Holder())) {
+      Nan::ThrowError("the matrix is read-only");
+      return;
+    }
 
     if (info.Length() < 1 || info.Length() > 2) {
       Nan::ThrowError("expected at least one argument (matrix|color|number) and at most two arguments (matrix|color|number, callback)");
@@ -642,13 +981,15 @@ private:
       return;
     }
 
-    maybeAsyncOp<int>(info, [self, argType, numberArg, matArg, colorArg]() {
+    cv::Mat target = matrix->writableMat();
+
+    maybeAsyncOp<int>(info, [target, argType, numberArg, matArg, colorArg]() {
       if (argType == 0) {
-        cv::multiply(self, matArg, self);
+        cv::multiply(target, matArg, target);
       } else if (argType == 1) {
-        self *= numberArg;
+        target *= numberArg;
       } else {
-        cv::multiply(self, colorArg, self);
+        cv::multiply(target, colorArg, target);
       }
 
       return 0;
@@ -657,12 +998,128 @@ private:
     });
   }
 
+  static NAN_METHOD(share) {
+    auto matrix = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder());
+    // The receiver may modify the data so it can't be shared with crop views. Read-only
+    // matrices are shared as read-only so the image cache can't be modified through them.
+    cv::Mat self = matrix->_readOnly ? matrix->mat() : matrix->writableMat();
+    auto handle = Nan::New<v8::Object>();
+
+    Nan::Set(handle, Nan::New("id").ToLocalChecked(), Nan::New(SharedMatrices::put(self, matrix->_readOnly)));
+    Nan::Set(handle, Nan::New("width").ToLocalChecked(), Nan::New(self.cols));
+    Nan::Set(handle, Nan::New("height").ToLocalChecked(), Nan::New(self.rows));
+    Nan::Set(handle, Nan::New("type").ToLocalChecked(), Nan::New(self.type()));
+
+    info.GetReturnValue().Set(handle);
+  }
+
+  /**
+   * Drops the reference to the pixel data without waiting for the garbage collector,
+   * for example to return a video frame to the decoder's buffer pool. The matrix is
+   * empty afterwards. Other matrices that share the data are not affected.
+   */
+  static NAN_METHOD(release) {
+    auto matrix = Nan::ObjectWrap::Unwrap<Matrix>(info.Holder());
+
+    matrix->_mat = cv::Mat();
+    matrix->_cow = false;
+    matrix->untrackExternalMemory();
+  }
+
+  static NAN_METHOD(fromShared) {
+    if (info.Length() != 1 || !isSharedHandle(info[0])) {
+      Nan::ThrowError("expected one argument (handle) returned by Matrix.share()");
+      return;
+    }
+
+    cv::Mat mat;
+    bool readOnly = false;
+
+    if (!SharedMatrices::take(::get<uint32_t>(info[0], "id"), mat, readOnly)) {
+      Nan::ThrowError("the shared matrix handle has already been used or released");
+      return;
+    }
+
+    try {
+      info.GetReturnValue().Set(Matrix::create(mat, readOnly));
+    } catch (std::exception& err) {
+      Nan::ThrowError(err.what());
+    }
+  }
+
+  static NAN_METHOD(releaseShared) {
+    if (info.Length() != 1 || !isSharedHandle(info[0])) {
+      Nan::ThrowError("expected one argument (handle) returned by Matrix.share()");
+      return;
+    }
+
+    info.GetReturnValue().Set(Nan::New(SharedMatrices::release(::get<uint32_t>(info[0], "id"))));
+  }
+
+  static cv::Mat continuous(const cv::Mat& mat) {
+    return mat.isContinuous() ? mat : mat.clone();
+  }
+
+  // `i` is the index of the pixel in row-major order.
+  static double getElement(const cv::Mat& mat, int i, int c) {
+    auto index = (i % mat.cols) * mat.channels() + c;
+
+    switch (mat.depth()) {
+      case CV_8U:
+        return mat.ptr<uchar>(i / mat.cols)[index];
+      case CV_16U:
+        return mat.ptr<ushort>(i / mat.cols)[index];
+      case CV_32F:
+        return mat.ptr<float>(i / mat.cols)[index];
+      default:
+        return mat.ptr<double>(i / mat.cols)[index];
+    }
+  }
+
+  static void setElement(cv::Mat& mat, int i, int c, v8::Local<v8::Value> value) {
+    auto index = (i % mat.cols) * mat.channels() + c;
+
+    switch (mat.depth()) {
+      case CV_8U:
+        mat.ptr<uchar>(i / mat.cols)[index] = static_cast<uchar>(Nan::To<int>(value).FromJust());
+        break;
+      case CV_16U:
+        mat.ptr<ushort>(i / mat.cols)[index] = static_cast<ushort>(Nan::To<int>(value).FromJust());
+        break;
+      case CV_32F:
+        mat.ptr<float>(i / mat.cols)[index] = static_cast<float>(Nan::To<double>(value).FromJust());
+        break;
+      default:
+        mat.ptr<double>(i / mat.cols)[index] = Nan::To<double>(value).FromJust();
+        break;
+    }
+  }
+
+  static int channelId(const cv::Mat& mat, int c) {
+    static const int colorChannels[] = { ChannelBlue, ChannelGreen, ChannelRed, ChannelAlpha };
+
+    if (mat.channels() == 1) {
+      return mat.depth() == CV_32F || mat.depth() == CV_64F ? ChannelFloat : ChannelGray;
+    }
+
+    return colorChannels[c];
+  }
+
+  static bool isSharedHandle(v8::Local<v8::Value> val) {
+    Nan::HandleScope scope;
+    return val->IsObject() && has(val, "id") && getValue(val, "id")->IsUint32();
+  }
+
+  // Each worker thread has its own isolate and thus needs its own constructor.
   static inline Nan::Persistent<v8::Function>& constructor() {
-    static Nan::Persistent<v8::Function> constructor;
+    static thread_local Nan::Persistent<v8::Function> constructor;
     return constructor;
   }
 
   cv::Mat _mat;
+  bool _readOnly;
+  bool _cow;
+  int64_t _externalMemory;
 };
 
 
@@ -0,0 +1,379 @@
+#ifndef SIMPLE_CV_TRANSFORM_H
+#define SIMPLE_CV_TRANSFORM_H
+
+#include <nan.h>
+#include <opencv2/opencv.hpp>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include "Matrix.h"
+#include "async.h"
+#include "utils.h"
+#include "warpAffine.h"
+
+/**
+ * An affine transformation built from a chain of geometric operations. The operations are
+ * multiplied into a single 3x3 matrix as they are added, so applying the whole chain costs
+ * one resampling pass no matter how many operations it has.
+ */
+class Transform : public Nan::ObjectWrap {
+
+public:
+
+  static NAN_MODULE_INIT(init) {
+    v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+
+    tpl->SetClassName(Nan::New("__NativeTransform").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    Nan::SetPrototypeMethod(tpl, "scale", scale);
+    Nan::SetPrototypeMethod(tpl, "rotate", rotate);
+    Nan::SetPrototypeMethod(tpl, "translate", translate);
+    Nan::SetPrototypeMethod(tpl, "flipLeftRight", flipLeftRight);
+    Nan::SetPrototypeMethod(tpl, "flipUpDown", flipUpDown);
+    Nan::SetPrototypeMethod(tpl, "compose", compose);
+    Nan::SetPrototypeMethod(tpl, "invert", invert);
+    Nan::SetPrototypeMethod(tpl, "toMatrix", toMatrix);
+    Nan::SetPrototypeMethod(tpl, "apply", apply);
+
+    auto function = Nan::GetFunction(tpl).ToLocalChecked();
+    constructor().Reset(function);
+
+    Nan::Set(target, Nan::New("Transform").ToLocalChecked(), function);
+  }
+
+  static bool isTransform(v8::Local<v8::Value> val) {
+    Nan::HandleScope scope;
+
+    if (!val->IsObject()) {
+      return false;
+    }
+
+    auto obj = val->ToObject();
+
+    if (obj->InternalFieldCount() != 1) {
+      return false;
+    }
+
+    auto constructor = Nan::New(Transform::constructor());
+    return constructor->GetName() == obj->GetConstructorName();
+  }
+
+private:
+
+  Transform()
+    : matrix(cv::Matx33d::eye()) {
+  }
+
+  ~Transform() {
+    // Nothing to do here.
+  }
+
+  /**
+   * new Transform()
+   * new Transform(matrix)
+   */
+  static NAN_METHOD(New) {
+    if (!info.IsConstructCall()) {
+      Nan::ThrowError("Class constructor Transform cannot be invoked without 'new'");
+      return;
+    }
+
+    auto transform = new Transform();
+
+    if (info.Length() >= 1 && !info[0]->IsUndefined()) {
+      if (!Matrix::isMatrix(info[0]) || !isAffineTransformation(Matrix::get(info[0]))) {
+        delete transform;
+        Nan::ThrowError("first argument (matrix) must be a 3x2 float matrix");
+        return;
+      }
+
+      transform->matrix = toMatx33(Matrix::get(info[0]));
+    }
+
+    transform->Wrap(info.This());
+    info.GetReturnValue().Set(info.This());
+  }
+
+  static cv::Matx33d toMatx33(const cv::Mat& affine) {
+    auto m = cv::Matx33d::eye();
+
+    for (int row = 0; row < 2; ++row) {
+      for (int col = 0; col < 3; ++col) {
+        m(row, col) = affine.at<double>(row, col);
+      }
+    }
+
+    return m;
+  }
+
+  /**
+   * Appends `op` to the chain. It is applied after the operations added so far.
+   */
+  static void append(v8::Local<v8::Object> holder, const cv::Matx33d& op) {
+    auto transform = Nan::ObjectWrap::Unwrap<Transform>(holder);
+    transform->matrix = op * transform->matrix;
+  }
+
+  /**
+   * scale(scale)
+   * scale(scaleX, scaleY)
+   */
+  static NAN_METHOD(scale) {
+    if (info.Length() < 1 || info.Length() > 2 || !info[0]->IsNumber() || (info.Length() == 2 && !info[1]->IsNumber())) {
+      Nan::ThrowError("expected one or two number arguments (scaleX, scaleY)");
+      return;
+    }
+
+    auto sx = Nan::To<double>(info[0]).FromJust();
+    auto sy = info.Length() == 2 ? Nan::To<double>(info[1]).FromJust() : sx;
+
+    if (!std::isfinite(sx) || !std::isfinite(sy)) {
+      Nan::ThrowError("scaleX and scaleY must be finite numbers");
+      return;
+    }
+
+    append(info.Holder(), cv::Matx33d(
+      sx, 0, 0,
+      0, sy, 0,
+      0, 0, 1
+    ));
+  }
+
+  /**
+   * rotate(angle)
+   * rotate(angle, center)
+   *
+   * Rotates counterclockwise by `angle` degrees like `rotationMatrix`.
+   */
+  static NAN_METHOD(rotate) {
+    if (info.Length() < 1 || info.Length() > 2 || !info[0]->IsNumber()) {
+      Nan::ThrowError("first argument (angle) must be a number");
+      return;
+    }
+
+    auto angle = Nan::To<double>(info[0]).FromJust();
+
+    if (!std::isfinite(angle)) {
+      Nan::ThrowError("first argument (angle) must be a finite number");
+      return;
+    }
+
+    cv::Point2d center(0, 0);
+
+    if (info.Length() == 2) {
+      if (!isPoint(info[1])) {
+        Nan::ThrowError("second argument (center) must be a Point {x, y}");
+        return;
+      }
+
+      center = getPoint<double>(info[1]);
+    }
+
+    cv::Mat rotation = cv::getRotationMatrix2D(center, angle, 1.0);
+    append(info.Holder(), toMatx33(rotation));
+  }
+
+  /**
+   * translate(x, y)
+   */
+  static NAN_METHOD(translate) {
+    if (info.Length() != 2 || !info[0]->IsNumber() || !info[1]->IsNumber()) {
+      Nan::ThrowError("expected two number arguments (x, y)");
+      return;
+    }
+
+    auto x = Nan::To<double>(info[0]).FromJust();
+    auto y = Nan::To<double>(info[1]).FromJust();
+
+    if (!std::isfinite(x) || !std::isfinite(y)) {
+      Nan::ThrowError("x and y must be finite numbers");
+      return;
+    }
+
+    append(info.Holder(), cv::Matx33d(
+      1, 0, x,
+      0, 1, y,
+      0, 0, 1
+    ));
+  }
+
+  /**
+   * Mirrors the x coordinates around zero. `apply` moves the result back into view.
+   */
+  static NAN_METHOD(flipLeftRight) {
+    append(info.Holder(), cv::Matx33d(
+      -1, 0, 0,
+      0, 1, 0,
+      0, 0, 1
+    ));
+  }
+
+  /**
+   * Mirrors the y coordinates around zero. `apply` moves the result back into view.
+   */
+  static NAN_METHOD(flipUpDown) {
+    append(info.Holder(), cv::Matx33d(
+      1, 0, 0,
+      0, -1, 0,
+      0, 0, 1
+    ));
+  }
+
+  /**
+   * compose(transform)
+   * compose(matrix)
+   *
+   * Appends another transformation. It is applied after the operations added so far.
+   */
+  static NAN_METHOD(compose) {
+    if (info.Length() == 1 && isTransform(info[0])) {
+      append(info.Holder(), Nan::ObjectWrap::Unwrap<Transform>(info[0]->ToObject())->matrix);
+    } else if (info.Length() == 1 && Matrix::isMatrix(info[0]) && isAffineTransformation(Matrix::get(info[0]))) {
+      append(info.Holder(), toMatx33(Matrix::get(info[0])));
+    } else {
+      Nan::ThrowError("first argument (transform) must be a Transform or a 3x2 float matrix");
+    }
+  }
+
+  static NAN_METHOD(invert) {
+    auto transform = Nan::ObjectWrap::Unwrap<Transform>(info.Holder());
+    auto invertible = false;
+    auto inverse = transform->matrix.inv(cv::DECOMP_LU, &invertible);
+
+    if (!invertible) {
+      Nan::ThrowError("the transformation is not invertible");
+      return;
+    }
+
+    transform->matrix = inverse;
+  }
+
+  /**
+   * Returns the transformation as a 3x2 float matrix that can be passed to `warpAffine`.
+   */
+  static NAN_METHOD(toMatrix) {
+    auto transform = Nan::ObjectWrap::Unwrap<Transform>(info.Holder());
+    info.GetReturnValue().Set(Matrix::create(transform->affine()));
+  }
+
+  /**
+   * apply(image)
+   * apply(image, callback)
+   * apply(image, {size?, interpolation?, borderType?, borderValue?})
+   * apply(image, {size?, interpolation?, borderType?, borderValue?}, callback)
+   *
+   * Without `size` the output is the bounding box of the transformed image.
+   */
+  static NAN_METHOD(apply) {
+    auto transform = Nan::ObjectWrap::Unwrap<Transform>(info.Holder());
+
+    if (info.Length() < 1 || info.Length() > 3) {
+      Nan::ThrowError("expected at least one argument (image) and at most three arguments (image, opt, callback)");
+      return;
+    }
+
+    if (!Matrix::isMatrix(info[0])) {
+      Nan::ThrowError("first argument (image) must be a Matrix");
+      return;
+    }
+
+    cv::Mat image = Matrix::get(info[0]);
+    WarpOptions options;
+    cv::Size size;
+
+    if (info.Length() >= 2 && info[1]->IsObject() && !info[1]->IsFunction()) {
+      auto opt = info[1];
+      auto error = getWarpOptions(opt, options);
+
+      if (error) {
+        Nan::ThrowError(error);
+        return;
+      }
+
+      if (!getWarpSize(opt, "size", size)) {
+        Nan::ThrowError("size must be a size {width, height} with a positive width and height");
+        return;
+      }
+    }
+
+    cv::Mat trans = size.area() == 0 ? transform->fitted(image.size(), size) : transform->affine();
+
+    if (trans.empty()) {
+      Nan::ThrowError("the transformed image is too large, pass an explicit size");
+      return;
+    }
+
+    maybeAsyncOp<cv::Mat>(info, [image, trans, size, options]() {
+      cv::Mat output;
+      cv::warpAffine(image, output, trans, size, options.interpolation, options.borderType, options.borderValue);
+      return output;
+    }, [](const cv::Mat& result) {
+      return Matrix::create(result);
+    });
+  }
+
+  cv::Mat affine() const {
+    return cv::Mat(matrix).rowRange(0, 2).clone();
+  }
+
+  /**
+   * Returns the transformation followed by the translation that moves the bounding box
+   * of the transformed image to the origin, and sets `size` to the size of the box. The
+   * box is computed from the outer edges of the corner pixels so that, for example, a
+   * flip or a quarter turn maps pixels exactly onto pixels.
+   *
+   * Returns an empty matrix if the box isn't finite or has more than INT_MAX pixels.
+   */
+  cv::Mat fitted(cv::Size imageSize, cv::Size& size) const {
+    const double right = imageSize.width - 0.5;
+    const double bottom = imageSize.height - 0.5;
+    const cv::Vec3d corners[] = {
+      cv::Vec3d(-0.5, -0.5, 1),
+      cv::Vec3d(right, -0.5, 1),
+      cv::Vec3d(-0.5, bottom, 1),
+      cv::Vec3d(right, bottom, 1)
+    };
+
+    auto minX = DBL_MAX, minY = DBL_MAX;
+    auto maxX = -DBL_MAX, maxY = -DBL_MAX;
+
+    for (auto& corner : corners) {
+      auto p = matrix * corner;
+
+      minX = std::min(minX, p[0]);
+      minY = std::min(minY, p[1]);
+      maxX = std::max(maxX, p[0]);
+      maxY = std::max(maxY, p[1]);
+    }
+
+    // The epsilon keeps rounding errors of rotations from adding a row or column.
+    auto width = std::max(std::ceil(maxX - minX - 1e-6), 1.0);
+    auto height = std::max(std::ceil(maxY - minY - 1e-6), 1.0);
+
+    // Also false for NaN, which a composed matrix can contain.
+    if (!(width * height <= INT_MAX)) {
+      return cv::Mat();
+    }
+
+    size.width = static_cast<int>(width);
+    size.height = static_cast<int>(height);
+
+    cv::Matx33d shift(
+      1, 0, -0.5 - minX,
+      0, 1, -0.5 - minY,
+      0, 0, 1
+    );
+
+    return cv::Mat(shift * matrix).rowRange(0, 2).clone();
+  }
+
+  static inline Nan::Persistent<v8::Function>& constructor() {
+    static thread_local Nan::Persistent<v8::Function> constructor;
+    return constructor;
+  }
+
+  cv::Matx33d matrix;
+};
+
+#endif // SIMPLE_CV_TRANSFORM_H
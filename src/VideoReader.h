@@ -0,0 +1,447 @@
+#ifndef SIMPLE_CV_VIDEO_READER_H
+#define SIMPLE_CV_VIDEO_READER_H
+
+#include <nan.h>
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <functional>
+#include "Matrix.h"
+
+struct VideoSourceOptions {
+  int start = 0;
+  int end = -1;
+  int step = 1;
+  bool seek = false;
+  size_t queueSize = 4;
+  size_t poolSize = 0;
+};
+
+/**
+ * Decodes the frames of a video file on a background thread into a bounded queue.
+ *
+ * The frames are decoded into buffers from a pool. A buffer is reused once the pool
+ * holds the only reference to it, that is, when the `Matrix` that was handed out
+ * has been released or garbage collected. When all buffers are still in use a new one
+ * is allocated outside the pool so that JS code can keep as many frames as it wants.
+ *
+ * The listener is called on the decoder thread whenever a frame has been queued or
+ * the decoding has finished.
+ */
+class VideoSource {
+
+public:
+
+  VideoSource(const std::string& filePath, const VideoSourceOptions& options)
+    : options(options)
+    , index(options.start)
+    , finished(false)
+    , stopped(false) {
+
+    if (!capture.open(filePath)) {
+      throw std::runtime_error(std::string("could not open video file ") + "\"" + filePath + "\"");
+    }
+
+    width = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH));
+    height = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+    fps = capture.get(cv::CAP_PROP_FPS);
+    frameCount = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_COUNT));
+
+    if (options.start > 0) {
+      capture.set(cv::CAP_PROP_POS_FRAMES, options.start);
+    }
+
+    thread = std::thread(&VideoSource::run, this);
+  }
+
+  ~VideoSource() {
+    stop();
+  }
+
+  /**
+   * Blocks until the next frame has been decoded. Returns false at the end of the video.
+   */
+  bool next(cv::Mat& frame) {
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [this]() { return !frames.empty() || finished || stopped; });
+
+    return take(frame);
+  }
+
+  /**
+   * Like `next` but doesn't wait. Returns false if the next frame hasn't been decoded yet.
+   * `frame` is left empty at the end of the video.
+   */
+  bool tryNext(cv::Mat& frame) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (frames.empty() && !finished && !stopped) {
+      return false;
+    }
+
+    take(frame);
+    return true;
+  }
+
+  void setListener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->listener = listener;
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopped = true;
+      frames.clear();
+    }
+
+    notEmpty.notify_all();
+    notFull.notify_all();
+
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+
+  int width;
+  int height;
+  double fps;
+  int frameCount;
+
+private:
+
+  // Must be called with `mutex` locked.
+  bool take(cv::Mat& frame) {
+    if (!frames.empty()) {
+      frame = frames.front();
+      frames.pop_front();
+      notFull.notify_one();
+      return true;
+    }
+
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+
+    return false;
+  }
+
+  // Must be called with `mutex` locked.
+  void notifyListener() {
+    if (listener) {
+      listener();
+    }
+  }
+
+  void run() {
+    while (options.end < 0 || index < options.end) {
+      cv::Mat frame;
+      bool pooled = acquireBuffer(frame);
+
+      try {
+        if (!capture.read(frame)) {
+          break;
+        }
+      } catch (std::exception& err) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = err.what();
+        break;
+      }
+
+      if (!pooled && pool.size() < options.poolSize) {
+        pool.push_back(frame);
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]() { return frames.size() < options.queueSize || stopped; });
+
+        if (stopped) {
+          return;
+        }
+
+        frames.push_back(frame);
+        notifyListener();
+      }
+
+      notEmpty.notify_one();
+
+      if (!skip()) {
+        break;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      finished = true;
+      notifyListener();
+    }
+
+    notEmpty.notify_all();
+  }
+
+  // Moves past the frames between two returned frames. `grab` still decodes the
+  // frames but skips the conversion to BGR. Seeking lets the demuxer jump to the
+  // closest keyframe instead, which is faster for large steps.
+  bool skip() {
+    index += options.step;
+
+    if (options.step == 1) {
+      return true;
+    }
+
+    if (options.seek) {
+      return capture.set(cv::CAP_PROP_POS_FRAMES, index);
+    }
+
+    for (int i = 1; i < options.step; ++i) {
+      if (stopped || !capture.grab()) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // Only the decoder thread touches the pool. A buffer whose only reference is
+  // the pool can't be referenced again by anyone else, so the check is safe.
+  bool acquireBuffer(cv::Mat& frame) {
+    for (auto& buffer : pool) {
+      if (buffer.u && buffer.u->refcount == 1) {
+        frame = buffer;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  VideoSourceOptions options;
+  cv::VideoCapture capture;
+  std::thread thread;
+
+  std::mutex mutex;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  std::deque<cv::Mat> frames;
+  std::vector<cv::Mat> pool;
+  std::string error;
+  std::function<void()> listener;
+
+  int index;
+  bool finished;
+  std::atomic<bool> stopped;
+};
+
+class VideoReader : public Nan::ObjectWrap {
+
+public:
+
+  static NAN_MODULE_INIT(init) {
+    v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+
+    tpl->SetClassName(Nan::New("__NativeVideoReader").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    Nan::SetPrototypeMethod(tpl, "read", read);
+    Nan::SetPrototypeMethod(tpl, "close", close);
+
+    Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("width").ToLocalChecked(), getWidth);
+    Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("height").ToLocalChecked(), getHeight);
+    Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("fps").ToLocalChecked(), getFps);
+    Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("frameCount").ToLocalChecked(), getFrameCount);
+
+    constructor().Reset(Nan::GetFunction(tpl).ToLocalChecked());
+  }
+
+  static v8::Local<v8::Object> create(std::shared_ptr<VideoSource> source) {
+    Nan::EscapableHandleScope scope;
+
+    v8::Local<v8::Value> args[] = {};
+    auto constructor = Nan::New(VideoReader::constructor());
+    auto reader = Nan::NewInstance(constructor, 0, args).ToLocalChecked();
+
+    auto wrapped = Nan::ObjectWrap::Unwrap<VideoReader>(reader);
+    wrapped->source = source;
+
+    // The decoder thread wakes up the event loop through the async handle. It is only
+    // referenced while reads are pending so that an idle reader doesn't keep the process alive.
+    auto async = wrapped->async;
+    uv_async_init(Nan::GetCurrentEventLoop(), async, onFrame);
+    uv_unref(reinterpret_cast<uv_handle_t*>(async));
+    async->data = wrapped;
+
+    source->setListener([async]() {
+      uv_async_send(async);
+    });
+
+    return scope.Escape(reader);
+  }
+
+private:
+
+  VideoReader()
+    : async(new uv_async_t())
+    , pending(false) {
+  }
+
+  ~VideoReader() {
+    // The source stops its thread when the last reference is gone.
+    if (source) {
+      source->setListener(nullptr);
+      uv_close(reinterpret_cast<uv_handle_t*>(async), [](uv_handle_t* handle) {
+        delete reinterpret_cast<uv_async_t*>(handle);
+      });
+    } else {
+      delete async;
+    }
+
+    for (auto callback : reads) {
+      delete callback;
+    }
+  }
+
+  static NAN_METHOD(New) {
+    if (!info.IsConstructCall()) {
+      Nan::ThrowError("Class constructor VideoReader cannot be invoked without 'new'");
+      return;
+    }
+
+    auto reader = new VideoReader();
+    reader->Wrap(info.This());
+    info.GetReturnValue().Set(info.This());
+  }
+
+  static NAN_GETTER(getWidth) {
+    auto source = Nan::ObjectWrap::Unwrap<VideoReader>(info.Holder())->source;
+    info.GetReturnValue().Set(Nan::New(source->width));
+  }
+
+  static NAN_GETTER(getHeight) {
+    auto source = Nan::ObjectWrap::Unwrap<VideoReader>(info.Holder())->source;
+    info.GetReturnValue().Set(Nan::New(source->height));
+  }
+
+  static NAN_GETTER(getFps) {
+    auto source = Nan::ObjectWrap::Unwrap<VideoReader>(info.Holder())->source;
+    info.GetReturnValue().Set(Nan::New(source->fps));
+  }
+
+  static NAN_GETTER(getFrameCount) {
+    auto source = Nan::ObjectWrap::Unwrap<VideoReader>(info.Holder())->source;
+    info.GetReturnValue().Set(Nan::New(source->frameCount));
+  }
+
+  /**
+   * read()
+   * read(callback)
+   *
+   * Returns the next frame or null at the end of the video. The asynchronous version
+   * doesn't occupy a worker thread while it waits for the decoder. The callbacks of
+   * pending reads are called in order from the event loop.
+   */
+  static NAN_METHOD(read) {
+    auto reader = Nan::ObjectWrap::Unwrap<VideoReader>(info.Holder());
+
+    if (info.Length() > 1 || (info.Length() == 1 && !info[0]->IsFunction())) {
+      Nan::ThrowError("expected at most one argument (callback)");
+      return;
+    }
+
+    if (info.Length() == 0) {
+      try {
+        cv::Mat frame;
+        reader->source->next(frame);
+        info.GetReturnValue().Set(toFrame(frame));
+      } catch (std::exception& err) {
+        Nan::ThrowError(err.what());
+      }
+
+      return;
+    }
+
+    if (!reader->pending) {
+      // Keeps the reader alive and the event loop running until the reads are done.
+      reader->pending = true;
+      reader->Ref();
+      uv_ref(reinterpret_cast<uv_handle_t*>(reader->async));
+    }
+
+    reader->reads.push_back(new Nan::Callback(info[0].As<v8::Function>()));
+    // The callback is always called asynchronously, even if a frame is already waiting.
+    uv_async_send(reader->async);
+  }
+
+  static NAN_METHOD(close) {
+    auto reader = Nan::ObjectWrap::Unwrap<VideoReader>(info.Holder());
+    reader->source->stop();
+    // Pending reads get null.
+    uv_async_send(reader->async);
+  }
+
+  static v8::Local<v8::Value> toFrame(const cv::Mat& frame) {
+    Nan::EscapableHandleScope scope;
+
+    if (frame.empty()) {
+      return scope.Escape(Nan::Null());
+    }
+
+    auto matrix = Matrix::create(frame);
+    Matrix::trackExternalMemory(matrix);
+
+    return scope.Escape(matrix);
+  }
+
+  /**
+   * Called on the main thread after the decoder has queued frames. Several `uv_async_send`
+   * calls may be coalesced into one call, so all the frames that are ready are handed out.
+   */
+  static void onFrame(uv_async_t* handle) {
+    auto reader = static_cast<VideoReader*>(handle->data);
+    Nan::HandleScope scope;
+
+    while (!reader->reads.empty()) {
+      cv::Mat frame;
+      v8::Local<v8::Value> args[2];
+
+      try {
+        if (!reader->source->tryNext(frame)) {
+          break;
+        }
+
+        args[0] = Nan::Null();
+        args[1] = toFrame(frame);
+      } catch (std::exception& err) {
+        args[0] = Nan::Error(err.what());
+        args[1] = Nan::Null();
+      }
+
+      std::unique_ptr<Nan::Callback> callback(reader->reads.front());
+      reader->reads.pop_front();
+      callback->Call(2, args);
+    }
+
+    // Callbacks may have issued new reads, so this is only checked at the end.
+    if (reader->reads.empty() && reader->pending) {
+      reader->pending = false;
+      uv_unref(reinterpret_cast<uv_handle_t*>(reader->async));
+      reader->Unref();
+    }
+  }
+
+  static inline Nan::Persistent<v8::Function>& constructor() {
+    static thread_local Nan::Persistent<v8::Function> constructor;
+    return constructor;
+  }
+
+  std::shared_ptr<VideoSource> source;
+  uv_async_t* async;
+  std::deque<Nan::Callback*> reads;
+  bool pending;
+};
+
+#endif // SIMPLE_CV_VIDEO_READER_H
@@ -0,0 +1,414 @@
+#ifndef SIMPLE_CV_VIDEO_WRITER_H
+#define SIMPLE_CV_VIDEO_WRITER_H
+
+#include <nan.h>
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include "Matrix.h"
+#include "async.h"
+
+/**
+ * Encodes frames into a video file on a dedicated thread.
+ *
+ * Frames are queued in the order of `push` calls, which never wait. Each frame gets a
+ * sequence number, and a frame counts as accepted once fewer than `queueSize` frames are
+ * queued ahead of it. Producers wait for their frame to be accepted so that a producer
+ * that is faster than the encoder is slowed down instead of buffering an unbounded number
+ * of frames. The listener is called on the encoder thread whenever a frame has been taken
+ * from the queue or the encoder has failed.
+ */
+class VideoSink {
+
+public:
+
+  VideoSink(const std::string& filePath, int fourcc, double fps, cv::Size size, bool isColor, size_t queueSize)
+    : size(size)
+    , isColor(isColor)
+    , queueSize(queueSize)
+    , queued(0)
+    , dequeued(0)
+    , closed(false) {
+
+    if (!writer.open(filePath, fourcc, fps, size, isColor)) {
+      throw std::runtime_error(std::string("could not open video file ") + "\"" + filePath + "\"" + " for writing");
+    }
+
+    thread = std::thread(&VideoSink::run, this);
+  }
+
+  ~VideoSink() {
+    close();
+  }
+
+  /**
+   * Queues a frame and returns its sequence number.
+   */
+  uint64_t push(const cv::Mat& frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+
+    if (closed) {
+      throw std::runtime_error("the video writer has been closed");
+    }
+
+    frames.push_back(frame);
+    notEmpty.notify_one();
+
+    return queued++;
+  }
+
+  /**
+   * Returns true if the frame with sequence number `seq` has been accepted.
+   * Throws if the encoder has failed.
+   */
+  bool accepted(uint64_t seq) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+
+    return seq < dequeued + queueSize;
+  }
+
+  /**
+   * Blocks until the frame with sequence number `seq` has been accepted.
+   */
+  void waitUntilAccepted(uint64_t seq) {
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [this, seq]() { return seq < dequeued + queueSize || !error.empty(); });
+
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+  }
+
+  void setListener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->listener = listener;
+  }
+
+  /**
+   * Waits until all queued frames have been encoded and finalizes the file.
+   * Returns the first error the encoder thread ran into.
+   */
+  std::string close() {
+    std::lock_guard<std::mutex> closeLock(closeMutex);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closed = true;
+    }
+
+    notEmpty.notify_all();
+    notFull.notify_all();
+
+    if (thread.joinable()) {
+      thread.join();
+      writer.release();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+  }
+
+  cv::Size size;
+  bool isColor;
+
+private:
+
+  void run() {
+    while (true) {
+      cv::Mat frame;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]() { return !frames.empty() || closed; });
+
+        // Closed and all frames have been written.
+        if (frames.empty()) {
+          return;
+        }
+
+        frame = frames.front();
+        frames.pop_front();
+        ++dequeued;
+        notifyListener();
+      }
+
+      notFull.notify_all();
+
+      try {
+        writer.write(frame);
+      } catch (std::exception& err) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          error = err.what();
+          frames.clear();
+          notifyListener();
+        }
+
+        notFull.notify_all();
+        return;
+      }
+    }
+  }
+
+  // Must be called with `mutex` locked.
+  void notifyListener() {
+    if (listener) {
+      listener();
+    }
+  }
+
+  cv::VideoWriter writer;
+  size_t queueSize;
+  uint64_t queued;
+  uint64_t dequeued;
+  std::thread thread;
+
+  std::mutex mutex;
+  std::mutex closeMutex;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  std::deque<cv::Mat> frames;
+  std::string error;
+  std::function<void()> listener;
+  bool closed;
+};
+
+class VideoWriter : public Nan::ObjectWrap {
+
+public:
+
+  static NAN_MODULE_INIT(init) {
+    v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+
+    tpl->SetClassName(Nan::New("__NativeVideoWriter").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    Nan::SetPrototypeMethod(tpl, "write", write);
+    Nan::SetPrototypeMethod(tpl, "close", close);
+
+    constructor().Reset(Nan::GetFunction(tpl).ToLocalChecked());
+  }
+
+  static v8::Local<v8::Object> create(std::shared_ptr<VideoSink> sink) {
+    Nan::EscapableHandleScope scope;
+
+    v8::Local<v8::Value> args[] = {};
+    auto constructor = Nan::New(VideoWriter::constructor());
+    auto writer = Nan::NewInstance(constructor, 0, args).ToLocalChecked();
+
+    auto wrapped = Nan::ObjectWrap::Unwrap<VideoWriter>(writer);
+    wrapped->sink = sink;
+
+    // The encoder thread wakes up the event loop through the async handle. It is only
+    // referenced while writes are pending so that an idle writer doesn't keep the process alive.
+    auto async = wrapped->async;
+    uv_async_init(Nan::GetCurrentEventLoop(), async, onDequeued);
+    uv_unref(reinterpret_cast<uv_handle_t*>(async));
+    async->data = wrapped;
+
+    sink->setListener([async]() {
+      uv_async_send(async);
+    });
+
+    return scope.Escape(writer);
+  }
+
+private:
+
+  struct PendingWrite {
+    uint64_t seq;
+    Nan::Callback* callback;
+    std::string error;
+  };
+
+  VideoWriter()
+    : async(new uv_async_t())
+    , pending(false) {
+  }
+
+  ~VideoWriter() {
+    // The sink finishes the file when the last reference is gone.
+    if (sink) {
+      sink->setListener(nullptr);
+      uv_close(reinterpret_cast<uv_handle_t*>(async), [](uv_handle_t* handle) {
+        delete reinterpret_cast<uv_async_t*>(handle);
+      });
+    } else {
+      delete async;
+    }
+
+    for (auto& write : writes) {
+      delete write.callback;
+    }
+  }
+
+  static NAN_METHOD(New) {
+    if (!info.IsConstructCall()) {
+      Nan::ThrowError("Class constructor VideoWriter cannot be invoked without 'new'");
+      return;
+    }
+
+    auto writer = new VideoWriter();
+    writer->Wrap(info.This());
+    info.GetReturnValue().Set(info.This());
+  }
+
+  /**
+   * write(frame)
+   * write(frame, callback)
+   *
+   * The frame is copied and queued right away, so frames are encoded in the order of the
+   * calls even if the callbacks haven't been called yet. The callback is called once the
+   * frame has been accepted into the queue. Waiting for that doesn't occupy a worker thread.
+   */
+  static NAN_METHOD(write) {
+    auto self = Nan::ObjectWrap::Unwrap<VideoWriter>(info.Holder());
+    auto sink = self->sink;
+
+    if (info.Length() < 1 || info.Length() > 2) {
+      Nan::ThrowError("expected at least one argument (frame) and at most two arguments (frame, callback)");
+      return;
+    }
+
+    if (!Matrix::isMatrix(info[0])) {
+      Nan::ThrowError("first argument (frame) must be a Matrix");
+      return;
+    }
+
+    auto frame = Matrix::get(info[0]);
+
+    if (frame.size() != sink->size || frame.type() != (sink->isColor ? ImageTypeBGR : ImageTypeGray)) {
+      std::ostringstream msg;
+      msg << "first argument (frame) must be a " << (sink->isColor ? "BGR" : "Gray") << " image of size " << sink->size.width << "x" << sink->size.height;
+      Nan::ThrowError(msg.str().c_str());
+      return;
+    }
+
+    if (info.Length() == 2 && !info[1]->IsFunction()) {
+      Nan::ThrowError("second argument (callback) must be a function");
+      return;
+    }
+
+    PendingWrite write = {0, nullptr, ""};
+
+    try {
+      // The frame is copied so that the caller can modify the matrix right away.
+      write.seq = sink->push(frame.clone());
+    } catch (std::exception& err) {
+      write.error = err.what();
+    }
+
+    if (info.Length() == 1) {
+      try {
+        if (!write.error.empty()) {
+          throw std::runtime_error(write.error);
+        }
+
+        sink->waitUntilAccepted(write.seq);
+        info.GetReturnValue().Set(Nan::Null());
+      } catch (std::exception& err) {
+        Nan::ThrowError(err.what());
+      }
+
+      return;
+    }
+
+    if (!self->pending) {
+      // Keeps the writer alive and the event loop running until the writes are done.
+      self->pending = true;
+      self->Ref();
+      uv_ref(reinterpret_cast<uv_handle_t*>(self->async));
+    }
+
+    write.callback = new Nan::Callback(info[1].As<v8::Function>());
+    self->writes.push_back(write);
+    // The callback is always called asynchronously, even if the frame was accepted right away.
+    uv_async_send(self->async);
+  }
+
+  /**
+   * Called on the main thread after the encoder has taken frames from the queue.
+   * Calls the callbacks of the writes that have been accepted, in order.
+   */
+  static void onDequeued(uv_async_t* handle) {
+    auto self = static_cast<VideoWriter*>(handle->data);
+    Nan::HandleScope scope;
+
+    while (!self->writes.empty()) {
+      auto& write = self->writes.front();
+      v8::Local<v8::Value> args[2] = {Nan::Null(), Nan::Null()};
+
+      try {
+        if (!write.error.empty()) {
+          throw std::runtime_error(write.error);
+        }
+
+        if (!self->sink->accepted(write.seq)) {
+          break;
+        }
+      } catch (std::exception& err) {
+        args[0] = Nan::Error(err.what());
+      }
+
+      std::unique_ptr<Nan::Callback> callback(write.callback);
+      self->writes.pop_front();
+      callback->Call(2, args);
+    }
+
+    // Callbacks may have issued new writes, so this is only checked at the end.
+    if (self->writes.empty() && self->pending) {
+      self->pending = false;
+      uv_unref(reinterpret_cast<uv_handle_t*>(self->async));
+      self->Unref();
+    }
+  }
+
+  /**
+   * close()
+   * close(callback)
+   */
+  static NAN_METHOD(close) {
+    auto sink = Nan::ObjectWrap::Unwrap<VideoWriter>(info.Holder())->sink;
+
+    if (info.Length() > 1 || (info.Length() == 1 && !info[0]->IsFunction())) {
+      Nan::ThrowError("expected at most one argument (callback)");
+      return;
+    }
+
+    maybeAsyncOp<int>(info, [sink]() {
+      auto error = sink->close();
+
+      if (!error.empty()) {
+        throw std::runtime_error(error);
+      }
+
+      return 0;
+    }, [](const int&) {
+      return Nan::Null();
+    });
+  }
+
+  static inline Nan::Persistent<v8::Function>& constructor() {
+    static thread_local Nan::Persistent<v8::Function> constructor;
+    return constructor;
+  }
+
+  std::shared_ptr<VideoSink> sink;
+  uv_async_t* async;
+  std::deque<PendingWrite> writes;
+  bool pending;
+};
+
+#endif // SIMPLE_CV_VIDEO_WRITER_H
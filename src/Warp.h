@@ -0,0 +1,197 @@
+#ifndef SIMPLE_CV_WARP_H
+#define SIMPLE_CV_WARP_H
+
+#include <nan.h>
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <sstream>
+#include "Matrix.h"
+#include "async.h"
+#include "warpAffine.h"
+
+/**
+ * Precomputed remap tables of an affine transformation. `map1` holds the integer source
+ * coordinates and `map2` the fixed-point interpolation table indices, which is the format
+ * `cv::remap` processes fastest. The tables are immutable once created and are shared
+ * between the workers applying the warp.
+ */
+struct WarpMaps {
+  cv::Mat map1;
+  cv::Mat map2;
+  cv::Size srcSize;
+  cv::Size dstSize;
+  WarpOptions options;
+};
+
+/**
+ * Computes the source coordinates of each destination pixel, one stripe of rows per job.
+ */
+class WarpMapsBody : public cv::ParallelLoopBody {
+
+public:
+
+  WarpMapsBody(const cv::Mat& inverse, cv::Mat& mapX, cv::Mat& mapY)
+    : inverse(inverse)
+    , mapX(mapX)
+    , mapY(mapY) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    const double a = inverse.at<double>(0, 0);
+    const double b = inverse.at<double>(0, 1);
+    const double c = inverse.at<double>(0, 2);
+    const double d = inverse.at<double>(1, 0);
+    const double e = inverse.at<double>(1, 1);
+    const double f = inverse.at<double>(1, 2);
+
+    for (int y = range.start; y < range.end; ++y) {
+      auto xs = mapX.ptr<float>(y);
+      auto ys = mapY.ptr<float>(y);
+      const double rowX = b * y + c;
+      const double rowY = e * y + f;
+
+      for (int x = 0; x < mapX.cols; ++x) {
+        xs[x] = static_cast<float>(a * x + rowX);
+        ys[x] = static_cast<float>(d * x + rowY);
+      }
+    }
+  }
+
+private:
+
+  const cv::Mat& inverse;
+  cv::Mat& mapX;
+  cv::Mat& mapY;
+};
+
+std::shared_ptr<WarpMaps> createWarpMaps(const cv::Mat& trans, cv::Size srcSize, cv::Size dstSize, const WarpOptions& options) {
+  auto maps = std::make_shared<WarpMaps>();
+  cv::Mat inverse;
+  cv::Mat mapX(dstSize, CV_32FC1);
+  cv::Mat mapY(dstSize, CV_32FC1);
+
+  // Like cv::warpAffine, the transformation maps source to destination coordinates.
+  cv::invertAffineTransform(trans, inverse);
+
+  WarpMapsBody body(inverse, mapX, mapY);
+  cv::parallel_for_(cv::Range(0, dstSize.height), body);
+
+  // Nearest neighbor needs no interpolation table, so `map2` stays empty.
+  cv::convertMaps(mapX, mapY, maps->map1, maps->map2, CV_16SC2, options.interpolation == InterpolationNearest);
+
+  maps->srcSize = srcSize;
+  maps->dstSize = dstSize;
+  maps->options = options;
+
+  return maps;
+}
+
+class Warp : public Nan::ObjectWrap {
+
+public:
+
+  static NAN_MODULE_INIT(init) {
+    v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+
+    tpl->SetClassName(Nan::New("__NativeWarp").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    Nan::SetPrototypeMethod(tpl, "apply", apply);
+
+    Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("width").ToLocalChecked(), getWidth);
+    Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("height").ToLocalChecked(), getHeight);
+
+    constructor().Reset(Nan::GetFunction(tpl).ToLocalChecked());
+  }
+
+  static v8::Local<v8::Object> create(std::shared_ptr<WarpMaps> maps) {
+    Nan::EscapableHandleScope scope;
+
+    v8::Local<v8::Value> args[] = {};
+    auto constructor = Nan::New(Warp::constructor());
+    auto warp = Nan::NewInstance(constructor, 0, args).ToLocalChecked();
+
+    Nan::ObjectWrap::Unwrap<Warp>(warp)->maps = maps;
+
+    return scope.Escape(warp);
+  }
+
+private:
+
+  Warp() {}
+
+  ~Warp() {
+    // Nothing to do here.
+  }
+
+  static NAN_METHOD(New) {
+    if (!info.IsConstructCall()) {
+      Nan::ThrowError("Class constructor Warp cannot be invoked without 'new'");
+      return;
+    }
+
+    auto warp = new Warp();
+    warp->Wrap(info.This());
+    info.GetReturnValue().Set(info.This());
+  }
+
+  static NAN_GETTER(getWidth) {
+    auto maps = Nan::ObjectWrap::Unwrap<Warp>(info.Holder())->maps;
+    info.GetReturnValue().Set(Nan::New(maps->dstSize.width));
+  }
+
+  static NAN_GETTER(getHeight) {
+    auto maps = Nan::ObjectWrap::Unwrap<Warp>(info.Holder())->maps;
+    info.GetReturnValue().Set(Nan::New(maps->dstSize.height));
+  }
+
+  /**
+   * apply(image)
+   * apply(image, callback)
+   */
+  static NAN_METHOD(apply) {
+    auto maps = Nan::ObjectWrap::Unwrap<Warp>(info.Holder())->maps;
+
+    if (info.Length() < 1 || info.Length() > 2) {
+      Nan::ThrowError("expected at least one argument (image) and at most two arguments (image, callback)");
+      return;
+    }
+
+    if (!Matrix::isMatrix(info[0])) {
+      Nan::ThrowError("first argument (image) must be a Matrix");
+      return;
+    }
+
+    if (info.Length() == 2 && !info[1]->IsFunction()) {
+      Nan::ThrowError("second argument (callback) must be a function");
+      return;
+    }
+
+    cv::Mat image = Matrix::get(info[0]);
+
+    if (image.size() != maps->srcSize) {
+      std::ostringstream msg;
+      msg << "first argument (image) must have the size the warp was created for (w=" << maps->srcSize.width << ", h=" << maps->srcSize.height << ")";
+      Nan::ThrowError(msg.str().c_str());
+      return;
+    }
+
+    maybeAsyncOp<cv::Mat>(info, [maps, image]() {
+      cv::Mat output;
+      auto& opt = maps->options;
+      cv::remap(image, output, maps->map1, maps->map2, opt.interpolation, opt.borderType, opt.borderValue);
+      return output;
+    }, [](const cv::Mat& result) {
+      return Matrix::create(result);
+    });
+  }
+
+  static inline Nan::Persistent<v8::Function>& constructor() {
+    static thread_local Nan::Persistent<v8::Function> constructor;
+    return constructor;
+  }
+
+  std::shared_ptr<WarpMaps> maps;
+};
+
+#endif // SIMPLE_CV_WARP_H
@@ -0,0 +1,380 @@
+#ifndef SIMPLE_CV_BOXES_H
+#define SIMPLE_CV_BOXES_H
+
+#include <algorithm>
+#include <cfloat>
+#include <sstream>
+#include <opencv2/opencv.hpp>
+
+#include "async.h"
+#include "utils.h"
+
+/**
+ * Boxes stored as separate arrays of corners and areas. Keeping each coordinate in its
+ * own array makes the inner loops below straight runs over contiguous floats that the
+ * compiler can vectorize.
+ */
+struct BoxArrays {
+  std::vector<float> x1;
+  std::vector<float> y1;
+  std::vector<float> x2;
+  std::vector<float> y2;
+  std::vector<float> area;
+
+  BoxArrays() {
+  }
+
+  /**
+   * `boxes` is a flat array of [x, y, width, height] quadruples.
+   */
+  explicit BoxArrays(const std::vector<float>& boxes) {
+    auto count = boxes.size() / 4;
+
+    reserve(count);
+
+    for (size_t i = 0; i < count; ++i) {
+      push(boxes[i * 4], boxes[i * 4 + 1], boxes[i * 4 + 2], boxes[i * 4 + 3]);
+    }
+  }
+
+  void reserve(size_t count) {
+    x1.reserve(count);
+    y1.reserve(count);
+    x2.reserve(count);
+    y2.reserve(count);
+    area.reserve(count);
+  }
+
+  void push(float x, float y, float width, float height) {
+    x1.push_back(x);
+    y1.push_back(y);
+    x2.push_back(x + width);
+    y2.push_back(y + height);
+    area.push_back(std::max(width, 0.0f) * std::max(height, 0.0f));
+  }
+
+  size_t size() const {
+    return area.size();
+  }
+};
+
+/**
+ * Writes the IoU of box `i` of `a` with every box of `b` into `out`.
+ */
+inline void boxIoURow(const BoxArrays& a, size_t i, const BoxArrays& b, float* out) {
+  const float ax1 = a.x1[i];
+  const float ay1 = a.y1[i];
+  const float ax2 = a.x2[i];
+  const float ay2 = a.y2[i];
+  const float aArea = a.area[i];
+  const int n = static_cast<int>(b.size());
+
+  for (int j = 0; j < n; ++j) {
+    auto w = std::max(std::min(ax2, b.x2[j]) - std::max(ax1, b.x1[j]), 0.0f);
+    auto h = std::max(std::min(ay2, b.y2[j]) - std::max(ay1, b.y1[j]), 0.0f);
+    auto inter = w * h;
+
+    // The union is only zero if both boxes are empty, in which case `inter` is zero too.
+    out[j] = inter / std::max(aArea + b.area[j] - inter, FLT_MIN);
+  }
+}
+
+class BoxIoUBody : public cv::ParallelLoopBody {
+
+public:
+
+  BoxIoUBody(const BoxArrays& a, const BoxArrays& b, std::vector<float>& result)
+    : a(a)
+    , b(b)
+    , result(result) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    for (int i = range.start; i < range.end; ++i) {
+      boxIoURow(a, i, b, result.data() + static_cast<size_t>(i) * b.size());
+    }
+  }
+
+private:
+
+  const BoxArrays& a;
+  const BoxArrays& b;
+  std::vector<float>& result;
+};
+
+/**
+ * Greedy non-maximum suppression. The candidates are visited in the order of decreasing
+ * score and a candidate is kept if its IoU with every box kept so far is at most
+ * `iouThreshold`. Each candidate is only compared against the kept boxes, so the cost is
+ * O(candidates * kept) rather than O(candidates^2), and with `topK` the loop stops as soon
+ * as enough boxes have been kept.
+ */
+std::vector<int> nonMaxSuppression(const std::vector<float>& boxes, const std::vector<float>& scores,
+    float iouThreshold, float scoreThreshold, size_t topK) {
+  std::vector<int> order;
+  std::vector<int> keep;
+
+  for (int i = 0; i < static_cast<int>(scores.size()); ++i) {
+    if (scores[i] >= scoreThreshold) {
+      order.push_back(i);
+    }
+  }
+
+  // Stable so that boxes with equal scores keep their input order.
+  std::stable_sort(order.begin(), order.end(), [&scores](int a, int b) {
+    return scores[a] > scores[b];
+  });
+
+  BoxArrays kept;
+  kept.reserve(std::min(order.size(), topK));
+
+  for (auto i : order) {
+    if (keep.size() >= topK) {
+      break;
+    }
+
+    auto x1 = boxes[i * 4];
+    auto y1 = boxes[i * 4 + 1];
+    auto x2 = x1 + boxes[i * 4 + 2];
+    auto y2 = y1 + boxes[i * 4 + 3];
+    auto area = std::max(boxes[i * 4 + 2], 0.0f) * std::max(boxes[i * 4 + 3], 0.0f);
+    auto n = static_cast<int>(kept.size());
+    int suppressed = 0;
+
+    // No early exit so that the loop can be vectorized. `inter > t * union` is the same
+    // test as `inter / union > t` without the division.
+    for (int k = 0; k < n; ++k) {
+      auto w = std::max(std::min(x2, kept.x2[k]) - std::max(x1, kept.x1[k]), 0.0f);
+      auto h = std::max(std::min(y2, kept.y2[k]) - std::max(y1, kept.y1[k]), 0.0f);
+      auto inter = w * h;
+
+      suppressed |= inter > iouThreshold * (area + kept.area[k] - inter);
+    }
+
+    if (!suppressed) {
+      keep.push_back(i);
+      kept.push(x1, y1, boxes[i * 4 + 2], boxes[i * 4 + 3]);
+    }
+  }
+
+  return keep;
+}
+
+/**
+ * Copies a Float32Array of [x, y, width, height] quadruples. Returns false if `value`
+ * is not a Float32Array or its length isn't a multiple of four.
+ */
+bool getBoxes(v8::Local<v8::Value> value, std::vector<float>& boxes) {
+  if (!value->IsFloat32Array()) {
+    return false;
+  }
+
+  Nan::TypedArrayContents<float> contents(value);
+
+  if (contents.length() % 4 != 0) {
+    return false;
+  }
+
+  boxes.assign(*contents, *contents + contents.length());
+  return true;
+}
+
+/**
+ * nms(boxes, scores)
+ * nms(boxes, scores, callback)
+ * nms(boxes, scores, {iouThreshold?, scoreThreshold?, topK?})
+ * nms(boxes, scores, {iouThreshold?, scoreThreshold?, topK?}, callback)
+ *
+ * Returns an Int32Array of the indices of the kept boxes in the order of decreasing score.
+ */
+NAN_METHOD(nms) {
+  if (info.Length() < 2 || info.Length() > 4) {
+    Nan::ThrowError("expected at least two arguments (boxes, scores) and at most four arguments (boxes, scores, opt, callback)");
+    return;
+  }
+
+  std::vector<float> boxes;
+  std::vector<float> scores;
+
+  if (!getBoxes(info[0], boxes)) {
+    Nan::ThrowError("first argument (boxes) must be a Float32Array of [x, y, width, height] quadruples");
+    return;
+  }
+
+  if (!info[1]->IsFloat32Array() || info[1].As<v8::Float32Array>()->Length() != boxes.size() / 4) {
+    Nan::ThrowError("second argument (scores) must be a Float32Array with one score per box");
+    return;
+  }
+
+  if (info.Length() == 4 && !info[3]->IsFunction()) {
+    Nan::ThrowError("fourth argument (callback) must be a function");
+    return;
+  }
+
+  Nan::TypedArrayContents<float> scoreContents(info[1]);
+  scores.assign(*scoreContents, *scoreContents + scoreContents.length());
+
+  auto iouThreshold = 0.5f;
+  auto scoreThreshold = -FLT_MAX;
+  auto topK = scores.size();
+
+  if (info.Length() >= 3 && info[2]->IsObject() && !info[2]->IsFunction()) {
+    auto opt = info[2];
+
+    if (has(opt, "iouThreshold")) {
+      iouThreshold = static_cast<float>(get<double>(opt, "iouThreshold"));
+
+      if (!(iouThreshold >= 0 && iouThreshold <= 1)) {
+        Nan::ThrowError("iouThreshold must be between 0 and 1");
+        return;
+      }
+    }
+
+    if (has(opt, "scoreThreshold")) {
+      scoreThreshold = static_cast<float>(get<double>(opt, "scoreThreshold"));
+    }
+
+    if (has(opt, "topK")) {
+      auto value = get<double>(opt, "topK");
+
+      if (!(value >= 1)) {
+        Nan::ThrowError("topK must be a positive number");
+        return;
+      }
+
+      if (value < topK) {
+        topK = static_cast<size_t>(value);
+      }
+    }
+  }
+
+  maybeAsyncOp<std::vector<int>>(info, [boxes, scores, iouThreshold, scoreThreshold, topK]() {
+    return nonMaxSuppression(boxes, scores, iouThreshold, scoreThreshold, topK);
+  }, [](const std::vector<int>& keep) {
+    return newTypedArray<v8::Int32Array>(keep.data(), keep.size());
+  });
+}
+
+/**
+ * boxIoU(boxes1, boxes2)
+ * boxIoU(boxes1, boxes2, callback)
+ *
+ * Returns a Float32Array with `boxes1.length / 4` rows and `boxes2.length / 4` columns.
+ */
+NAN_METHOD(boxIoU) {
+  if (info.Length() < 2 || info.Length() > 3) {
+    Nan::ThrowError("expected at least two arguments (boxes1, boxes2) and at most three arguments (boxes1, boxes2, callback)");
+    return;
+  }
+
+  std::vector<float> boxes1;
+  std::vector<float> boxes2;
+
+  if (!getBoxes(info[0], boxes1)) {
+    Nan::ThrowError("first argument (boxes1) must be a Float32Array of [x, y, width, height] quadruples");
+    return;
+  }
+
+  if (!getBoxes(info[1], boxes2)) {
+    Nan::ThrowError("second argument (boxes2) must be a Float32Array of [x, y, width, height] quadruples");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  // Checked before the table is allocated. The quotient keeps the product from overflowing.
+  auto n = boxes1.size() / 4;
+  auto m = boxes2.size() / 4;
+
+  if (m != 0 && n > maxTypedArrayBytes() / sizeof(float) / m) {
+    std::ostringstream msg;
+    msg << "the IoU table of " << n << "x" << m << " boxes is too large for a typed array";
+    Nan::ThrowError(msg.str().c_str());
+    return;
+  }
+
+  maybeAsyncOp<std::vector<float>>(info, [boxes1, boxes2]() {
+    BoxArrays a(boxes1);
+    BoxArrays b(boxes2);
+    std::vector<float> result(a.size() * b.size());
+
+    BoxIoUBody body(a, b, result);
+    cv::parallel_for_(cv::Range(0, static_cast<int>(a.size())), body);
+
+    return result;
+  }, [](const std::vector<float>& result) {
+    return newTypedArray<v8::Float32Array>(result.data(), result.size());
+  });
+}
+
+/**
+ * clipBoxes(boxes, rect)
+ * clipBoxes(boxes, rect, callback)
+ *
+ * `rect` is a rectangle {x, y, width, height} or a size {width, height}. Returns a new
+ * Float32Array with the intersection of each box and `rect`. Boxes outside of `rect`
+ * get a zero width or height.
+ */
+NAN_METHOD(clipBoxes) {
+  if (info.Length() < 2 || info.Length() > 3) {
+    Nan::ThrowError("expected at least two arguments (boxes, rect) and at most three arguments (boxes, rect, callback)");
+    return;
+  }
+
+  std::vector<float> boxes;
+
+  if (!getBoxes(info[0], boxes)) {
+    Nan::ThrowError("first argument (boxes) must be a Float32Array of [x, y, width, height] quadruples");
+    return;
+  }
+
+  cv::Rect_<double> rect;
+
+  if (isRect(info[1])) {
+    rect = getRect<double>(info[1]);
+  } else if (isSize(info[1])) {
+    rect = cv::Rect_<double>(cv::Point_<double>(0, 0), getSize<double>(info[1]));
+  } else {
+    Nan::ThrowError("second argument (rect) must be a rectangle {x, y, width, height} or a size {width, height}");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  maybeAsyncOp<std::vector<float>>(info, [boxes, rect]() {
+    const float left = static_cast<float>(rect.x);
+    const float top = static_cast<float>(rect.y);
+    const float right = static_cast<float>(rect.x + rect.width);
+    const float bottom = static_cast<float>(rect.y + rect.height);
+    const int count = static_cast<int>(boxes.size() / 4);
+
+    std::vector<float> result(boxes.size());
+
+    for (int i = 0; i < count; ++i) {
+      auto b = boxes.data() + i * 4;
+      auto out = result.data() + i * 4;
+
+      auto x1 = std::min(std::max(b[0], left), right);
+      auto y1 = std::min(std::max(b[1], top), bottom);
+      auto x2 = std::min(std::max(b[0] + b[2], left), right);
+      auto y2 = std::min(std::max(b[1] + b[3], top), bottom);
+
+      out[0] = x1;
+      out[1] = y1;
+      out[2] = std::max(x2 - x1, 0.0f);
+      out[3] = std::max(y2 - y1, 0.0f);
+    }
+
+    return result;
+  }, [](const std::vector<float>& result) {
+    return newTypedArray<v8::Float32Array>(result.data(), result.size());
+  });
+}
+
+#endif // SIMPLE_CV_BOXES_H
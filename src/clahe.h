@@ -0,0 +1,75 @@
+#ifndef SIMPLE_CV_CLAHE_H
+#define SIMPLE_CV_CLAHE_H
+
+#include "Matrix.h"
+#include "async.h"
+#include "utils.h"
+#include "equalizeHist.h"
+
+/**
+ * clahe(image)
+ * clahe(image, callback)
+ * clahe(image, {clipLimit?, tileGrid?, mode?})
+ * clahe(image, {clipLimit?, tileGrid?, mode?}, callback)
+ */
+NAN_METHOD(clahe) {
+  if (info.Length() < 1 || info.Length() > 3) {
+    Nan::ThrowError("expected at least one argument (image) and at most three arguments (image, opt, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  auto image = Matrix::get(info[0]);
+  auto mode = EqualizeModeLuminance;
+  auto clipLimit = 2.0;
+  auto tileGrid = cv::Size(8, 8);
+
+  if ((image.depth() != CV_8U && image.depth() != CV_16U) || image.channels() == 2) {
+    Nan::ThrowError("first argument (image) must be a Gray, BGR or BGRA image with 8 or 16 bits per channel");
+    return;
+  }
+
+  if (info.Length() >= 2 && info[1]->IsObject() && !info[1]->IsFunction()) {
+    auto opt = info[1];
+
+    if (has(opt, "clipLimit")) {
+      clipLimit = get<double>(opt, "clipLimit");
+    }
+
+    if (has(opt, "tileGrid")) {
+      if (isSize(getValue(opt, "tileGrid"))) {
+        tileGrid = getSize<int>(getValue(opt, "tileGrid"));
+      } else {
+        auto size = get<int>(opt, "tileGrid");
+        tileGrid = cv::Size(size, size);
+      }
+    }
+  }
+
+  if (tileGrid.width < 1 || tileGrid.height < 1) {
+    Nan::ThrowError("tileGrid must be a positive number or a size {width, height}");
+    return;
+  }
+
+  if (info.Length() >= 2 && !getEqualizeMode(info[1], mode)) {
+    Nan::ThrowError("mode must be one of ['luminance', 'perChannel']");
+    return;
+  }
+
+  maybeAsyncOp<cv::Mat>(info, [image, mode, clipLimit, tileGrid]() {
+    // OpenCV computes the tile histograms and interpolates the result in parallel.
+    auto filter = cv::createCLAHE(clipLimit, tileGrid);
+
+    return equalizeChannels(image, mode, [&filter](const cv::Mat& src, cv::Mat& dst) {
+      filter->apply(src, dst);
+    });
+  }, [](const cv::Mat& result) {
+    return Matrix::create(result);
+  });
+}
+
+#endif // SIMPLE_CV_CLAHE_H
@@ -61,6 +61,11 @@ NAN_METHOD(colorTemperature) {
 
   auto image = Matrix::get(info[0]);
 
+  if (image.type() != ImageTypeBGR) {
+    Nan::ThrowError("first argument (image) must be a BGR image");
+    return;
+  }
+
   if (!info[1]->IsNumber()) {
     Nan::ThrowError("second argument (temperature) must be a number");
     return;
@@ -0,0 +1,333 @@
+#ifndef SIMPLE_CV_COMPARE_H
+#define SIMPLE_CV_COMPARE_H
+
+#include <cmath>
+#include <limits>
+
+#include "Matrix.h"
+#include "async.h"
+#include "utils.h"
+
+static const int CompareMetricPSNR = 1;
+static const int CompareMetricSSIM = 2;
+static const int CompareMetricMSSSIM = 4;
+
+// Weights of the five MS-SSIM scales from the original paper.
+static const double MSSSIMWeights[] = { 0.0448, 0.2856, 0.3001, 0.2363, 0.1333 };
+static const int MSSSIMScales = 5;
+
+// The Gaussian window of SSIM is 11x11 with sigma 1.5. Each MS-SSIM scale
+// must be at least as large as the window.
+static const int SSIMWindowSize = 11;
+static const double SSIMWindowSigma = 1.5;
+
+struct CompareResult {
+  double psnr;
+  double ssim;
+  double msssim;
+  cv::Mat ssimMap;
+
+  CompareResult()
+    : psnr(0)
+    , ssim(0)
+    , msssim(0) {
+  }
+};
+
+/**
+ * The dynamic range of the pixel values. Float images are expected to be in [0, 1].
+ */
+inline double compareMaxValue(int depth) {
+  switch (depth) {
+    case CV_8U:
+      return 255.0;
+    case CV_16U:
+      return 65535.0;
+    default:
+      return 1.0;
+  }
+}
+
+struct SSIMChannelResult {
+  double ssim;
+  double cs;
+  cv::Mat map;
+};
+
+/**
+ * Computes the SSIM of a single float channel. `cs` is the mean of the contrast-structure
+ * term that MS-SSIM uses for all but the coarsest scale. The local means and variances
+ * are computed with OpenCV's separable (and vectorized) Gaussian filter.
+ */
+SSIMChannelResult ssimChannel(const cv::Mat& x, const cv::Mat& y, double maxValue, bool keepMap) {
+  const double c1 = std::pow(0.01 * maxValue, 2);
+  const double c2 = std::pow(0.03 * maxValue, 2);
+  const cv::Size window(SSIMWindowSize, SSIMWindowSize);
+
+  cv::Mat muX, muY, xx, yy, xy;
+
+  cv::GaussianBlur(x, muX, window, SSIMWindowSigma);
+  cv::GaussianBlur(y, muY, window, SSIMWindowSigma);
+  cv::GaussianBlur(x.mul(x), xx, window, SSIMWindowSigma);
+  cv::GaussianBlur(y.mul(y), yy, window, SSIMWindowSigma);
+  cv::GaussianBlur(x.mul(y), xy, window, SSIMWindowSigma);
+
+  cv::Mat muXX = muX.mul(muX);
+  cv::Mat muYY = muY.mul(muY);
+  cv::Mat muXY = muX.mul(muY);
+
+  cv::Mat sigmaXX = xx - muXX;
+  cv::Mat sigmaYY = yy - muYY;
+  cv::Mat sigmaXY = xy - muXY;
+
+  cv::Mat cs;
+  cv::divide(2 * sigmaXY + c2, sigmaXX + sigmaYY + c2, cs);
+
+  cv::Mat luminance;
+  cv::divide(2 * muXY + c1, muXX + muYY + c1, luminance);
+
+  cv::Mat map = luminance.mul(cs);
+
+  SSIMChannelResult result;
+  result.ssim = cv::mean(map)[0];
+  result.cs = cv::mean(cs)[0];
+
+  if (keepMap) {
+    result.map = map;
+  }
+
+  return result;
+}
+
+/**
+ * Computes SSIM and MS-SSIM for each channel in parallel.
+ */
+class SSIMBody : public cv::ParallelLoopBody {
+
+public:
+
+  SSIMBody(const std::vector<cv::Mat>& x, const std::vector<cv::Mat>& y, double maxValue, int metrics, bool keepMap,
+      std::vector<double>& ssim, std::vector<double>& msssim, std::vector<cv::Mat>& maps)
+    : x(x)
+    , y(y)
+    , maxValue(maxValue)
+    , metrics(metrics)
+    , keepMap(keepMap)
+    , ssim(ssim)
+    , msssim(msssim)
+    , maps(maps) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    for (int c = range.start; c < range.end; ++c) {
+      auto full = ssimChannel(x[c], y[c], maxValue, keepMap);
+
+      ssim[c] = full.ssim;
+      maps[c] = full.map;
+
+      if (metrics & CompareMetricMSSSIM) {
+        msssim[c] = multiScale(c, full.cs);
+      }
+    }
+  }
+
+private:
+
+  /**
+   * The first scale is the full size image whose `cs` has already been computed.
+   * Negative terms are clamped to zero so that the fractional powers stay defined.
+   */
+  double multiScale(int c, double firstCs) const {
+    double result = std::pow(std::max(firstCs, 0.0), MSSSIMWeights[0]);
+    cv::Mat sx = x[c];
+    cv::Mat sy = y[c];
+
+    for (int scale = 1; scale < MSSSIMScales; ++scale) {
+      cv::Mat nx, ny;
+
+      cv::resize(sx, nx, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+      cv::resize(sy, ny, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+
+      auto current = ssimChannel(nx, ny, maxValue, false);
+      auto term = scale == MSSSIMScales - 1 ? current.ssim : current.cs;
+
+      result *= std::pow(std::max(term, 0.0), MSSSIMWeights[scale]);
+
+      sx = nx;
+      sy = ny;
+    }
+
+    return result;
+  }
+
+  const std::vector<cv::Mat>& x;
+  const std::vector<cv::Mat>& y;
+  double maxValue;
+  int metrics;
+  bool keepMap;
+  std::vector<double>& ssim;
+  std::vector<double>& msssim;
+  std::vector<cv::Mat>& maps;
+};
+
+CompareResult compareImages(const cv::Mat& a, const cv::Mat& b, int metrics, bool keepMap) {
+  CompareResult result;
+  auto maxValue = compareMaxValue(a.depth());
+
+  if (metrics & CompareMetricPSNR) {
+    auto mse = cv::norm(a, b, cv::NORM_L2SQR) / (static_cast<double>(a.total()) * a.channels());
+
+    if (mse == 0) {
+      result.psnr = std::numeric_limits<double>::infinity();
+    } else {
+      result.psnr = 10.0 * std::log10(maxValue * maxValue / mse);
+    }
+  }
+
+  if (!(metrics & (CompareMetricSSIM | CompareMetricMSSSIM)) && !keepMap) {
+    return result;
+  }
+
+  std::vector<cv::Mat> x, y;
+  cv::split(a, x);
+  cv::split(b, y);
+
+  for (size_t c = 0; c < x.size(); ++c) {
+    x[c].convertTo(x[c], CV_32F);
+    y[c].convertTo(y[c], CV_32F);
+  }
+
+  auto channels = a.channels();
+  std::vector<double> ssim(channels, 0.0);
+  std::vector<double> msssim(channels, 0.0);
+  std::vector<cv::Mat> maps(channels);
+
+  SSIMBody body(x, y, maxValue, metrics, keepMap, ssim, msssim, maps);
+  cv::parallel_for_(cv::Range(0, channels), body);
+
+  // Multi-channel results are the average over the channels.
+  for (int c = 0; c < channels; ++c) {
+    result.ssim += ssim[c] / channels;
+    result.msssim += msssim[c] / channels;
+  }
+
+  if (keepMap) {
+    result.ssimMap = maps[0] / channels;
+
+    for (int c = 1; c < channels; ++c) {
+      result.ssimMap += maps[c] / channels;
+    }
+  }
+
+  return result;
+}
+
+/**
+ * Reads the `metrics` option. Returns false if it's invalid.
+ */
+bool getCompareMetrics(v8::Local<v8::Value> opt, int& metrics) {
+  if (!opt->IsObject() || opt->IsFunction() || !has(opt, "metrics")) {
+    return true;
+  }
+
+  auto value = getValue(opt, "metrics");
+
+  if (!value->IsArray() || value.As<v8::Array>()->Length() == 0) {
+    return false;
+  }
+
+  auto arr = value.As<v8::Array>();
+  metrics = 0;
+
+  for (unsigned i = 0; i < arr->Length(); ++i) {
+    std::string name(v8::String::Utf8Value(Nan::Get(arr, i).ToLocalChecked()->ToString()).operator*());
+
+    if (name == "psnr") {
+      metrics |= CompareMetricPSNR;
+    } else if (name == "ssim") {
+      metrics |= CompareMetricSSIM;
+    } else if (name == "msssim") {
+      metrics |= CompareMetricMSSSIM;
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * compare(image1, image2)
+ * compare(image1, image2, callback)
+ * compare(image1, image2, {metrics?, ssimMap?})
+ * compare(image1, image2, {metrics?, ssimMap?}, callback)
+ */
+NAN_METHOD(compare) {
+  if (info.Length() < 2 || info.Length() > 4) {
+    Nan::ThrowError("expected at least two arguments (image1, image2) and at most four arguments (image1, image2, opt, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image1) must be a Matrix");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[1])) {
+    Nan::ThrowError("second argument (image2) must be a Matrix");
+    return;
+  }
+
+  auto image1 = Matrix::get(info[0]);
+  auto image2 = Matrix::get(info[1]);
+  auto metrics = CompareMetricPSNR | CompareMetricSSIM;
+  auto keepMap = false;
+
+  if (image1.size() != image2.size() || image1.type() != image2.type()) {
+    Nan::ThrowError("second argument (image2) must have the same size and type as the first argument (image1)");
+    return;
+  }
+
+  if (info.Length() >= 3 && !getCompareMetrics(info[2], metrics)) {
+    Nan::ThrowError("metrics must be a non-empty array of ['psnr', 'ssim', 'msssim']");
+    return;
+  }
+
+  if (info.Length() >= 3 && info[2]->IsObject() && !info[2]->IsFunction() && has(info[2], "ssimMap")) {
+    keepMap = get<bool>(info[2], "ssimMap");
+  }
+
+  auto minSize = SSIMWindowSize << (MSSSIMScales - 1);
+
+  if ((metrics & CompareMetricMSSSIM) && (image1.cols < minSize || image1.rows < minSize)) {
+    auto message = "msssim requires images of at least " + std::to_string(minSize) + "x" + std::to_string(minSize) + " pixels";
+    Nan::ThrowError(message.c_str());
+    return;
+  }
+
+  maybeAsyncOp<CompareResult>(info, [image1, image2, metrics, keepMap]() {
+    return compareImages(image1, image2, metrics, keepMap);
+  }, [metrics, keepMap](const CompareResult& result) {
+    auto obj = Nan::New<v8::Object>();
+
+    if (metrics & CompareMetricPSNR) {
+      Nan::Set(obj, Nan::New("psnr").ToLocalChecked(), Nan::New(result.psnr));
+    }
+
+    if (metrics & CompareMetricSSIM) {
+      Nan::Set(obj, Nan::New("ssim").ToLocalChecked(), Nan::New(result.ssim));
+    }
+
+    if (metrics & CompareMetricMSSSIM) {
+      Nan::Set(obj, Nan::New("msssim").ToLocalChecked(), Nan::New(result.msssim));
+    }
+
+    if (keepMap) {
+      Nan::Set(obj, Nan::New("ssimMap").ToLocalChecked(), Matrix::create(result.ssimMap));
+    }
+
+    return obj;
+  });
+}
+
+#endif // SIMPLE_CV_COMPARE_H
@@ -0,0 +1,334 @@
+#ifndef SIMPLE_CV_COMPOSITE_H
+#define SIMPLE_CV_COMPOSITE_H
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "Matrix.h"
+#include "async.h"
+#include "utils.h"
+
+static const int BlendModeOver = 0;
+static const int BlendModeMultiply = 1;
+static const int BlendModeScreen = 2;
+
+// Rounded division by 255 for values in [0, 255 * 255].
+static inline int div255(int v) {
+  v += 128;
+  return (v + (v >> 8)) >> 8;
+}
+
+/**
+ * `(1 << 24) / a` rounded up. Multiplying by it and shifting by 24 divides exactly by `a`
+ * for the numerators that occur when unpremultiplying, so no per pixel division is needed.
+ */
+static const uint32_t* compositeReciprocals() {
+  struct Table {
+    uint32_t values[256];
+
+    Table() {
+      values[0] = 0;
+
+      for (uint32_t a = 1; a < 256; ++a) {
+        values[a] = ((1u << 24) + a - 1) / a;
+      }
+    }
+  };
+
+  static const Table table;
+  return table.values;
+}
+
+/**
+ * Blends one overlay pixel onto one base pixel. All math is 8 bit fixed point with colors
+ * premultiplied by alpha. The channel counts and the blend mode are template parameters
+ * so that the branches on them are resolved at compile time.
+ */
+template<int BC, int OC, int Blend>
+static inline void compositePixel(uchar* b, const uchar* o, int opacity, const uint32_t* reciprocals) {
+  int sa = OC == 4 ? div255(o[3] * opacity) : opacity;
+  int ba = BC == 4 ? b[3] : 255;
+
+  // Source alpha remaining after the base has been covered.
+  int inv = 255 - sa;
+  int outA = sa + div255(ba * inv);
+
+  for (int c = 0; c < 3; ++c) {
+    int s = o[OC == 1 ? 0 : c];
+    int d = b[c];
+
+    if (Blend == BlendModeMultiply) {
+      s = div255((255 - ba) * s + ba * div255(s * d));
+    } else if (Blend == BlendModeScreen) {
+      s = div255((255 - ba) * s + ba * (255 - div255((255 - s) * (255 - d))));
+    }
+
+    // Premultiplied source-over.
+    int premultiplied = s * sa + div255(d * ba) * inv;
+
+    if (BC == 4) {
+      auto value = (static_cast<uint64_t>(premultiplied + outA / 2) * reciprocals[outA]) >> 24;
+      b[c] = static_cast<uchar>(std::min<uint64_t>(value, 255));
+    } else {
+      b[c] = static_cast<uchar>(div255(premultiplied));
+    }
+  }
+
+  if (BC == 4) {
+    b[3] = static_cast<uchar>(outA);
+  }
+}
+
+#if CV_SIMD128
+
+static inline cv::v_uint16x8 v_div255(const cv::v_uint16x8& x) {
+  auto v = x + cv::v_setall_u16(128);
+  return (v + (v >> 8)) >> 8;
+}
+
+/**
+ * The blend of one channel for a BGR base, whose alpha is 255. All intermediate values stay
+ * below 255 * 255, so they fit into 16 bits.
+ */
+template<int Blend>
+static inline cv::v_uint16x8 v_compositeChannel(const cv::v_uint16x8& s, const cv::v_uint16x8& d, const cv::v_uint16x8& sa) {
+  const auto v255 = cv::v_setall_u16(255);
+  auto blended = s;
+
+  if (Blend == BlendModeMultiply) {
+    blended = v_div255(s * d);
+  } else if (Blend == BlendModeScreen) {
+    blended = v255 - v_div255((v255 - s) * (v255 - d));
+  }
+
+  return v_div255(blended * sa + d * (v255 - sa));
+}
+
+/**
+ * Blends 16 pixels at a time onto a BGR base with OpenCV's universal intrinsics. Returns
+ * the number of pixels that were blended. The rest is left for `compositePixel`, which
+ * computes the same values.
+ */
+template<int OC, int Blend>
+static int compositeRowBGR(uchar* b, const uchar* o, int n, int opacity) {
+  const int step = cv::v_uint8x16::nlanes;
+  const auto vOpacity = cv::v_setall_u16(static_cast<ushort>(opacity));
+  int x = 0;
+
+  for (; x <= n - step; x += step, b += 3 * step, o += OC * step) {
+    cv::v_uint8x16 base[3], overlay[4];
+
+    cv::v_load_deinterleave(b, base[0], base[1], base[2]);
+
+    if (OC == 1) {
+      overlay[0] = overlay[1] = overlay[2] = cv::v_load(o);
+    } else if (OC == 3) {
+      cv::v_load_deinterleave(o, overlay[0], overlay[1], overlay[2]);
+    } else {
+      cv::v_load_deinterleave(o, overlay[0], overlay[1], overlay[2], overlay[3]);
+    }
+
+    cv::v_uint16x8 saLo = vOpacity, saHi = vOpacity;
+
+    if (OC == 4) {
+      cv::v_expand(overlay[3], saLo, saHi);
+      saLo = v_div255(saLo * vOpacity);
+      saHi = v_div255(saHi * vOpacity);
+    }
+
+    for (int c = 0; c < 3; ++c) {
+      cv::v_uint16x8 sLo, sHi, dLo, dHi;
+
+      cv::v_expand(overlay[c], sLo, sHi);
+      cv::v_expand(base[c], dLo, dHi);
+
+      base[c] = cv::v_pack(v_compositeChannel<Blend>(sLo, dLo, saLo), v_compositeChannel<Blend>(sHi, dHi, saHi));
+    }
+
+    cv::v_store_interleave(b, base[0], base[1], base[2]);
+  }
+
+  return x;
+}
+
+#endif
+
+/**
+ * Blends the overlay onto the base in-place, one stripe of rows per job.
+ */
+template<int BC, int OC, int Blend>
+class CompositeBody : public cv::ParallelLoopBody {
+
+public:
+
+  CompositeBody(cv::Mat& base, const cv::Mat& overlay, int opacity)
+    : base(base)
+    , overlay(overlay)
+    , opacity(opacity)
+    , reciprocals(compositeReciprocals()) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    for (int row = range.start; row < range.end; ++row) {
+      auto b = base.ptr<uchar>(row);
+      auto o = overlay.ptr<uchar>(row);
+      int col = 0;
+
+#if CV_SIMD128
+      if (BC == 3) {
+        col = compositeRowBGR<OC, Blend>(b, o, base.cols, opacity);
+      }
+#endif
+
+      for (b += BC * col, o += OC * col; col < base.cols; ++col, b += BC, o += OC) {
+        compositePixel<BC, OC, Blend>(b, o, opacity, reciprocals);
+      }
+    }
+  }
+
+private:
+
+  cv::Mat& base;
+  const cv::Mat& overlay;
+  int opacity;
+  const uint32_t* reciprocals;
+};
+
+template<int BC, int OC, int Blend>
+void runComposite(cv::Mat& base, const cv::Mat& overlay, int opacity) {
+  CompositeBody<BC, OC, Blend> body(base, overlay, opacity);
+  cv::parallel_for_(cv::Range(0, base.rows), body);
+}
+
+template<int BC, int OC>
+void runComposite(cv::Mat& base, const cv::Mat& overlay, int opacity, int blend) {
+  if (blend == BlendModeMultiply) {
+    runComposite<BC, OC, BlendModeMultiply>(base, overlay, opacity);
+  } else if (blend == BlendModeScreen) {
+    runComposite<BC, OC, BlendModeScreen>(base, overlay, opacity);
+  } else {
+    runComposite<BC, OC, BlendModeOver>(base, overlay, opacity);
+  }
+}
+
+template<int BC>
+void runComposite(cv::Mat& base, const cv::Mat& overlay, int opacity, int blend) {
+  if (overlay.channels() == 1) {
+    runComposite<BC, 1>(base, overlay, opacity, blend);
+  } else if (overlay.channels() == 3) {
+    runComposite<BC, 3>(base, overlay, opacity, blend);
+  } else {
+    runComposite<BC, 4>(base, overlay, opacity, blend);
+  }
+}
+
+/**
+ * composite(base, overlay)
+ * composite(base, overlay, callback)
+ * composite(base, overlay, {x?, y?, opacity?, blend?})
+ * composite(base, overlay, {x?, y?, opacity?, blend?}, callback)
+ *
+ * Modifies `base` in-place.
+ */
+NAN_METHOD(composite) {
+  if (info.Length() < 2 || info.Length() > 4) {
+    Nan::ThrowError("expected at least two arguments (base, overlay) and at most four arguments (base, overlay, opt, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (base) must be a Matrix");
+    return;
+  }
+
+  if (Matrix::isReadOnly(info[0])) {
+    Nan::ThrowError("first argument (base) is read-only");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[1])) {
+    Nan::ThrowError("second argument (overlay) must be a Matrix");
+    return;
+  }
+
+  auto overlay = Matrix::get(info[1]);
+  auto x = 0;
+  auto y = 0;
+  auto opacity = 1.0;
+  auto blend = BlendModeOver;
+
+  if (overlay.type() != ImageTypeGray && overlay.type() != ImageTypeBGR && overlay.type() != ImageTypeBGRA) {
+    Nan::ThrowError("second argument (overlay) must be a Gray, BGR or BGRA image");
+    return;
+  }
+
+  if (info.Length() >= 3 && info[2]->IsObject() && !info[2]->IsFunction()) {
+    auto opt = info[2];
+
+    if (has(opt, "x")) {
+      x = get<int>(opt, "x");
+    }
+
+    if (has(opt, "y")) {
+      y = get<int>(opt, "y");
+    }
+
+    if (has(opt, "opacity")) {
+      opacity = get<double>(opt, "opacity");
+
+      if (!(opacity >= 0 && opacity <= 1)) {
+        Nan::ThrowError("opacity must be between 0 and 1");
+        return;
+      }
+    }
+
+    if (has(opt, "blend")) {
+      std::string name(v8::String::Utf8Value(getValue(opt, "blend")->ToString()).operator*());
+
+      if (name == "over") {
+        blend = BlendModeOver;
+      } else if (name == "multiply") {
+        blend = BlendModeMultiply;
+      } else if (name == "screen") {
+        blend = BlendModeScreen;
+      } else {
+        Nan::ThrowError("blend must be one of ['over', 'multiply', 'screen']");
+        return;
+      }
+    }
+  }
+
+  auto baseType = Matrix::get(info[0]).type();
+
+  if (baseType != ImageTypeBGR && baseType != ImageTypeBGRA) {
+    Nan::ThrowError("first argument (base) must be a BGR or BGRA image");
+    return;
+  }
+
+  // A copy-on-write base gets its own data before the references below are taken.
+  auto base = Matrix::getWritable(info[0]);
+
+  // The overlay may be partially outside the base. Only the overlapping part is blended.
+  auto target = cv::Rect(x, y, overlay.cols, overlay.rows) & cv::Rect(0, 0, base.cols, base.rows);
+  auto fixedOpacity = cvRound(opacity * 255);
+
+  maybeAsyncOp<int>(info, [base, overlay, target, x, y, fixedOpacity, blend]() {
+    if (target.area() == 0) {
+      return 0;
+    }
+
+    cv::Mat baseRoi = base(target);
+    cv::Mat overlayRoi = overlay(target - cv::Point(x, y));
+
+    if (baseRoi.channels() == 4) {
+      runComposite<4>(baseRoi, overlayRoi, fixedOpacity, blend);
+    } else {
+      runComposite<3>(baseRoi, overlayRoi, fixedOpacity, blend);
+    }
+
+    return 0;
+  }, [](const int&) {
+    return Nan::Null();
+  });
+}
+
+#endif // SIMPLE_CV_COMPOSITE_H
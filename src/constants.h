@@ -8,9 +8,22 @@ static const int ImageTypeGray = CV_8UC1;
 static const int ImageTypeBGR = CV_8UC3;
 static const int ImageTypeBGRA = CV_8UC4;
 static const int ImageTypeFloat = CV_64F;
+static const int ImageTypeFloat32 = CV_32FC1;
+static const int ImageTypeBGRFloat32 = CV_32FC3;
+static const int ImageTypeBGRAFloat32 = CV_32FC4;
+static const int ImageTypeGray16 = CV_16UC1;
+static const int ImageTypeBGR16 = CV_16UC3;
+static const int ImageTypeBGRA16 = CV_16UC4;
 
 static const int EncodeTypePNG = 0;
 static const int EncodeTypeJPEG = 1;
+static const int EncodeTypeWebP = 2;
+
+static const int YUVFormatNV12 = 0;
+static const int YUVFormatNV21 = 1;
+static const int YUVFormatI420 = 2;
+static const int YUVFormatYUYV = 3;
+static const int YUVFormatUYVY = 4;
 
 static const int ChannelGray = 0;
 static const int ChannelRed = 1;
@@ -25,6 +38,11 @@ static const int BorderTypeReflect101 = cv::BORDER_REFLECT101;
 static const int BorderTypeWrap = cv::BORDER_WRAP;
 static const int BorderTypeConstant = cv::BORDER_CONSTANT;
 
+static const int InterpolationNearest = cv::INTER_NEAREST;
+static const int InterpolationLinear = cv::INTER_LINEAR;
+static const int InterpolationCubic = cv::INTER_CUBIC;
+static const int InterpolationLanczos4 = cv::INTER_LANCZOS4;
+
 static const int ConversionBGRToGray = cv::COLOR_BGR2GRAY;
 static const int ConversionGrayToBGR = cv::COLOR_GRAY2BGR;
 static const int ConversionBGRToYCrCb = cv::COLOR_BGR2YCrCb;
@@ -32,20 +50,53 @@ static const int ConversionYCrCbToBGR =  cv::COLOR_YCrCb2BGR;
 static const int ConversionBGRToHSV = cv::COLOR_BGR2HSV;
 static const int ConversionHSVToBGR =  cv::COLOR_HSV2BGR;
 
+static inline bool isImageType(int type) {
+  return type == ImageTypeGray
+    || type == ImageTypeBGR
+    || type == ImageTypeBGRA
+    || type == ImageTypeFloat
+    || type == ImageTypeFloat32
+    || type == ImageTypeBGRFloat32
+    || type == ImageTypeBGRAFloat32
+    || type == ImageTypeGray16
+    || type == ImageTypeBGR16
+    || type == ImageTypeBGRA16;
+}
+
+static inline bool isInterpolation(int interpolation) {
+  return interpolation == InterpolationNearest
+    || interpolation == InterpolationLinear
+    || interpolation == InterpolationCubic
+    || interpolation == InterpolationLanczos4;
+}
+
+static const char* const ImageTypeNames = "[cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA, cv.ImageType.Float, "
+  "cv.ImageType.Float32, cv.ImageType.BGRFloat32, cv.ImageType.BGRAFloat32, "
+  "cv.ImageType.Gray16, cv.ImageType.BGR16, cv.ImageType.BGRA16]";
+
 NAN_MODULE_INIT(initConstants) {
   auto ImageType = Nan::New<v8::Object>();
   auto EncodeType = Nan::New<v8::Object>();
   auto BorderType = Nan::New<v8::Object>();
   auto Channel = Nan::New<v8::Object>();
   auto Conversion = Nan::New<v8::Object>();
+  auto Interpolation = Nan::New<v8::Object>();
+  auto YUVFormat = Nan::New<v8::Object>();
 
   Nan::Set(ImageType, Nan::New("Gray").ToLocalChecked(), Nan::New(ImageTypeGray));
   Nan::Set(ImageType, Nan::New("BGR").ToLocalChecked(), Nan::New(ImageTypeBGR));
   Nan::Set(ImageType, Nan::New("BGRA").ToLocalChecked(), Nan::New(ImageTypeBGRA));
   Nan::Set(ImageType, Nan::New("Float").ToLocalChecked(), Nan::New(ImageTypeFloat));
+  Nan::Set(ImageType, Nan::New("Float32").ToLocalChecked(), Nan::New(ImageTypeFloat32));
+  Nan::Set(ImageType, Nan::New("BGRFloat32").ToLocalChecked(), Nan::New(ImageTypeBGRFloat32));
+  Nan::Set(ImageType, Nan::New("BGRAFloat32").ToLocalChecked(), Nan::New(ImageTypeBGRAFloat32));
+  Nan::Set(ImageType, Nan::New("Gray16").ToLocalChecked(), Nan::New(ImageTypeGray16));
+  Nan::Set(ImageType, Nan::New("BGR16").ToLocalChecked(), Nan::New(ImageTypeBGR16));
+  Nan::Set(ImageType, Nan::New("BGRA16").ToLocalChecked(), Nan::New(ImageTypeBGRA16));
 
   Nan::Set(EncodeType, Nan::New("PNG").ToLocalChecked(), Nan::New(EncodeTypePNG));
   Nan::Set(EncodeType, Nan::New("JPEG").ToLocalChecked(), Nan::New(EncodeTypeJPEG));
+  Nan::Set(EncodeType, Nan::New("WebP").ToLocalChecked(), Nan::New(EncodeTypeWebP));
 
   Nan::Set(BorderType, Nan::New("Replicate").ToLocalChecked(), Nan::New(BorderTypeReplicate));
   Nan::Set(BorderType, Nan::New("Reflect").ToLocalChecked(), Nan::New(BorderTypeReflect));
@@ -67,11 +118,24 @@ NAN_MODULE_INIT(initConstants) {
   Nan::Set(Conversion, Nan::New("BGRToHSV").ToLocalChecked(), Nan::New(ConversionBGRToHSV));
   Nan::Set(Conversion, Nan::New("HSVToBGR").ToLocalChecked(), Nan::New(ConversionHSVToBGR));
 
+  Nan::Set(Interpolation, Nan::New("Nearest").ToLocalChecked(), Nan::New(InterpolationNearest));
+  Nan::Set(Interpolation, Nan::New("Linear").ToLocalChecked(), Nan::New(InterpolationLinear));
+  Nan::Set(Interpolation, Nan::New("Cubic").ToLocalChecked(), Nan::New(InterpolationCubic));
+  Nan::Set(Interpolation, Nan::New("Lanczos4").ToLocalChecked(), Nan::New(InterpolationLanczos4));
+
+  Nan::Set(YUVFormat, Nan::New("NV12").ToLocalChecked(), Nan::New(YUVFormatNV12));
+  Nan::Set(YUVFormat, Nan::New("NV21").ToLocalChecked(), Nan::New(YUVFormatNV21));
+  Nan::Set(YUVFormat, Nan::New("I420").ToLocalChecked(), Nan::New(YUVFormatI420));
+  Nan::Set(YUVFormat, Nan::New("YUYV").ToLocalChecked(), Nan::New(YUVFormatYUYV));
+  Nan::Set(YUVFormat, Nan::New("UYVY").ToLocalChecked(), Nan::New(YUVFormatUYVY));
+
   Nan::Set(target, Nan::New("ImageType").ToLocalChecked(), ImageType);
   Nan::Set(target, Nan::New("EncodeType").ToLocalChecked(), EncodeType);
   Nan::Set(target, Nan::New("BorderType").ToLocalChecked(), BorderType);
   Nan::Set(target, Nan::New("Channel").ToLocalChecked(), Channel);
   Nan::Set(target, Nan::New("Conversion").ToLocalChecked(), Conversion);
+  Nan::Set(target, Nan::New("Interpolation").ToLocalChecked(), Interpolation);
+  Nan::Set(target, Nan::New("YUVFormat").ToLocalChecked(), YUVFormat);
 }
 
 #endif //SIMPLE_CV_CONSTANTS_H
@@ -0,0 +1,78 @@
+#ifndef SIMPLE_CV_CREATE_VIDEO_WRITER_H
+#define SIMPLE_CV_CREATE_VIDEO_WRITER_H
+
+#include "VideoWriter.h"
+#include "async.h"
+#include "utils.h"
+
+/**
+ * createVideoWriter(filePath, {size, fps?, fourcc?, isColor?, queueSize?})
+ * createVideoWriter(filePath, {size, fps?, fourcc?, isColor?, queueSize?}, callback)
+ */
+NAN_METHOD(createVideoWriter) {
+  if (info.Length() < 2 || info.Length() > 3) {
+    Nan::ThrowError("expected at least two arguments (filePath, opt) and at most three arguments (filePath, opt, callback)");
+    return;
+  }
+
+  if (!info[0]->IsString()) {
+    Nan::ThrowError("first argument (filePath) must be a string");
+    return;
+  }
+
+  auto opt = info[1];
+
+  if (!opt->IsObject() || opt->IsFunction() || !has(opt, "size") || !isSize(getValue(opt, "size"))) {
+    Nan::ThrowError("second argument (opt) must be an object {size, fps?, fourcc?, isColor?, queueSize?}");
+    return;
+  }
+
+  auto size = getSize<int>(getValue(opt, "size"));
+  auto fps = 30.0;
+  auto fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+  auto isColor = true;
+  auto queueSize = 8;
+
+  if (has(opt, "fps")) {
+    fps = get<double>(opt, "fps");
+  }
+
+  if (has(opt, "fourcc")) {
+    std::string code(v8::String::Utf8Value(getValue(opt, "fourcc")->ToString()).operator*());
+
+    if (code.size() != 4) {
+      Nan::ThrowError("fourcc must be a string of four characters, for example 'mp4v' or 'MJPG'");
+      return;
+    }
+
+    fourcc = cv::VideoWriter::fourcc(code[0], code[1], code[2], code[3]);
+  }
+
+  if (has(opt, "isColor")) {
+    isColor = Nan::To<bool>(getValue(opt, "isColor")).FromJust();
+  }
+
+  if (has(opt, "queueSize")) {
+    queueSize = get<int>(opt, "queueSize");
+  }
+
+  if (size.width <= 0 || size.height <= 0 || fps <= 0 || queueSize < 1) {
+    Nan::ThrowError("size, fps and queueSize must be positive");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  std::string filePath(v8::String::Utf8Value(info[0]->ToString()).operator*());
+
+  maybeAsyncOp<std::shared_ptr<VideoSink>>(info, [filePath, fourcc, fps, size, isColor, queueSize]() {
+    return std::make_shared<VideoSink>(filePath, fourcc, fps, size, isColor, static_cast<size_t>(queueSize));
+  }, [](const std::shared_ptr<VideoSink>& sink) {
+    return VideoWriter::create(sink);
+  });
+}
+
+#endif // SIMPLE_CV_CREATE_VIDEO_WRITER_H
@@ -0,0 +1,78 @@
+#ifndef SIMPLE_CV_CREATE_WARP_H
+#define SIMPLE_CV_CREATE_WARP_H
+
+#include <climits>
+
+#include "Warp.h"
+#include "async.h"
+#include "utils.h"
+
+/**
+ * createWarp(transformation, {srcSize, dstSize?, interpolation?, borderType?, borderValue?})
+ * createWarp(transformation, {srcSize, dstSize?, interpolation?, borderType?, borderValue?}, callback)
+ */
+NAN_METHOD(createWarp) {
+  if (info.Length() < 2 || info.Length() > 3) {
+    Nan::ThrowError("expected at least two arguments (transformation, opt) and at most three arguments (transformation, opt, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (transformation) must be a Matrix");
+    return;
+  }
+
+  cv::Mat trans = Matrix::get(info[0]);
+
+  if (!isAffineTransformation(trans)) {
+    Nan::ThrowError("first argument (transformation) must be a 3x2 float matrix");
+    return;
+  }
+
+  if (!info[1]->IsObject() || info[1]->IsFunction()) {
+    Nan::ThrowError("second argument (opt) must be an object");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  auto opt = info[1];
+  WarpOptions options;
+  cv::Size srcSize;
+
+  if (!has(opt, "srcSize") || !getWarpSize(opt, "srcSize", srcSize)) {
+    Nan::ThrowError("srcSize must be a size {width, height} with a positive width and height");
+    return;
+  }
+
+  cv::Size dstSize = srcSize;
+
+  if (!getWarpSize(opt, "dstSize", dstSize)) {
+    Nan::ThrowError("dstSize must be a size {width, height} with a positive width and height");
+    return;
+  }
+
+  auto error = getWarpOptions(opt, options);
+
+  if (error) {
+    Nan::ThrowError(error);
+    return;
+  }
+
+  // The source coordinates are stored as 16 bit integers.
+  if (srcSize.width > SHRT_MAX || srcSize.height > SHRT_MAX) {
+    Nan::ThrowError("srcSize must not be larger than 32767x32767");
+    return;
+  }
+
+  maybeAsyncOp<std::shared_ptr<WarpMaps>>(info, [trans, srcSize, dstSize, options]() {
+    return createWarpMaps(trans, srcSize, dstSize, options);
+  }, [](const std::shared_ptr<WarpMaps>& maps) {
+    return Warp::create(maps);
+  });
+}
+
+#endif // SIMPLE_CV_CREATE_WARP_H
@@ -3,15 +3,22 @@
 
 #include "Matrix.h"
 #include "async.h"
+#include "utils.h"
+#include "orientation.h"
+#include "imageCache.h"
 
 /**
  * decodeImage(image)
  * decodeImage(image, callback)
  * decodeImage(image, decodeType)
  * decodeImage(image, decodeType, callback)
+ * decodeImage(image, {type?, autoOrient?, cache?})
+ * decodeImage(image, {type?, autoOrient?, cache?}, callback)
  */
 NAN_METHOD(decodeImage) {
   int decodeType = cv::IMREAD_UNCHANGED;
+  bool autoOrient = false;
+  bool cache = false;
 
   if (info.Length() < 1 || info.Length() > 3) {
     Nan::ThrowError("expected at least one argument (data) and at most three arguments (data, decodeType, callback)");
@@ -24,8 +31,29 @@ NAN_METHOD(decodeImage) {
   }
 
   if (info.Length() >= 2) {
-    if (info[1]->IsInt32()) {
-      int depth = Nan::To<int>(info[1]).FromJust();
+    auto type = info[1];
+    bool typeRequired = true;
+
+    if (info[1]->IsObject() && !info[1]->IsFunction()) {
+      auto opt = info[1];
+
+      if (has(opt, "autoOrient")) {
+        autoOrient = Nan::To<bool>(getValue(opt, "autoOrient")).FromJust();
+      }
+
+      if (has(opt, "cache")) {
+        cache = Nan::To<bool>(getValue(opt, "cache")).FromJust();
+      }
+
+      if (has(opt, "type")) {
+        type = getValue(opt, "type");
+      } else {
+        typeRequired = false;
+      }
+    }
+
+    if (type->IsInt32()) {
+      int depth = Nan::To<int>(type).FromJust();
 
       if (depth == ImageTypeGray) {
         decodeType = cv::IMREAD_GRAYSCALE;
@@ -33,12 +61,16 @@ NAN_METHOD(decodeImage) {
         decodeType = cv::IMREAD_COLOR;
       } else if (depth == ImageTypeBGRA) {
         decodeType = cv::IMREAD_UNCHANGED;
+      } else if (depth == ImageTypeGray16) {
+        decodeType = cv::IMREAD_GRAYSCALE | cv::IMREAD_ANYDEPTH;
+      } else if (depth == ImageTypeBGR16) {
+        decodeType = cv::IMREAD_COLOR | cv::IMREAD_ANYDEPTH;
       } else {
-        Nan::ThrowError("second argument (decodeType) must be a one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA]");
+        Nan::ThrowError("second argument (decodeType) must be a one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA, cv.ImageType.Gray16, cv.ImageType.BGR16]");
         return;
       }
-    } else if (!info[1]->IsFunction()) {
-      Nan::ThrowError("second argument (decodeType) must be a one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA]");
+    } else if (typeRequired && !type->IsFunction()) {
+      Nan::ThrowError("second argument (decodeType) must be a one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA, cv.ImageType.Gray16, cv.ImageType.BGR16]");
       return;
     }
   }
@@ -52,16 +84,32 @@ NAN_METHOD(decodeImage) {
   auto size = node::Buffer::Length(info[0]);
   std::vector<uchar> data(bytes, bytes + size);
 
-  maybeAsyncOp<cv::Mat>(info, [data, decodeType]() {
-    auto image = cv::imdecode(data, decodeType);
+  maybeAsyncOp<cv::Mat>(info, [data, decodeType, autoOrient, cache]() {
+    auto key = cache ? ImageCache::dataKey(data, decodeType, autoOrient) : std::string();
 
-    if (image.empty()) {
-      throw std::runtime_error("invalid image data");
-    }
+    return cachedImage(key, [&data, decodeType, autoOrient]() {
+      // See readImage.
+      auto flags = autoOrient && decodeType != cv::IMREAD_UNCHANGED ? decodeType | cv::IMREAD_IGNORE_ORIENTATION : decodeType;
+      auto image = cv::imdecode(data, flags);
+
+      if (image.empty()) {
+        throw std::runtime_error("invalid image data");
+      }
+
+      if (autoOrient) {
+        BufferImageSource source(data.data(), data.size());
+        applyOrientation(image, readOrientation(source));
+      }
+
+      // See readImage.
+      if (decodeType != cv::IMREAD_UNCHANGED && (decodeType & cv::IMREAD_ANYDEPTH) && image.depth() == CV_8U) {
+        image.convertTo(image, CV_16U, 257);
+      }
 
-    return image;
-  }, [](const cv::Mat& result) {
-    return Matrix::create(result);
+      return image;
+    });
+  }, [cache](const cv::Mat& result) {
+    return Matrix::create(result, cache);
   });
 }
 
@@ -15,6 +15,11 @@ NAN_METHOD(drawLine) {
     return;
   }
 
+  if (Matrix::isReadOnly(info[0])) {
+    Nan::ThrowError("first argument (image) is read-only");
+    return;
+  }
+
   if (!isPoint(info[1])) {
     Nan::ThrowError("second argument (point1) must be a point");
     return;
@@ -30,7 +35,7 @@ NAN_METHOD(drawLine) {
     return;
   }
 
-  auto image = Matrix::get(info[0]);
+  auto image = Matrix::getWritable(info[0]);
   auto point1 = getPoint<int>(info[1]);
   auto point2 = getPoint<int>(info[2]);
   auto color = getColor<int>(info[3]);
@@ -15,6 +15,11 @@ NAN_METHOD(drawRectangle) {
     return;
   }
 
+  if (Matrix::isReadOnly(info[0])) {
+    Nan::ThrowError("first argument (image) is read-only");
+    return;
+  }
+
   if (!isRect(info[1])) {
     Nan::ThrowError("second argument (rect) must be a rectangle");
     return;
@@ -25,7 +30,7 @@ NAN_METHOD(drawRectangle) {
     return;
   }
 
-  auto image = Matrix::get(info[0]);
+  auto image = Matrix::getWritable(info[0]);
   auto rect = getRect<int>(info[1]);
   auto color = getColor<int>(info[2]);
   auto width = 1;
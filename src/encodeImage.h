@@ -3,13 +3,150 @@
 
 #include "Matrix.h"
 #include "async.h"
+#include "utils.h"
+
+// The smallest size `downscale` shrinks an image to before giving up.
+static const int EncodeMinDownscaleSize = 16;
+
+struct EncodeOptions {
+  int type;
+  int quality;
+  int minQuality;
+  double maxBytes;
+  bool downscale;
+
+  EncodeOptions()
+    : type(EncodeTypePNG)
+    , quality(-1)
+    , minQuality(10)
+    , maxBytes(0)
+    , downscale(false) {
+  }
+};
+
+struct EncodeResult {
+  std::vector<uchar> data;
+  int quality;
+  int width;
+  int height;
+
+  EncodeResult()
+    : quality(-1)
+    , width(0)
+    , height(0) {
+  }
+};
+
+/**
+ * Encodes `image` into `data`. `data` keeps its capacity between calls
+ * so that repeated attempts don't reallocate. A negative quality uses
+ * the encoder's default.
+ */
+void encodeWithQuality(const cv::Mat& image, int type, int quality, std::vector<uchar>& data) {
+  std::vector<int> params;
+
+  if (type == EncodeTypeJPEG) {
+    if (quality >= 0) {
+      params.push_back(cv::IMWRITE_JPEG_QUALITY);
+      params.push_back(quality);
+    }
+
+    cv::imencode(".jpg", image, data, params);
+  } else if (type == EncodeTypeWebP) {
+    if (quality >= 0) {
+      params.push_back(cv::IMWRITE_WEBP_QUALITY);
+      params.push_back(quality);
+    }
+
+    cv::imencode(".webp", image, data, params);
+  } else {
+    cv::imencode(".png", image, data);
+  }
+}
+
+/**
+ * Binary searches the highest quality between `minQuality` and `maxQuality` whose output
+ * fits into `maxBytes`. Returns false if not even `minQuality` fits.
+ */
+bool encodeToSize(const cv::Mat& image, const EncodeOptions& opt, int maxQuality, std::vector<uchar>& attempt, EncodeResult& result) {
+  auto low = opt.minQuality;
+  auto high = maxQuality;
+  auto found = false;
+
+  while (low <= high) {
+    auto quality = (low + high) / 2;
+    encodeWithQuality(image, opt.type, quality, attempt);
+
+    if (attempt.size() <= opt.maxBytes) {
+      // The previous best buffer becomes the next attempt buffer.
+      std::swap(result.data, attempt);
+      result.quality = quality;
+      found = true;
+      low = quality + 1;
+    } else {
+      high = quality - 1;
+    }
+  }
+
+  return found;
+}
+
+EncodeResult encodeImageToSize(const cv::Mat& image, const EncodeOptions& opt) {
+  EncodeResult result;
+  std::vector<uchar> attempt;
+  cv::Mat current = image;
+  auto maxQuality = opt.quality >= 0 ? opt.quality : 100;
+
+  while (true) {
+    if (encodeToSize(current, opt, maxQuality, attempt, result)) {
+      result.width = current.cols;
+      result.height = current.rows;
+      return result;
+    }
+
+    if (!opt.downscale) {
+      break;
+    }
+
+    // `attempt` holds the output of the lowest quality. The encoded size is roughly
+    // proportional to the pixel count, so scale the area by the overshoot ratio.
+    auto scale = std::sqrt(opt.maxBytes / attempt.size()) * 0.95;
+    scale = std::min(std::max(scale, 0.5), 0.9);
+
+    auto size = cv::Size(
+      static_cast<int>(std::round(current.cols * scale)),
+      static_cast<int>(std::round(current.rows * scale))
+    );
+
+    if (size.width < EncodeMinDownscaleSize || size.height < EncodeMinDownscaleSize) {
+      break;
+    }
+
+    cv::Mat resized;
+    cv::resize(current, resized, size, 0, 0, cv::INTER_AREA);
+    current = resized;
+  }
+
+  throw std::runtime_error("could not encode the image into " + std::to_string(static_cast<long long>(opt.maxBytes)) + " bytes");
+}
+
+bool isEncodeType(v8::Local<v8::Value> value) {
+  if (!value->IsInt32()) {
+    return false;
+  }
+
+  auto type = Nan::To<int>(value).FromJust();
+  return type == EncodeTypeJPEG || type == EncodeTypePNG || type == EncodeTypeWebP;
+}
 
 /**
- * encodeImage(image, type, callback)
  * encodeImage(image, type)
+ * encodeImage(image, type, callback)
+ * encodeImage(image, {type, quality?, maxBytes?, minQuality?, downscale?})
+ * encodeImage(image, {type, quality?, maxBytes?, minQuality?, downscale?}, callback)
  */
 NAN_METHOD(encodeImage) {
-  int type;
+  EncodeOptions opt;
 
   if (info.Length() < 2 || info.Length() > 3) {
     Nan::ThrowError("expected at least two arguments (image, type) and at most three arguments (image, type, callback)");
@@ -21,15 +158,55 @@ NAN_METHOD(encodeImage) {
     return;
   }
 
-  if (info[1]->IsInt32()) {
-    type = Nan::To<int>(info[1]).FromJust();
+  if (info[1]->IsObject() && !info[1]->IsFunction()) {
+    auto obj = info[1];
+
+    if (!has(obj, "type") || !isEncodeType(getValue(obj, "type"))) {
+      Nan::ThrowError("type must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG, cv.EncodeType.WebP]");
+      return;
+    }
+
+    opt.type = get<int>(obj, "type");
+
+    if (has(obj, "quality")) {
+      opt.quality = get<int>(obj, "quality");
+    }
+
+    if (has(obj, "minQuality")) {
+      opt.minQuality = get<int>(obj, "minQuality");
+    }
+
+    if (has(obj, "maxBytes")) {
+      opt.maxBytes = get<double>(obj, "maxBytes");
+
+      if (!(opt.maxBytes >= 1)) {
+        Nan::ThrowError("maxBytes must be a positive number");
+        return;
+      }
+    }
+
+    if (has(obj, "downscale")) {
+      opt.downscale = get<bool>(obj, "downscale");
+    }
+
+    if ((has(obj, "quality") || opt.maxBytes > 0) && opt.type == EncodeTypePNG) {
+      Nan::ThrowError("quality and maxBytes are only supported for cv.EncodeType.JPEG and cv.EncodeType.WebP");
+      return;
+    }
+
+    if ((has(obj, "quality") && (opt.quality < 1 || opt.quality > 100)) || opt.minQuality < 1 || opt.minQuality > 100) {
+      Nan::ThrowError("quality and minQuality must be between 1 and 100");
+      return;
+    }
 
-    if (type != EncodeTypeJPEG && type != EncodeTypePNG) {
-      Nan::ThrowError("second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG]");
+    if (opt.quality >= 0 && opt.minQuality > opt.quality) {
+      Nan::ThrowError("minQuality must not be greater than quality");
       return;
     }
+  } else if (isEncodeType(info[1])) {
+    opt.type = Nan::To<int>(info[1]).FromJust();
   } else {
-    Nan::ThrowError("second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG]");
+    Nan::ThrowError("second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG, cv.EncodeType.WebP]");
     return;
   }
 
@@ -39,19 +216,31 @@ NAN_METHOD(encodeImage) {
   }
 
   cv::Mat image = Matrix::get(info[0]);
+  auto toSize = opt.maxBytes > 0;
 
-  maybeAsyncOp<std::vector<uchar>>(info, [type, image]() {
-    std::vector<uchar> data;
+  maybeAsyncOp<EncodeResult>(info, [opt, image, toSize]() {
+    if (toSize) {
+      return encodeImageToSize(image, opt);
+    }
 
-    if (type == EncodeTypeJPEG) {
-      cv::imencode(".jpg", image, data);
-    } else {
-      cv::imencode(".png", image, data);
+    EncodeResult result;
+    encodeWithQuality(image, opt.type, opt.quality, result.data);
+    return result;
+  }, [toSize](const EncodeResult& result) -> v8::Local<v8::Value> {
+    auto buffer = Nan::CopyBuffer(reinterpret_cast<const char*>(result.data.data()), static_cast<unsigned>(result.data.size())).ToLocalChecked();
+
+    if (!toSize) {
+      return buffer;
     }
 
-    return data;
-  }, [](const std::vector<uchar>& data) {
-    return Nan::CopyBuffer(reinterpret_cast<const char*>(data.data()), static_cast<unsigned>(data.size())).ToLocalChecked();
+    auto obj = Nan::New<v8::Object>();
+
+    Nan::Set(obj, Nan::New("data").ToLocalChecked(), buffer);
+    Nan::Set(obj, Nan::New("quality").ToLocalChecked(), Nan::New(result.quality));
+    Nan::Set(obj, Nan::New("width").ToLocalChecked(), Nan::New(result.width));
+    Nan::Set(obj, Nan::New("height").ToLocalChecked(), Nan::New(result.height));
+
+    return obj;
   });
 }
 
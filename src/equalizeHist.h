@@ -0,0 +1,118 @@
+#ifndef SIMPLE_CV_EQUALIZE_HIST_H
+#define SIMPLE_CV_EQUALIZE_HIST_H
+
+#include "Matrix.h"
+#include "async.h"
+#include "utils.h"
+
+static const int EqualizeModeLuminance = 0;
+static const int EqualizeModePerChannel = 1;
+
+/**
+ * Applies a single channel equalization to an image. In luminance mode only the Y channel
+ * of YCrCb is equalized which keeps the colors intact. In per channel mode the blue, green
+ * and red channels are equalized separately. The alpha channel is never touched.
+ */
+template<typename Equalize>
+cv::Mat equalizeChannels(const cv::Mat& image, int mode, Equalize equalize) {
+  cv::Mat output;
+
+  if (image.channels() == 1) {
+    equalize(image, output);
+    return output;
+  }
+
+  cv::Mat bgr = image;
+  cv::Mat alpha;
+  std::vector<cv::Mat> channels;
+
+  if (image.channels() == 4) {
+    cv::extractChannel(image, alpha, 3);
+    cv::cvtColor(image, bgr, cv::COLOR_BGRA2BGR);
+  }
+
+  if (mode == EqualizeModeLuminance) {
+    cv::cvtColor(bgr, output, cv::COLOR_BGR2YCrCb);
+    cv::split(output, channels);
+    equalize(channels[0].clone(), channels[0]);
+    cv::merge(channels, output);
+    cv::cvtColor(output, output, cv::COLOR_YCrCb2BGR);
+  } else {
+    cv::split(bgr, channels);
+
+    for (auto& channel : channels) {
+      equalize(channel.clone(), channel);
+    }
+
+    cv::merge(channels, output);
+  }
+
+  if (!alpha.empty()) {
+    cv::cvtColor(output, output, cv::COLOR_BGR2BGRA);
+    cv::insertChannel(alpha, output, 3);
+  }
+
+  return output;
+}
+
+/**
+ * Reads the `mode` option. Returns false if the value is invalid.
+ */
+bool getEqualizeMode(v8::Local<v8::Value> opt, int& mode) {
+  if (!opt->IsObject() || opt->IsFunction() || !has(opt, "mode")) {
+    return true;
+  }
+
+  std::string name(v8::String::Utf8Value(getValue(opt, "mode")->ToString()).operator*());
+
+  if (name == "luminance") {
+    mode = EqualizeModeLuminance;
+  } else if (name == "perChannel") {
+    mode = EqualizeModePerChannel;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * equalizeHist(image)
+ * equalizeHist(image, callback)
+ * equalizeHist(image, {mode?})
+ * equalizeHist(image, {mode?}, callback)
+ */
+NAN_METHOD(equalizeHist) {
+  if (info.Length() < 1 || info.Length() > 3) {
+    Nan::ThrowError("expected at least one argument (image) and at most three arguments (image, opt, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  auto image = Matrix::get(info[0]);
+  auto mode = EqualizeModeLuminance;
+
+  if (image.type() != ImageTypeGray && image.type() != ImageTypeBGR && image.type() != ImageTypeBGRA) {
+    Nan::ThrowError("first argument (image) must be a Gray, BGR or BGRA image");
+    return;
+  }
+
+  if (info.Length() >= 2 && !getEqualizeMode(info[1], mode)) {
+    Nan::ThrowError("mode must be one of ['luminance', 'perChannel']");
+    return;
+  }
+
+  maybeAsyncOp<cv::Mat>(info, [image, mode]() {
+    return equalizeChannels(image, mode, [](const cv::Mat& src, cv::Mat& dst) {
+      cv::equalizeHist(src, dst);
+    });
+  }, [](const cv::Mat& result) {
+    return Matrix::create(result);
+  });
+}
+
+#endif // SIMPLE_CV_EQUALIZE_HIST_H
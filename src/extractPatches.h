@@ -0,0 +1,342 @@
+#ifndef SIMPLE_CV_EXTRACT_PATCHES_H
+#define SIMPLE_CV_EXTRACT_PATCHES_H
+
+#include <cstring>
+#include <memory>
+#include <sstream>
+
+#include "Matrix.h"
+#include "async.h"
+#include "utils.h"
+
+static const int PatchLayoutNCHW = 0;
+static const int PatchLayoutNHWC = 1;
+
+static const int PatchTypeFloat32 = 0;
+static const int PatchTypeUint8 = 1;
+
+struct PatchOptions {
+  cv::Size size;
+  int layout;
+  int dtype;
+  bool rgb;
+  std::vector<float> mean;
+  std::vector<float> invStd;
+
+  PatchOptions()
+    : layout(PatchLayoutNCHW)
+    , dtype(PatchTypeFloat32)
+    , rgb(false) {
+  }
+};
+
+/**
+ * Crops, resizes, normalizes and packs each patch straight into its slice of the output
+ * tensor. The patches are independent so they are processed in parallel.
+ */
+template<typename T>
+class ExtractPatchesBody : public cv::ParallelLoopBody {
+
+public:
+
+  ExtractPatchesBody(const cv::Mat& image, const std::vector<cv::Rect>& rects, const PatchOptions& opt, T* output)
+    : image(image)
+    , rects(rects)
+    , opt(opt)
+    , output(output) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    const int channels = image.channels();
+    const int width = opt.size.width;
+    const int height = opt.size.height;
+    const size_t patchSize = static_cast<size_t>(width) * height * channels;
+
+    cv::Mat resized;
+    cv::Mat patch;
+
+    for (int i = range.start; i < range.end; ++i) {
+      auto roi = image(rects[i]);
+      auto shrink = roi.cols > width || roi.rows > height;
+
+      cv::resize(roi, resized, opt.size, 0, 0, shrink ? cv::INTER_AREA : cv::INTER_LINEAR);
+      resized.convertTo(patch, CV_MAKETYPE(CV_32F, channels));
+
+      T* out = output + patchSize * i;
+
+      for (int y = 0; y < height; ++y) {
+        auto p = patch.ptr<float>(y);
+
+        for (int x = 0; x < width; ++x, p += channels) {
+          for (int c = 0; c < channels; ++c) {
+            // BGR(A) -> RGB(A) when `rgb` is set.
+            auto src = opt.rgb && c < 3 && channels >= 3 ? 2 - c : c;
+            auto value = (p[src] - opt.mean[c]) * opt.invStd[c];
+
+            size_t index;
+
+            if (opt.layout == PatchLayoutNCHW) {
+              index = (static_cast<size_t>(c) * height + y) * width + x;
+            } else {
+              index = (static_cast<size_t>(y) * width + x) * channels + c;
+            }
+
+            out[index] = cv::saturate_cast<T>(value);
+          }
+        }
+      }
+    }
+  }
+
+private:
+
+  const cv::Mat& image;
+  const std::vector<cv::Rect>& rects;
+  const PatchOptions& opt;
+  T* output;
+};
+
+/**
+ * Reads a number or an array of one number per channel.
+ */
+bool getChannelValues(v8::Local<v8::Value> value, int channels, std::vector<float>& values) {
+  if (value->IsNumber()) {
+    values.assign(channels, static_cast<float>(Nan::To<double>(value).FromJust()));
+    return true;
+  }
+
+  if (!value->IsArray() || value.As<v8::Array>()->Length() != static_cast<uint32_t>(channels)) {
+    return false;
+  }
+
+  auto arr = value.As<v8::Array>();
+  values.clear();
+
+  for (unsigned i = 0; i < arr->Length(); ++i) {
+    auto item = Nan::Get(arr, i).ToLocalChecked();
+
+    if (!item->IsNumber()) {
+      return false;
+    }
+
+    values.push_back(static_cast<float>(Nan::To<double>(item).FromJust()));
+  }
+
+  return true;
+}
+
+/**
+ * extractPatches(image, rects, {size, layout?, mean?, std?, rgb?, dtype?, out?})
+ * extractPatches(image, rects, {size, layout?, mean?, std?, rgb?, dtype?, out?}, callback)
+ *
+ * Returns a Float32Array (or Uint8Array) of shape [rects.length, channels, height, width]
+ * or [rects.length, height, width, channels].
+ */
+NAN_METHOD(extractPatches) {
+  if (info.Length() < 3 || info.Length() > 4) {
+    Nan::ThrowError("expected at least three arguments (image, rects, opt) and at most four arguments (image, rects, opt, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  if (!info[1]->IsArray()) {
+    Nan::ThrowError("second argument (rects) must be an array of rectangles {x, y, width, height}");
+    return;
+  }
+
+  if (!info[2]->IsObject() || info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (opt) must be an object");
+    return;
+  }
+
+  if (info.Length() == 4 && !info[3]->IsFunction()) {
+    Nan::ThrowError("fourth argument (callback) must be a function");
+    return;
+  }
+
+  cv::Mat image = Matrix::get(info[0]);
+  auto rectArray = info[1].As<v8::Array>();
+  auto opt = info[2];
+  auto channels = image.channels();
+
+  PatchOptions patchOpt;
+  std::vector<cv::Rect> rects;
+
+  for (unsigned i = 0; i < rectArray->Length(); ++i) {
+    auto value = Nan::Get(rectArray, i).ToLocalChecked();
+
+    if (!isRect(value)) {
+      Nan::ThrowError("second argument (rects) must be an array of rectangles {x, y, width, height}");
+      return;
+    }
+
+    auto rect = getRect<int>(value);
+
+    if (!isInside(rect, image.size())) {
+      std::ostringstream msg;
+      msg << "rects[" << i << "] (x=" << rect.x << ".." << (static_cast<int64_t>(rect.x) + rect.width) << ", y=" << rect.y << ".." << (static_cast<int64_t>(rect.y) + rect.height) << ") must be a non-empty rectangle inside the image bounds (w=" << image.cols << ", h=" << image.rows << ")";
+      Nan::ThrowError(msg.str().c_str());
+      return;
+    }
+
+    rects.push_back(rect);
+  }
+
+  if (has(opt, "size") && isSize(getValue(opt, "size"))) {
+    patchOpt.size = getSize<int>(getValue(opt, "size"));
+  } else if (has(opt, "size") && getValue(opt, "size")->IsNumber()) {
+    auto size = get<int>(opt, "size");
+    patchOpt.size = cv::Size(size, size);
+  }
+
+  if (patchOpt.size.width <= 0 || patchOpt.size.height <= 0) {
+    Nan::ThrowError("size must be a positive number or a size {width, height}");
+    return;
+  }
+
+  if (has(opt, "layout")) {
+    std::string layout(v8::String::Utf8Value(getValue(opt, "layout")->ToString()).operator*());
+
+    if (layout == "NCHW") {
+      patchOpt.layout = PatchLayoutNCHW;
+    } else if (layout == "NHWC") {
+      patchOpt.layout = PatchLayoutNHWC;
+    } else {
+      Nan::ThrowError("layout must be one of ['NCHW', 'NHWC']");
+      return;
+    }
+  }
+
+  if (has(opt, "dtype")) {
+    std::string dtype(v8::String::Utf8Value(getValue(opt, "dtype")->ToString()).operator*());
+
+    if (dtype == "float32") {
+      patchOpt.dtype = PatchTypeFloat32;
+    } else if (dtype == "uint8") {
+      patchOpt.dtype = PatchTypeUint8;
+    } else {
+      Nan::ThrowError("dtype must be one of ['float32', 'uint8']");
+      return;
+    }
+  }
+
+  if (has(opt, "rgb")) {
+    patchOpt.rgb = get<bool>(opt, "rgb");
+  }
+
+  std::vector<float> stdDev(channels, 1.0f);
+  patchOpt.mean.assign(channels, 0.0f);
+
+  if ((has(opt, "mean") && !getChannelValues(getValue(opt, "mean"), channels, patchOpt.mean))
+      || (has(opt, "std") && !getChannelValues(getValue(opt, "std"), channels, stdDev))) {
+    Nan::ThrowError("mean and std must be numbers or arrays with one number per channel");
+    return;
+  }
+
+  for (auto value : stdDev) {
+    if (value == 0) {
+      Nan::ThrowError("std must not contain zeros");
+      return;
+    }
+
+    patchOpt.invStd.push_back(1.0f / value);
+  }
+
+  auto elemSize = patchOpt.dtype == PatchTypeFloat32 ? sizeof(float) : sizeof(uchar);
+
+  // Checked before the output is allocated. Dividing the limit by one factor at a time keeps
+  // the product from overflowing.
+  if (rects.size() > maxTypedArrayBytes() / elemSize / channels / patchOpt.size.width / patchOpt.size.height) {
+    std::ostringstream msg;
+    msg << "the output for " << rects.size() << " patches of " << patchOpt.size.width << "x" << patchOpt.size.height << " pixels is too large for a typed array";
+    Nan::ThrowError(msg.str().c_str());
+    return;
+  }
+
+  auto length = rects.size() * patchOpt.size.width * patchOpt.size.height * channels;
+  auto isAsync = info[info.Length() - 1]->IsFunction();
+  auto hasOut = has(opt, "out");
+  v8::Local<v8::TypedArray> output;
+
+  if (hasOut) {
+    auto out = getValue(opt, "out");
+    auto valid = patchOpt.dtype == PatchTypeFloat32 ? out->IsFloat32Array() : out->IsUint8Array();
+
+    if (!valid || out.As<v8::TypedArray>()->Length() != length) {
+      std::ostringstream msg;
+      msg << "out must be a " << (patchOpt.dtype == PatchTypeFloat32 ? "Float32Array" : "Uint8Array") << " with " << length << " elements";
+      Nan::ThrowError(msg.str().c_str());
+      return;
+    }
+
+    output = out.As<v8::TypedArray>();
+  } else {
+    auto buffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), length * elemSize);
+
+    if (patchOpt.dtype == PatchTypeFloat32) {
+      output = v8::Float32Array::New(buffer, 0, length);
+    } else {
+      output = v8::Uint8Array::New(buffer, 0, length);
+    }
+  }
+
+  // The workers write straight into the typed array's memory. The persistent handle
+  // keeps it alive until the callback has been called. A caller supplied `out` could
+  // be transferred to another thread while an asynchronous job runs, which would free
+  // its memory, so in that case the patches are written into a scratch buffer and
+  // copied into `out` on the main thread.
+  auto persistent = std::make_shared<Nan::Persistent<v8::TypedArray>>(output);
+  auto scratch = std::make_shared<std::vector<char>>(isAsync && hasOut ? length * elemSize : 0);
+  char* data;
+
+  if (!scratch->empty()) {
+    data = scratch->data();
+  } else if (patchOpt.dtype == PatchTypeFloat32) {
+    data = reinterpret_cast<char*>(*Nan::TypedArrayContents<float>(output));
+  } else {
+    data = reinterpret_cast<char*>(*Nan::TypedArrayContents<uint8_t>(output));
+  }
+
+  maybeAsyncOp<int>(info, [image, rects, patchOpt, data, persistent, scratch]() {
+    if (patchOpt.dtype == PatchTypeFloat32) {
+      ExtractPatchesBody<float> body(image, rects, patchOpt, reinterpret_cast<float*>(data));
+      cv::parallel_for_(cv::Range(0, static_cast<int>(rects.size())), body);
+    } else {
+      ExtractPatchesBody<uchar> body(image, rects, patchOpt, reinterpret_cast<uchar*>(data));
+      cv::parallel_for_(cv::Range(0, static_cast<int>(rects.size())), body);
+    }
+
+    return 0;
+  }, [persistent, scratch, patchOpt](const int&) {
+    auto output = Nan::New(*persistent);
+
+    if (!scratch->empty()) {
+      size_t byteLength;
+      void* target;
+
+      if (patchOpt.dtype == PatchTypeFloat32) {
+        Nan::TypedArrayContents<float> contents(output);
+        byteLength = contents.length() * sizeof(float);
+        target = *contents;
+      } else {
+        Nan::TypedArrayContents<uint8_t> contents(output);
+        byteLength = contents.length();
+        target = *contents;
+      }
+
+      if (byteLength != scratch->size()) {
+        throw std::runtime_error("out has been detached while the patches were extracted");
+      }
+
+      std::memcpy(target, scratch->data(), scratch->size());
+    }
+
+    return output;
+  });
+}
+
+#endif // SIMPLE_CV_EXTRACT_PATCHES_H
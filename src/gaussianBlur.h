@@ -5,6 +5,234 @@
 #include "async.h"
 #include "utils.h"
 
+static const int BlurMethodKernel = 0;
+static const int BlurMethodBox3 = 1;
+static const int BlurMethodIIR = 2;
+static const int BlurMethodAuto = 3;
+
+// `auto` switches from the kernel to the recursive filter at this sigma.
+static const double BlurAutoSigmaThreshold = 8.0;
+
+// Below this sigma the recursive filter coefficients no longer describe a smoothing filter.
+static const double BlurIIRMinSigma = 0.5;
+
+/**
+ * Coefficients of the Young - van Vliet recursive Gaussian filter.
+ * `b1`, `b2` and `b3` are already divided by `b0`.
+ */
+struct RecursiveGaussianCoefficients {
+  float B;
+  float b1;
+  float b2;
+  float b3;
+
+  RecursiveGaussianCoefficients(double sigma) {
+    double q;
+
+    if (sigma >= 2.5) {
+      q = 0.98711 * sigma - 0.96330;
+    } else {
+      q = 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+    }
+
+    double q2 = q * q;
+    double q3 = q2 * q;
+    double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+
+    b1 = static_cast<float>((2.44413 * q + 2.85619 * q2 + 1.26661 * q3) / b0);
+    b2 = static_cast<float>(-(1.4281 * q2 + 1.26661 * q3) / b0);
+    b3 = static_cast<float>(0.422205 * q3 / b0);
+    B = 1.0f - (b1 + b2 + b3);
+  }
+};
+
+/**
+ * Causal + anti-causal pass over each row and channel. The edges are
+ * initialized with the edge value.
+ */
+class RecursiveGaussianRowsBody : public cv::ParallelLoopBody {
+
+public:
+
+  RecursiveGaussianRowsBody(cv::Mat& mat, double sigma)
+    : mat(mat)
+    , c(sigma) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    int n = mat.cols;
+    int channels = mat.channels();
+
+    for (int row = range.start; row < range.end; ++row) {
+      float* p = mat.ptr<float>(row);
+
+      for (int k = 0; k < channels; ++k) {
+        float w1 = p[k], w2 = w1, w3 = w1;
+
+        for (int i = 0; i < n; ++i) {
+          float w = c.B * p[i * channels + k] + c.b1 * w1 + c.b2 * w2 + c.b3 * w3;
+          p[i * channels + k] = w;
+          w3 = w2; w2 = w1; w1 = w;
+        }
+
+        float y1 = p[(n - 1) * channels + k], y2 = y1, y3 = y1;
+
+        for (int i = n - 1; i >= 0; --i) {
+          float y = c.B * p[i * channels + k] + c.b1 * y1 + c.b2 * y2 + c.b3 * y3;
+          p[i * channels + k] = y;
+          y3 = y2; y2 = y1; y1 = y;
+        }
+      }
+    }
+  }
+
+private:
+
+  cv::Mat& mat;
+  RecursiveGaussianCoefficients c;
+};
+
+/**
+ * Column pass. Instead of walking each column separately, a strip of
+ * neighbouring columns is filtered together row by row, so the memory
+ * is accessed in order and the inner loop can be vectorized.
+ */
+class RecursiveGaussianColumnsBody : public cv::ParallelLoopBody {
+
+public:
+
+  static const int StripWidth = 64;
+
+  RecursiveGaussianColumnsBody(cv::Mat& mat, double sigma)
+    : mat(mat)
+    , c(sigma) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    int width = mat.cols * mat.channels();
+    float s1[StripWidth], s2[StripWidth], s3[StripWidth];
+
+    for (int strip = range.start; strip < range.end; ++strip) {
+      int start = strip * StripWidth;
+      int n = width - start < StripWidth ? width - start : StripWidth;
+
+      float* first = mat.ptr<float>(0) + start;
+
+      for (int j = 0; j < n; ++j) {
+        s1[j] = s2[j] = s3[j] = first[j];
+      }
+
+      for (int row = 0; row < mat.rows; ++row) {
+        float* p = mat.ptr<float>(row) + start;
+
+        for (int j = 0; j < n; ++j) {
+          float w = c.B * p[j] + c.b1 * s1[j] + c.b2 * s2[j] + c.b3 * s3[j];
+          p[j] = w;
+          s3[j] = s2[j]; s2[j] = s1[j]; s1[j] = w;
+        }
+      }
+
+      float* last = mat.ptr<float>(mat.rows - 1) + start;
+
+      for (int j = 0; j < n; ++j) {
+        s1[j] = s2[j] = s3[j] = last[j];
+      }
+
+      for (int row = mat.rows - 1; row >= 0; --row) {
+        float* p = mat.ptr<float>(row) + start;
+
+        for (int j = 0; j < n; ++j) {
+          float y = c.B * p[j] + c.b1 * s1[j] + c.b2 * s2[j] + c.b3 * s3[j];
+          p[j] = y;
+          s3[j] = s2[j]; s2[j] = s1[j]; s1[j] = y;
+        }
+      }
+    }
+  }
+
+private:
+
+  cv::Mat& mat;
+  RecursiveGaussianCoefficients c;
+};
+
+/**
+ * Filters each axis with the recursive filter if its sigma is at least `iirSigma` and with a
+ * one dimensional Gaussian kernel otherwise, so the axes can use different methods.
+ */
+cv::Mat recursiveGaussianBlur(const cv::Mat& image, double xSigma, double ySigma, double iirSigma = BlurIIRMinSigma) {
+  iirSigma = std::max(iirSigma, BlurIIRMinSigma);
+
+  cv::Mat output;
+  image.convertTo(output, CV_MAKETYPE(CV_32F, image.channels()));
+
+  if (xSigma >= iirSigma) {
+    RecursiveGaussianRowsBody rows(output, xSigma);
+    cv::parallel_for_(cv::Range(0, output.rows), rows);
+  } else {
+    cv::GaussianBlur(output, output, cv::Size(0, 1), xSigma, xSigma);
+  }
+
+  if (ySigma >= iirSigma) {
+    int width = output.cols * output.channels();
+    int strips = (width + RecursiveGaussianColumnsBody::StripWidth - 1) / RecursiveGaussianColumnsBody::StripWidth;
+
+    RecursiveGaussianColumnsBody columns(output, ySigma);
+    cv::parallel_for_(cv::Range(0, strips), columns);
+  } else {
+    cv::GaussianBlur(output, output, cv::Size(1, 0), ySigma, ySigma);
+  }
+
+  output.convertTo(output, image.type());
+  return output;
+}
+
+/**
+ * Widths of three box filters whose combination approximates
+ * a Gaussian with the given sigma.
+ */
+std::vector<int> gaussianBoxSizes(double sigma) {
+  const int n = 3;
+
+  int wl = static_cast<int>(std::floor(std::sqrt(12.0 * sigma * sigma / n + 1.0)));
+
+  if (wl % 2 == 0) {
+    --wl;
+  }
+
+  int wu = wl + 2;
+  int m = cvRound((12.0 * sigma * sigma - n * wl * wl - 4.0 * n * wl - 3.0 * n) / (-4.0 * wl - 4.0));
+
+  std::vector<int> sizes;
+
+  for (int i = 0; i < n; ++i) {
+    sizes.push_back(i < m ? wl : wu);
+  }
+
+  return sizes;
+}
+
+cv::Mat boxGaussianBlur(const cv::Mat& image, double xSigma, double ySigma) {
+  auto xSizes = gaussianBoxSizes(xSigma);
+  auto ySizes = gaussianBoxSizes(ySigma);
+
+  // `cv::blur` uses running sums, so the cost doesn't depend on the box size.
+  // Working in floats avoids rounding the intermediate results.
+  cv::Mat output;
+  image.convertTo(output, CV_MAKETYPE(CV_32F, image.channels()));
+
+  for (int i = 0; i < 3; ++i) {
+    cv::blur(output, output, cv::Size(xSizes[i], ySizes[i]), cv::Point(-1, -1), cv::BORDER_REPLICATE);
+  }
+
+  output.convertTo(output, image.type());
+  return output;
+}
+
+/**
+ * gaussianBlur(image, {kernelSize?, sigma?, xSigma?, ySigma?, method?})
+ * gaussianBlur(image, {kernelSize?, sigma?, xSigma?, ySigma?, method?}, callback)
+ */
 NAN_METHOD(gaussianBlur) {
   if (info.Length() < 2 || info.Length() > 3) {
     Nan::ThrowError("expected at least two argument (image, opt) and at most three arguments (image, opt, callback)");
@@ -20,11 +248,15 @@ NAN_METHOD(gaussianBlur) {
   auto kernelSize = cv::Size(3, 3);
   auto xSigma = 0.0;
   auto ySigma = 0.0;
+  auto method = BlurMethodKernel;
+  auto hasKernelSize = false;
 
   if (info[1]->IsObject() && !info[1]->IsFunction()) {
     auto opt = info[1];
 
     if (has(opt, "kernelSize")) {
+      hasKernelSize = true;
+
       if (isSize(getValue(opt, "kernelSize"))) {
         kernelSize = getSize<int>(getValue(opt, "kernelSize"));
       } else {
@@ -44,11 +276,63 @@ NAN_METHOD(gaussianBlur) {
     if (has(opt, "sigma")) {
       xSigma = ySigma = get<double>(opt, "sigma");
     }
+
+    if (has(opt, "method")) {
+      std::string name(v8::String::Utf8Value(getValue(opt, "method")->ToString()).operator*());
+
+      if (name == "kernel") {
+        method = BlurMethodKernel;
+      } else if (name == "box3") {
+        method = BlurMethodBox3;
+      } else if (name == "iir") {
+        method = BlurMethodIIR;
+      } else if (name == "auto") {
+        method = BlurMethodAuto;
+      } else {
+        Nan::ThrowError("method must be one of ['kernel', 'box3', 'iir', 'auto']");
+        return;
+      }
+
+      if (method != BlurMethodKernel && (xSigma <= 0 || ySigma <= 0)) {
+        Nan::ThrowError("sigma must be given and positive when method is 'box3', 'iir' or 'auto'");
+        return;
+      }
+
+      if (method == BlurMethodIIR && std::min(xSigma, ySigma) < BlurIIRMinSigma) {
+        Nan::ThrowError("sigma must be at least 0.5 when method is 'iir'");
+        return;
+      }
+    }
   }
 
-  maybeAsyncOp<cv::Mat>(info, [image, kernelSize, xSigma, ySigma]() {
+  auto iirSigma = BlurIIRMinSigma;
+
+  if (method == BlurMethodAuto) {
+    // The method is chosen for each axis. An axis with a small sigma uses the kernel.
+    if (std::max(xSigma, ySigma) >= BlurAutoSigmaThreshold) {
+      method = BlurMethodIIR;
+      iirSigma = BlurAutoSigmaThreshold;
+    } else {
+      method = BlurMethodKernel;
+
+      // Let OpenCV compute the kernel size from sigma.
+      if (!hasKernelSize) {
+        kernelSize = cv::Size(0, 0);
+      }
+    }
+  }
+
+  maybeAsyncOp<cv::Mat>(info, [image, kernelSize, xSigma, ySigma, method, iirSigma]() {
     cv::Mat output;
-    cv::GaussianBlur(image, output, kernelSize, xSigma, ySigma);
+
+    if (method == BlurMethodBox3) {
+      output = boxGaussianBlur(image, xSigma, ySigma);
+    } else if (method == BlurMethodIIR) {
+      output = recursiveGaussianBlur(image, xSigma, ySigma, iirSigma);
+    } else {
+      cv::GaussianBlur(image, output, kernelSize, xSigma, ySigma);
+    }
+
     return output;
   }, [](const cv::Mat& result) {
     return Matrix::create(result);
@@ -0,0 +1,199 @@
+#ifndef SIMPLE_CV_IMAGE_CACHE_H
+#define SIMPLE_CV_IMAGE_CACHE_H
+
+#include <sys/stat.h>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <sstream>
+
+#include <nan.h>
+#include <opencv2/opencv.hpp>
+
+struct ImageCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  size_t entries = 0;
+  size_t bytes = 0;
+  size_t limit = 0;
+};
+
+/**
+ * Process wide LRU cache of decoded images with a byte budget. The cache is
+ * disabled until a limit is set with `setImageCacheLimit`.
+ *
+ * The cached `cv::Mat`s are reference counted, so an evicted image stays
+ * alive for as long as some `Matrix` still uses it.
+ */
+class ImageCache {
+
+public:
+
+  static ImageCache& instance() {
+    static ImageCache cache;
+    return cache;
+  }
+
+  void setLimit(size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.limit = limit;
+    evict();
+  }
+
+  bool get(const std::string& key, cv::Mat& mat) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+
+    if (it == index.end()) {
+      ++stats.misses;
+      return false;
+    }
+
+    // Move to the front of the list.
+    entries.splice(entries.begin(), entries, it->second);
+    mat = it->second->second;
+    ++stats.hits;
+
+    return true;
+  }
+
+  void put(const std::string& key, const cv::Mat& mat) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto size = byteSize(mat);
+
+    if (size > stats.limit || index.count(key)) {
+      return;
+    }
+
+    entries.emplace_front(key, mat);
+    index[key] = entries.begin();
+    stats.bytes += size;
+
+    evict();
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    stats.bytes = 0;
+  }
+
+  ImageCacheStats getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ImageCacheStats result = stats;
+    result.entries = entries.size();
+    return result;
+  }
+
+  bool enabled() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats.limit > 0;
+  }
+
+  static std::string fileKey(const std::string& filePath, int readType, bool autoOrient) {
+    struct stat st;
+
+    if (stat(filePath.c_str(), &st) != 0) {
+      return std::string();
+    }
+
+    std::ostringstream key;
+    key << "file:" << filePath << ":" << st.st_mtime << ":" << st.st_size << ":" << readType << ":" << autoOrient;
+    return key.str();
+  }
+
+  static std::string dataKey(const std::vector<uchar>& data, int decodeType, bool autoOrient) {
+    // 64 bit FNV-1a.
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (auto byte : data) {
+      hash = (hash ^ byte) * 1099511628211ULL;
+    }
+
+    std::ostringstream key;
+    key << "data:" << std::hex << hash << std::dec << ":" << data.size() << ":" << decodeType << ":" << autoOrient;
+    return key.str();
+  }
+
+private:
+
+  ImageCache() {}
+
+  static size_t byteSize(const cv::Mat& mat) {
+    return mat.total() * mat.elemSize();
+  }
+
+  void evict() {
+    while (stats.bytes > stats.limit && !entries.empty()) {
+      auto& last = entries.back();
+
+      stats.bytes -= byteSize(last.second);
+      ++stats.evictions;
+
+      index.erase(last.first);
+      entries.pop_back();
+    }
+  }
+
+  std::mutex mutex;
+  ImageCacheStats stats;
+  std::list<std::pair<std::string, cv::Mat>> entries;
+  std::unordered_map<std::string, std::list<std::pair<std::string, cv::Mat>>::iterator> index;
+};
+
+/**
+ * Decodes an image through the cache. `key` may be empty in which
+ * case the cache is bypassed.
+ */
+template<typename Decoder>
+cv::Mat cachedImage(const std::string& key, Decoder decode) {
+  auto& cache = ImageCache::instance();
+  cv::Mat image;
+
+  if (key.empty() || !cache.enabled()) {
+    return decode();
+  }
+
+  if (cache.get(key, image)) {
+    return image;
+  }
+
+  image = decode();
+  cache.put(key, image);
+
+  return image;
+}
+
+/**
+ * setImageCacheLimit(bytes)
+ */
+NAN_METHOD(setImageCacheLimit) {
+  if (info.Length() != 1 || !info[0]->IsNumber() || Nan::To<double>(info[0]).FromJust() < 0) {
+    Nan::ThrowError("expected one argument (bytes) that must be a non-negative number");
+    return;
+  }
+
+  ImageCache::instance().setLimit(static_cast<size_t>(Nan::To<double>(info[0]).FromJust()));
+}
+
+NAN_METHOD(clearImageCache) {
+  ImageCache::instance().clear();
+}
+
+NAN_METHOD(imageCacheStats) {
+  auto stats = ImageCache::instance().getStats();
+  auto obj = Nan::New<v8::Object>();
+
+  Nan::Set(obj, Nan::New("hits").ToLocalChecked(), Nan::New(static_cast<double>(stats.hits)));
+  Nan::Set(obj, Nan::New("misses").ToLocalChecked(), Nan::New(static_cast<double>(stats.misses)));
+  Nan::Set(obj, Nan::New("evictions").ToLocalChecked(), Nan::New(static_cast<double>(stats.evictions)));
+  Nan::Set(obj, Nan::New("entries").ToLocalChecked(), Nan::New(static_cast<double>(stats.entries)));
+  Nan::Set(obj, Nan::New("bytes").ToLocalChecked(), Nan::New(static_cast<double>(stats.bytes)));
+  Nan::Set(obj, Nan::New("limit").ToLocalChecked(), Nan::New(static_cast<double>(stats.limit)));
+
+  info.GetReturnValue().Set(obj);
+}
+
+#endif // SIMPLE_CV_IMAGE_CACHE_H
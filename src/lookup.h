@@ -4,6 +4,127 @@
 #include "Matrix.h"
 #include "async.h"
 
+/**
+ * Converts a lookup table matrix into a 1x256 table that `cv::LUT` accepts. Valid tables are:
+ *
+ *   - a Gray matrix with 256 values that is applied to all channels.
+ *   - a 256x3 or 256x4 Gray matrix that has one row per channel in BGR(A) order.
+ *   - a BGR or BGRA matrix with 256 values.
+ *
+ * Returns an empty matrix if the table is not valid.
+ */
+cv::Mat normalizeLookupTable(const cv::Mat& table) {
+  if (table.depth() != CV_8U) {
+    return cv::Mat();
+  }
+
+  cv::Mat continuous = table.isContinuous() ? table : table.clone();
+
+  if (table.channels() == 1 && table.total() == 256) {
+    return continuous.reshape(1, 1);
+  }
+
+  if (table.channels() == 1 && table.cols == 256 && (table.rows == 3 || table.rows == 4)) {
+    std::vector<cv::Mat> channels;
+    cv::Mat merged;
+
+    for (int r = 0; r < table.rows; ++r) {
+      channels.push_back(continuous.row(r));
+    }
+
+    cv::merge(channels, merged);
+    return merged;
+  }
+
+  if ((table.channels() == 3 || table.channels() == 4) && table.total() == 256) {
+    return continuous.reshape(table.channels(), 1);
+  }
+
+  return cv::Mat();
+}
+
+/**
+ * Collapses a chain of lookup tables into one so that the image only needs to be
+ * read once. The tables must be normalized and have either one channel or the
+ * same number of channels.
+ */
+cv::Mat composeLookupTables(const std::vector<cv::Mat>& tables) {
+  if (tables.size() == 1) {
+    return tables[0];
+  }
+
+  int channels = 1;
+
+  for (auto& table : tables) {
+    channels = std::max(channels, table.channels());
+  }
+
+  cv::Mat composed(1, 256, CV_8UC(channels));
+  auto out = composed.ptr<uchar>();
+
+  for (int c = 0; c < channels; ++c) {
+    for (int i = 0; i < 256; ++i) {
+      int value = i;
+
+      for (auto& table : tables) {
+        int tableChannels = table.channels();
+        value = table.ptr<uchar>()[value * tableChannels + (tableChannels == 1 ? 0 : c)];
+      }
+
+      out[i * channels + c] = static_cast<uchar>(value);
+    }
+  }
+
+  return composed;
+}
+
+/**
+ * Reads a lookup table or an array of lookup tables from `value`. Returns false
+ * if any of the tables is invalid or the channel counts don't match.
+ */
+bool getLookupTables(v8::Local<v8::Value> value, std::vector<cv::Mat>& tables) {
+  Nan::HandleScope scope;
+  std::vector<v8::Local<v8::Value>> values;
+  int channels = 1;
+
+  if (value->IsArray()) {
+    auto arr = value.As<v8::Array>();
+
+    for (unsigned i = 0; i < arr->Length(); ++i) {
+      values.push_back(Nan::Get(arr, i).ToLocalChecked());
+    }
+  } else {
+    values.push_back(value);
+  }
+
+  if (values.empty()) {
+    return false;
+  }
+
+  for (auto& val : values) {
+    if (!Matrix::isMatrix(val)) {
+      return false;
+    }
+
+    auto table = normalizeLookupTable(Matrix::get(val));
+
+    if (table.empty() || (table.channels() != 1 && channels != 1 && table.channels() != channels)) {
+      return false;
+    }
+
+    channels = std::max(channels, table.channels());
+    tables.push_back(table);
+  }
+
+  return true;
+}
+
+/**
+ * lookup(image, lookupTable)
+ * lookup(image, lookupTable, callback)
+ * lookup(image, [lookupTable, ...])
+ * lookup(image, [lookupTable, ...], callback)
+ */
 NAN_METHOD(lookup) {
   if (info.Length() < 2 || info.Length() > 3) {
     Nan::ThrowError("expected at least two argument (image, lookupTable) and at most two arguments (image, lookupTable, callback)");
@@ -15,26 +136,46 @@ NAN_METHOD(lookup) {
     return;
   }
 
-  if (!Matrix::isMatrix(info[1])) {
-    Nan::ThrowError("second argument (lookupTable) must be a Matrix");
-    return;
-  }
-
   auto image = Matrix::get(info[0]);
-  auto lookupTable = Matrix::get(info[1]);
+  std::vector<cv::Mat> lookupTables;
 
-  if (lookupTable.type() != CV_8UC1 || lookupTable.total() != 256) {
-    Nan::ThrowError("second argument (lookupTable) must be a a Gray matrix with 256 values");
+  if (!getLookupTables(info[1], lookupTables)) {
+    Nan::ThrowError("second argument (lookupTable) must be a lookup table or an array of lookup tables. A lookup table is a Gray matrix with 256 values, a 256x3 Gray matrix or a BGR matrix with 256 values");
     return;
   }
 
-  maybeAsyncOp<cv::Mat>(info, [image, lookupTable]() {
+  for (auto& table : lookupTables) {
+    if (table.channels() != 1 && table.channels() != image.channels()) {
+      Nan::ThrowError("a multi-channel lookup table must have the same number of channels as the image");
+      return;
+    }
+  }
+
+  maybeAsyncOp<cv::Mat>(info, [image, lookupTables]() {
     cv::Mat result;
-    cv::LUT(image, lookupTable, result);
+    cv::LUT(image, composeLookupTables(lookupTables), result);
     return result;
   }, [](const cv::Mat& result) {
     return Matrix::create(result);
   });
 }
 
+/**
+ * composeLookups([lookupTable, ...])
+ */
+NAN_METHOD(composeLookups) {
+  std::vector<cv::Mat> lookupTables;
+
+  if (info.Length() != 1 || !info[0]->IsArray() || !getLookupTables(info[0], lookupTables)) {
+    Nan::ThrowError("expected one argument (lookupTables) that must be an array of lookup tables");
+    return;
+  }
+
+  try {
+    info.GetReturnValue().Set(Matrix::create(composeLookupTables(lookupTables)));
+  } catch (std::exception& err) {
+    Nan::ThrowError(err.what());
+  }
+}
+
 #endif // SIMPLE_CV_LOOKUP_H
@@ -0,0 +1,273 @@
+#ifndef SIMPLE_CV_LOOKUP_3D_H
+#define SIMPLE_CV_LOOKUP_3D_H
+
+#include <fstream>
+#include <sstream>
+#include <cmath>
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "Matrix.h"
+#include "async.h"
+
+/**
+ * Parses an Adobe/Resolve `.cube` 3D lookup table into a Float matrix of
+ * width 3 and height size^3. Each row is an RGB output value between 0 and 1
+ * and the red input coordinate changes fastest like in the file.
+ */
+cv::Mat readCubeFile(const std::string& filePath) {
+  std::ifstream file(filePath);
+
+  if (!file) {
+    throw std::runtime_error(std::string("could not open file ") + "\"" + filePath + "\"");
+  }
+
+  std::string line;
+  std::vector<double> values;
+  int size = 0;
+
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+    std::string keyword;
+
+    if (!(stream >> keyword) || keyword[0] == '#') {
+      continue;
+    }
+
+    if (keyword == "LUT_3D_SIZE") {
+      stream >> size;
+    } else if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX") {
+      double r, g, b;
+      double expected = keyword == "DOMAIN_MIN" ? 0.0 : 1.0;
+
+      if (!(stream >> r >> g >> b) || r != expected || g != expected || b != expected) {
+        throw std::runtime_error("only the default DOMAIN_MIN (0 0 0) and DOMAIN_MAX (1 1 1) are supported");
+      }
+    } else if (keyword == "LUT_1D_SIZE") {
+      throw std::runtime_error("1D .cube files are not supported");
+    } else if ((keyword[0] >= '0' && keyword[0] <= '9') || keyword[0] == '-' || keyword[0] == '.') {
+      double r = std::stod(keyword);
+      double g, b;
+
+      if (!(stream >> g >> b)) {
+        throw std::runtime_error(std::string("invalid .cube file ") + "\"" + filePath + "\"");
+      }
+
+      values.push_back(r);
+      values.push_back(g);
+      values.push_back(b);
+    }
+  }
+
+  if (size < 2 || size > 256 || values.size() != static_cast<size_t>(size) * size * size * 3) {
+    throw std::runtime_error(std::string("invalid .cube file ") + "\"" + filePath + "\"");
+  }
+
+  return cv::Mat(size * size * size, 3, ImageTypeFloat, values.data()).clone();
+}
+
+/**
+ * Returns the size of a 3D lookup table matrix or 0 if it's not one.
+ */
+int lookupTable3dSize(const cv::Mat& table) {
+  if (table.type() != ImageTypeFloat || table.cols != 3) {
+    return 0;
+  }
+
+  int size = static_cast<int>(std::round(std::cbrt(static_cast<double>(table.rows))));
+  return size >= 2 && size * size * size == table.rows ? size : 0;
+}
+
+/**
+ * Tetrahedral interpolation of a 3D lookup table. Every input channel value
+ * maps to a fixed lattice index and fraction, so those are computed once
+ * into 256 entry tables instead of per pixel.
+ *
+ * Lattice nodes are padded to four floats so that with universal intrinsics
+ * each tetrahedron corner is a single vector load and the RGB outputs of a
+ * pixel are blended together. The corners themselves depend on the pixel
+ * values, and SSE2/NEON have no gather, so pixels are still visited one by one.
+ */
+class Lookup3dBody : public cv::ParallelLoopBody {
+
+public:
+
+  Lookup3dBody(const cv::Mat& src, cv::Mat& dst, const cv::Mat& table, int size)
+    : src(src)
+    , dst(dst)
+    , size(size)
+    , lattice(table.rows * 4, 0.0f) {
+
+    for (int i = 0; i < table.rows; ++i) {
+      auto values = table.ptr<double>(i);
+
+      for (int c = 0; c < 3; ++c) {
+        lattice[i * 4 + c] = static_cast<float>(values[c] * 255.0);
+      }
+    }
+
+    for (int v = 0; v < 256; ++v) {
+      float pos = v * (size - 1) / 255.0f;
+      int i = std::min(static_cast<int>(pos), size - 2);
+
+      index[v] = i;
+      fraction[v] = pos - i;
+    }
+  }
+
+  void operator()(const cv::Range& range) const {
+    int channels = src.channels();
+    int rStride = 4;
+    int gStride = size * 4;
+    int bStride = size * size * 4;
+
+    for (int row = range.start; row < range.end; ++row) {
+      auto in = src.ptr<uchar>(row);
+      auto out = dst.ptr<uchar>(row);
+
+      for (int col = 0; col < src.cols; ++col, in += channels, out += channels) {
+        // The image is BGR but the lattice is indexed by RGB.
+        float fb = fraction[in[0]];
+        float fg = fraction[in[1]];
+        float fr = fraction[in[2]];
+
+        const float* c000 = &lattice[index[in[2]] * rStride + index[in[1]] * gStride + index[in[0]] * bStride];
+        const float* c111 = c000 + rStride + gStride + bStride;
+        const float* a;
+        const float* b;
+        float w0, w1, w2, w3;
+
+        if (fr > fg) {
+          if (fg > fb) {
+            a = c000 + rStride; b = a + gStride;
+            w0 = 1 - fr; w1 = fr - fg; w2 = fg - fb; w3 = fb;
+          } else if (fr > fb) {
+            a = c000 + rStride; b = a + bStride;
+            w0 = 1 - fr; w1 = fr - fb; w2 = fb - fg; w3 = fg;
+          } else {
+            a = c000 + bStride; b = a + rStride;
+            w0 = 1 - fb; w1 = fb - fr; w2 = fr - fg; w3 = fg;
+          }
+        } else {
+          if (fb > fg) {
+            a = c000 + bStride; b = a + gStride;
+            w0 = 1 - fb; w1 = fb - fg; w2 = fg - fr; w3 = fr;
+          } else if (fb > fr) {
+            a = c000 + gStride; b = a + bStride;
+            w0 = 1 - fg; w1 = fg - fb; w2 = fb - fr; w3 = fr;
+          } else {
+            a = c000 + gStride; b = a + rStride;
+            w0 = 1 - fg; w1 = fg - fr; w2 = fr - fb; w3 = fb;
+          }
+        }
+
+#if CV_SIMD128
+        auto value = cv::v_load(c000) * cv::v_setall_f32(w0)
+                   + cv::v_load(a) * cv::v_setall_f32(w1)
+                   + cv::v_load(b) * cv::v_setall_f32(w2)
+                   + cv::v_load(c111) * cv::v_setall_f32(w3);
+
+        int rgb[4];
+        cv::v_store(rgb, cv::v_round(value));
+
+        for (int c = 0; c < 3; ++c) {
+          out[2 - c] = cv::saturate_cast<uchar>(rgb[c]);
+        }
+#else
+        for (int c = 0; c < 3; ++c) {
+          float value = w0 * c000[c] + w1 * a[c] + w2 * b[c] + w3 * c111[c];
+          out[2 - c] = cv::saturate_cast<uchar>(value);
+        }
+#endif
+
+        if (channels == 4) {
+          out[3] = in[3];
+        }
+      }
+    }
+  }
+
+private:
+
+  const cv::Mat& src;
+  cv::Mat& dst;
+  int size;
+  std::vector<float> lattice;
+  int index[256];
+  float fraction[256];
+};
+
+/**
+ * readCubeLut(filePath)
+ * readCubeLut(filePath, callback)
+ */
+NAN_METHOD(readCubeLut) {
+  if (info.Length() < 1 || info.Length() > 2) {
+    Nan::ThrowError("expected at least one argument (filePath) and at most two arguments (filePath, callback)");
+    return;
+  }
+
+  if (!info[0]->IsString()) {
+    Nan::ThrowError("first argument (filePath) must be a string");
+    return;
+  }
+
+  if (info.Length() == 2 && !info[1]->IsFunction()) {
+    Nan::ThrowError("second argument (callback) must be a function");
+    return;
+  }
+
+  std::string filePath(v8::String::Utf8Value(info[0]->ToString()).operator*());
+
+  maybeAsyncOp<cv::Mat>(info, [filePath]() {
+    return readCubeFile(filePath);
+  }, [](const cv::Mat& result) {
+    return Matrix::create(result);
+  });
+}
+
+/**
+ * lookup3d(image, lookupTable)
+ * lookup3d(image, lookupTable, callback)
+ */
+NAN_METHOD(lookup3d) {
+  if (info.Length() < 2 || info.Length() > 3) {
+    Nan::ThrowError("expected at least two arguments (image, lookupTable) and at most three arguments (image, lookupTable, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  auto image = Matrix::get(info[0]);
+
+  if (image.type() != ImageTypeBGR && image.type() != ImageTypeBGRA) {
+    Nan::ThrowError("first argument (image) must be a BGR or BGRA image");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[1]) || lookupTable3dSize(Matrix::get(info[1])) == 0) {
+    Nan::ThrowError("second argument (lookupTable) must be a 3D lookup table returned by cv.readCubeLut");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  auto lookupTable = Matrix::get(info[1]);
+
+  maybeAsyncOp<cv::Mat>(info, [image, lookupTable]() {
+    cv::Mat output(image.rows, image.cols, image.type());
+    Lookup3dBody body(image, output, lookupTable, lookupTable3dSize(lookupTable));
+    cv::parallel_for_(cv::Range(0, image.rows), body);
+    return output;
+  }, [](const cv::Mat& result) {
+    return Matrix::create(result);
+  });
+}
+
+#endif // SIMPLE_CV_LOOKUP_3D_H
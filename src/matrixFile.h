@@ -0,0 +1,225 @@
+#ifndef SIMPLE_CV_MATRIX_FILE_H
+#define SIMPLE_CV_MATRIX_FILE_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <fstream>
+
+#include "Matrix.h"
+#include "async.h"
+
+/**
+ * Layout of the `.scvm` file header. The fields and the pixels are stored in the byte order
+ * of the machine that wrote the file. `byteOrder` lets readers reject files written with the
+ * other byte order. The pixel payload starts at `dataOffset` and has `height` rows of `stride` bytes.
+ */
+struct MatrixFileHeader {
+  char magic[4];
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  int32_t type;
+  uint32_t byteOrder;
+  uint64_t stride;
+  uint64_t dataOffset;
+  uint8_t padding[24];
+};
+
+static const char MatrixFileMagic[4] = {'S', 'C', 'V', 'M'};
+static const uint32_t MatrixFileVersion = 1;
+static const uint32_t MatrixFileByteOrder = 0x01020304;
+
+/**
+ * Allocator that owns a memory mapping. OpenCV calls `deallocate` when the
+ * last `cv::Mat` that references the mapping is released.
+ */
+class MappedMatAllocator : public cv::MatAllocator {
+
+public:
+
+  cv::UMatData* allocate(int, const int*, int, void*, size_t*, int, cv::UMatUsageFlags) const {
+    return NULL;
+  }
+
+  bool allocate(cv::UMatData*, int, cv::UMatUsageFlags) const {
+    return false;
+  }
+
+  void deallocate(cv::UMatData* u) const {
+    if (!u) {
+      return;
+    }
+
+    munmap(u->origdata, u->size);
+    delete u;
+  }
+
+  static MappedMatAllocator* instance() {
+    static MappedMatAllocator allocator;
+    return &allocator;
+  }
+};
+
+cv::Mat mapMatrixFile(const std::string& filePath) {
+  int fd = open(filePath.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    throw std::runtime_error(std::string("could not open file ") + "\"" + filePath + "\"");
+  }
+
+  struct stat st;
+
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(MatrixFileHeader)) {
+    close(fd);
+    throw std::runtime_error(std::string("invalid matrix file ") + "\"" + filePath + "\"");
+  }
+
+  auto size = static_cast<size_t>(st.st_size);
+  // A private mapping makes in-place operations copy-on-write instead of writing to the file.
+  auto base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (base == MAP_FAILED) {
+    throw std::runtime_error(std::string("could not map file ") + "\"" + filePath + "\"");
+  }
+
+  MatrixFileHeader header;
+  std::memcpy(&header, base, sizeof(header));
+
+  auto validType = isImageType(header.type);
+  auto elemSize = validType ? static_cast<uint64_t>(CV_ELEM_SIZE(header.type)) : 0;
+  auto elemSize1 = validType ? static_cast<uint64_t>(CV_ELEM_SIZE1(header.type)) : 1;
+
+  // The checks are ordered so that none of the arithmetic can overflow.
+  if (std::memcmp(header.magic, MatrixFileMagic, sizeof(MatrixFileMagic)) != 0
+      || header.version != MatrixFileVersion
+      || header.byteOrder != MatrixFileByteOrder
+      || !validType
+      || header.width <= 0
+      || header.height <= 0
+      || header.stride < static_cast<uint64_t>(header.width) * elemSize
+      // cv::Mat rejects strides that are not a multiple of the channel size.
+      || header.stride % elemSize1 != 0
+      || header.dataOffset < sizeof(MatrixFileHeader)
+      || header.dataOffset % sizeof(double) != 0
+      || header.dataOffset > size
+      || header.stride > (size - header.dataOffset) / static_cast<uint64_t>(header.height)) {
+
+    munmap(base, size);
+    throw std::runtime_error(std::string("invalid matrix file ") + "\"" + filePath + "\"");
+  }
+
+  auto data = static_cast<uchar*>(base) + header.dataOffset;
+  cv::Mat mat(header.height, header.width, header.type, data, static_cast<size_t>(header.stride));
+
+  // Hand the ownership of the mapping to the matrix. The pages are loaded lazily
+  // by the kernel when the data is first accessed.
+  auto u = new cv::UMatData(MappedMatAllocator::instance());
+  u->data = data;
+  u->origdata = static_cast<uchar*>(base);
+  u->size = size;
+  u->refcount = 1;
+  mat.u = u;
+
+  return mat;
+}
+
+void saveMatrixFile(const cv::Mat& mat, const std::string& filePath) {
+  MatrixFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, MatrixFileMagic, sizeof(MatrixFileMagic));
+
+  header.version = MatrixFileVersion;
+  header.width = mat.cols;
+  header.height = mat.rows;
+  header.type = mat.type();
+  header.byteOrder = MatrixFileByteOrder;
+  header.stride = mat.cols * mat.elemSize();
+  header.dataOffset = sizeof(MatrixFileHeader);
+
+  std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+
+  if (!file) {
+    throw std::runtime_error(std::string("could not open file ") + "\"" + filePath + "\" for writing");
+  }
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  for (int r = 0; r < mat.rows; ++r) {
+    file.write(reinterpret_cast<const char*>(mat.ptr(r)), header.stride);
+  }
+
+  if (!file) {
+    throw std::runtime_error(std::string("could not write file ") + "\"" + filePath + "\"");
+  }
+}
+
+/**
+ * mapMatrix(filePath)
+ * mapMatrix(filePath, callback)
+ */
+NAN_METHOD(mapMatrix) {
+  if (info.Length() < 1 || info.Length() > 2) {
+    Nan::ThrowError("expected at least one argument (filePath) and at most two arguments (filePath, callback)");
+    return;
+  }
+
+  if (!info[0]->IsString()) {
+    Nan::ThrowError("first argument (filePath) must be a string");
+    return;
+  }
+
+  if (info.Length() == 2 && !info[1]->IsFunction()) {
+    Nan::ThrowError("second argument (callback) must be a function");
+    return;
+  }
+
+  std::string filePath(v8::String::Utf8Value(info[0]->ToString()).operator*());
+
+  maybeAsyncOp<cv::Mat>(info, [filePath]() {
+    return mapMatrixFile(filePath);
+  }, [](const cv::Mat& result) {
+    return Matrix::create(result);
+  });
+}
+
+/**
+ * saveMatrix(matrix, filePath)
+ * saveMatrix(matrix, filePath, callback)
+ */
+NAN_METHOD(saveMatrix) {
+  if (info.Length() < 2 || info.Length() > 3) {
+    Nan::ThrowError("expected at least two arguments (matrix, filePath) and at most three arguments (matrix, filePath, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (matrix) must be a Matrix");
+    return;
+  }
+
+  if (!info[1]->IsString()) {
+    Nan::ThrowError("second argument (filePath) must be a string");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  cv::Mat mat = Matrix::get(info[0]);
+  std::string filePath(v8::String::Utf8Value(info[1]->ToString()).operator*());
+
+  maybeAsyncOp<int>(info, [mat, filePath]() {
+    saveMatrixFile(mat, filePath);
+    return 0;
+  }, [](const int&) {
+    return Nan::Null();
+  });
+}
+
+#endif // SIMPLE_CV_MATRIX_FILE_H
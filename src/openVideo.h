@@ -0,0 +1,76 @@
+#ifndef SIMPLE_CV_OPEN_VIDEO_H
+#define SIMPLE_CV_OPEN_VIDEO_H
+
+#include "VideoReader.h"
+#include "async.h"
+#include "utils.h"
+
+/**
+ * openVideo(filePath)
+ * openVideo(filePath, callback)
+ * openVideo(filePath, {start?, end?, step?, seek?, queueSize?, poolSize?})
+ * openVideo(filePath, {start?, end?, step?, seek?, queueSize?, poolSize?}, callback)
+ */
+NAN_METHOD(openVideo) {
+  if (info.Length() < 1 || info.Length() > 3) {
+    Nan::ThrowError("expected at least one argument (filePath) and at most three arguments (filePath, opt, callback)");
+    return;
+  }
+
+  if (!info[0]->IsString()) {
+    Nan::ThrowError("first argument (filePath) must be a string");
+    return;
+  }
+
+  VideoSourceOptions options;
+  bool hasPoolSize = false;
+
+  if (info.Length() >= 2 && info[1]->IsObject() && !info[1]->IsFunction()) {
+    auto opt = info[1];
+
+    if (has(opt, "start")) {
+      options.start = get<int>(opt, "start");
+    }
+
+    if (has(opt, "end")) {
+      options.end = get<int>(opt, "end");
+    }
+
+    if (has(opt, "step")) {
+      options.step = get<int>(opt, "step");
+    }
+
+    if (has(opt, "seek")) {
+      options.seek = Nan::To<bool>(getValue(opt, "seek")).FromJust();
+    }
+
+    if (has(opt, "queueSize")) {
+      options.queueSize = static_cast<size_t>(std::max(get<int>(opt, "queueSize"), 0));
+    }
+
+    if (has(opt, "poolSize")) {
+      options.poolSize = static_cast<size_t>(std::max(get<int>(opt, "poolSize"), 0));
+      hasPoolSize = true;
+    }
+  }
+
+  if (!hasPoolSize) {
+    // Enough buffers for a full queue plus a couple of frames that are being processed.
+    options.poolSize = options.queueSize + 2;
+  }
+
+  if (options.start < 0 || options.step < 1 || options.queueSize < 1) {
+    Nan::ThrowError("start must be non-negative and step and queueSize must be positive");
+    return;
+  }
+
+  std::string filePath(v8::String::Utf8Value(info[0]->ToString()).operator*());
+
+  maybeAsyncOp<std::shared_ptr<VideoSource>>(info, [filePath, options]() {
+    return std::make_shared<VideoSource>(filePath, options);
+  }, [](const std::shared_ptr<VideoSource>& source) {
+    return VideoReader::create(source);
+  });
+}
+
+#endif // SIMPLE_CV_OPEN_VIDEO_H
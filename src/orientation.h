@@ -0,0 +1,57 @@
+#ifndef SIMPLE_CV_ORIENTATION_H
+#define SIMPLE_CV_ORIENTATION_H
+
+#include <opencv2/opencv.hpp>
+#include "probeImage.h"
+#include "rotateQuarterTurns.h"
+
+/**
+ * Transforms a decoded image so that it's displayed upright according to
+ * an EXIF orientation value (1-8). Only flips and quarter turns are used, so
+ * the pixel values are never interpolated.
+ */
+void applyOrientation(cv::Mat& image, int orientation) {
+  switch (orientation) {
+    case 2:
+      cv::flip(image, image, 1);
+      break;
+    case 3:
+      cv::flip(image, image, -1);
+      break;
+    case 4:
+      cv::flip(image, image, 0);
+      break;
+    case 5:
+      // Transpose.
+      image = rotateQuarterTurns(image, 1);
+      cv::flip(image, image, 0);
+      break;
+    case 6:
+      image = rotateQuarterTurns(image, -1);
+      break;
+    case 7:
+      // Transverse.
+      image = rotateQuarterTurns(image, 1);
+      cv::flip(image, image, 1);
+      break;
+    case 8:
+      image = rotateQuarterTurns(image, 1);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Returns the EXIF orientation of an encoded image or 1 if the
+ * image format is not supported or it has no orientation tag.
+ */
+int readOrientation(ImageSource& source) {
+  try {
+    return probeImageSource(source).orientation;
+  } catch (std::exception&) {
+    return 1;
+  }
+}
+
+#endif // SIMPLE_CV_ORIENTATION_H
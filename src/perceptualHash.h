@@ -0,0 +1,170 @@
+#ifndef SIMPLE_CV_PERCEPTUAL_HASH_H
+#define SIMPLE_CV_PERCEPTUAL_HASH_H
+
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "Matrix.h"
+#include "async.h"
+#include "utils.h"
+
+static const int HashTypeDHash = 0;
+static const int HashTypePHash = 1;
+static const int HashTypeAHash = 2;
+
+inline int hammingDistance(uint64_t a, uint64_t b) {
+#ifdef _MSC_VER
+  return static_cast<int>(__popcnt64(a ^ b));
+#else
+  return __builtin_popcountll(a ^ b);
+#endif
+}
+
+/**
+ * Hashes are passed to JS as 16 character hex strings because
+ * a JS number can't hold 64 bits.
+ */
+std::string formatHash(uint64_t hash) {
+  char str[17];
+  std::snprintf(str, sizeof(str), "%016llx", static_cast<unsigned long long>(hash));
+  return std::string(str);
+}
+
+bool parseHash(v8::Local<v8::Value> value, uint64_t& hash) {
+  if (!value->IsString()) {
+    return false;
+  }
+
+  std::string str(v8::String::Utf8Value(value->ToString()).operator*());
+
+  if (str.empty() || str.size() > 16 || str.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+    return false;
+  }
+
+  hash = std::strtoull(str.c_str(), nullptr, 16);
+  return true;
+}
+
+/**
+ * Converts an image of any supported type into a float gray image of the given size.
+ */
+cv::Mat hashInput(const cv::Mat& image, cv::Size size) {
+  cv::Mat gray;
+  image.convertTo(gray, CV_MAKETYPE(CV_32F, image.channels()));
+
+  if (gray.channels() == 3) {
+    cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
+  } else if (gray.channels() == 4) {
+    cv::cvtColor(gray, gray, cv::COLOR_BGRA2GRAY);
+  }
+
+  cv::resize(gray, gray, size, 0, 0, cv::INTER_AREA);
+  return gray;
+}
+
+uint64_t computePerceptualHash(const cv::Mat& image, int type) {
+  uint64_t hash = 0;
+
+  if (type == HashTypeDHash) {
+    // Compares each pixel to its right neighbour.
+    auto gray = hashInput(image, cv::Size(9, 8));
+
+    for (int row = 0; row < 8; ++row) {
+      auto p = gray.ptr<float>(row);
+
+      for (int col = 0; col < 8; ++col) {
+        hash = (hash << 1) | (p[col] < p[col + 1] ? 1 : 0);
+      }
+    }
+  } else if (type == HashTypeAHash) {
+    auto gray = hashInput(image, cv::Size(8, 8));
+    auto mean = cv::mean(gray)[0];
+
+    for (int i = 0; i < 64; ++i) {
+      hash = (hash << 1) | (gray.at<float>(i) > mean ? 1 : 0);
+    }
+  } else {
+    // Compares the lowest 8x8 frequencies of the DCT to their median.
+    cv::Mat dct;
+    cv::dct(hashInput(image, cv::Size(32, 32)), dct);
+
+    cv::Mat low = dct(cv::Rect(0, 0, 8, 8)).clone();
+    std::vector<float> values(low.begin<float>(), low.end<float>());
+
+    std::nth_element(values.begin(), values.begin() + 32, values.end());
+    auto median = values[32];
+
+    for (int i = 0; i < 64; ++i) {
+      hash = (hash << 1) | (low.at<float>(i) > median ? 1 : 0);
+    }
+  }
+
+  return hash;
+}
+
+/**
+ * perceptualHash(image)
+ * perceptualHash(image, callback)
+ * perceptualHash(image, {type?})
+ * perceptualHash(image, {type?}, callback)
+ */
+NAN_METHOD(perceptualHash) {
+  if (info.Length() < 1 || info.Length() > 3) {
+    Nan::ThrowError("expected at least one argument (image) and at most three arguments (image, opt, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  auto image = Matrix::get(info[0]);
+  auto type = HashTypeDHash;
+
+  if (image.channels() == 2) {
+    Nan::ThrowError("first argument (image) must have 1, 3 or 4 channels");
+    return;
+  }
+
+  if (info.Length() >= 2 && info[1]->IsObject() && !info[1]->IsFunction() && has(info[1], "type")) {
+    std::string name(v8::String::Utf8Value(getValue(info[1], "type")->ToString()).operator*());
+
+    if (name == "dhash") {
+      type = HashTypeDHash;
+    } else if (name == "phash") {
+      type = HashTypePHash;
+    } else if (name == "ahash") {
+      type = HashTypeAHash;
+    } else {
+      Nan::ThrowError("type must be one of ['dhash', 'phash', 'ahash']");
+      return;
+    }
+  }
+
+  maybeAsyncOp<uint64_t>(info, [image, type]() {
+    return computePerceptualHash(image, type);
+  }, [](const uint64_t& hash) {
+    return Nan::New(formatHash(hash)).ToLocalChecked();
+  });
+}
+
+/**
+ * hashDistance(hash1, hash2)
+ */
+NAN_METHOD(hashDistance) {
+  uint64_t a, b;
+
+  if (info.Length() != 2 || !parseHash(info[0], a) || !parseHash(info[1], b)) {
+    Nan::ThrowError("expected two arguments (hash1, hash2) that must be hashes returned by cv.perceptualHash");
+    return;
+  }
+
+  info.GetReturnValue().Set(Nan::New(hammingDistance(a, b)));
+}
+
+#endif // SIMPLE_CV_PERCEPTUAL_HASH_H
@@ -0,0 +1,461 @@
+#ifndef SIMPLE_CV_PROBE_IMAGE_H
+#define SIMPLE_CV_PROBE_IMAGE_H
+
+#include <fstream>
+#include <memory>
+#include <cstring>
+
+#include "Matrix.h"
+#include "async.h"
+#include "constants.h"
+
+// The largest EXIF payload of a JPEG APP1 segment.
+static const size_t MaxExifBytes = 65533;
+
+/**
+ * Random access to the bytes of an encoded image. Only the few bytes the
+ * header parsers ask for are ever read from a file.
+ */
+class ImageSource {
+
+public:
+
+  virtual ~ImageSource() {}
+
+  virtual size_t read(size_t offset, uchar* out, size_t size) = 0;
+
+  bool readExactly(size_t offset, uchar* out, size_t size) {
+    return read(offset, out, size) == size;
+  }
+};
+
+class FileImageSource : public ImageSource {
+
+public:
+
+  FileImageSource(const std::string& filePath)
+    : file(filePath, std::ios::binary) {
+    if (!file) {
+      throw std::runtime_error(std::string("could not open file ") + "\"" + filePath + "\"");
+    }
+  }
+
+  size_t read(size_t offset, uchar* out, size_t size) {
+    file.clear();
+    file.seekg(offset);
+    file.read(reinterpret_cast<char*>(out), size);
+    return static_cast<size_t>(file.gcount());
+  }
+
+private:
+
+  std::ifstream file;
+};
+
+class BufferImageSource : public ImageSource {
+
+public:
+
+  BufferImageSource(const uchar* data, size_t size)
+    : data(data)
+    , size(size) {
+  }
+
+  size_t read(size_t offset, uchar* out, size_t count) {
+    if (offset >= size) {
+      return 0;
+    }
+
+    count = std::min(count, size - offset);
+    std::memcpy(out, data + offset, count);
+
+    return count;
+  }
+
+private:
+
+  const uchar* data;
+  size_t size;
+};
+
+struct ImageInfo {
+  int width = 0;
+  int height = 0;
+  int type = ImageTypeBGR;
+  int orientation = 1;
+  std::string format;
+};
+
+inline uint32_t readBE(const uchar* p, int bytes) {
+  uint32_t value = 0;
+
+  for (int i = 0; i < bytes; ++i) {
+    value = (value << 8) | p[i];
+  }
+
+  return value;
+}
+
+inline uint32_t readLE(const uchar* p, int bytes) {
+  uint32_t value = 0;
+
+  for (int i = bytes - 1; i >= 0; --i) {
+    value = (value << 8) | p[i];
+  }
+
+  return value;
+}
+
+/**
+ * Reads the orientation tag (0x0112) from the first IFD of an EXIF TIFF block.
+ * Returns 1 (no transformation) if the tag is missing or invalid.
+ */
+int parseExifOrientation(const uchar* tiff, size_t size) {
+  if (size < 8) {
+    return 1;
+  }
+
+  bool littleEndian;
+
+  if (tiff[0] == 'I' && tiff[1] == 'I') {
+    littleEndian = true;
+  } else if (tiff[0] == 'M' && tiff[1] == 'M') {
+    littleEndian = false;
+  } else {
+    return 1;
+  }
+
+  auto read = [littleEndian](const uchar* p, int bytes) {
+    return littleEndian ? readLE(p, bytes) : readBE(p, bytes);
+  };
+
+  size_t ifd = read(tiff + 4, 4);
+
+  if (ifd + 2 > size) {
+    return 1;
+  }
+
+  size_t count = read(tiff + ifd, 2);
+
+  for (size_t i = 0; i < count; ++i) {
+    size_t entry = ifd + 2 + i * 12;
+
+    if (entry + 12 > size) {
+      break;
+    }
+
+    if (read(tiff + entry, 2) == 0x0112) {
+      int orientation = static_cast<int>(read(tiff + entry + 8, 2));
+      return orientation >= 1 && orientation <= 8 ? orientation : 1;
+    }
+  }
+
+  return 1;
+}
+
+bool probeJPEG(ImageSource& source, ImageInfo& imageInfo) {
+  uchar header[10];
+  size_t offset = 2;
+
+  imageInfo.format = "jpeg";
+
+  while (source.readExactly(offset, header, 4)) {
+    if (header[0] != 0xFF) {
+      return false;
+    }
+
+    uchar marker = header[1];
+
+    // Fill bytes.
+    if (marker == 0xFF) {
+      offset += 1;
+      continue;
+    }
+
+    // Markers without a payload.
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD9)) {
+      offset += 2;
+      continue;
+    }
+
+    size_t length = readBE(header + 2, 2);
+
+    if (length < 2) {
+      return false;
+    }
+
+    if (marker == 0xE1 && length >= 8) {
+      std::vector<uchar> segment(length - 2);
+
+      if (source.readExactly(offset + 4, segment.data(), segment.size())
+          && std::memcmp(segment.data(), "Exif\0\0", 6) == 0) {
+        imageInfo.orientation = parseExifOrientation(segment.data() + 6, segment.size() - 6);
+      }
+    }
+
+    // All start of frame markers except DHT (C4), JPG (C8) and DAC (CC).
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+      if (!source.readExactly(offset + 4, header, 6)) {
+        return false;
+      }
+
+      imageInfo.height = static_cast<int>(readBE(header + 1, 2));
+      imageInfo.width = static_cast<int>(readBE(header + 3, 2));
+      imageInfo.type = header[5] == 1 ? ImageTypeGray : ImageTypeBGR;
+
+      return true;
+    }
+
+    offset += 2 + length;
+  }
+
+  return false;
+}
+
+bool probePNG(ImageSource& source, ImageInfo& imageInfo) {
+  uchar header[26];
+
+  imageInfo.format = "png";
+
+  if (!source.readExactly(0, header, sizeof(header)) || std::memcmp(header + 12, "IHDR", 4) != 0) {
+    return false;
+  }
+
+  imageInfo.width = static_cast<int>(readBE(header + 16, 4));
+  imageInfo.height = static_cast<int>(readBE(header + 20, 4));
+
+  int colorType = header[25];
+  bool alpha = colorType == 4 || colorType == 6;
+
+  // A palette image with a tRNS chunk is decoded with an alpha channel.
+  // The chunk must appear before the first IDAT chunk.
+  if (colorType == 3) {
+    size_t offset = 8;
+    uchar chunk[8];
+
+    while (source.readExactly(offset, chunk, sizeof(chunk))) {
+      if (std::memcmp(chunk + 4, "IDAT", 4) == 0) {
+        break;
+      }
+
+      if (std::memcmp(chunk + 4, "tRNS", 4) == 0) {
+        alpha = true;
+        break;
+      }
+
+      offset += 12 + readBE(chunk, 4);
+    }
+  }
+
+  // 16-bit images keep their depth when decoded with the default type.
+  bool deep = header[24] == 16;
+
+  if (alpha) {
+    imageInfo.type = deep ? ImageTypeBGRA16 : ImageTypeBGRA;
+  } else if (colorType == 0) {
+    imageInfo.type = deep ? ImageTypeGray16 : ImageTypeGray;
+  } else {
+    imageInfo.type = deep ? ImageTypeBGR16 : ImageTypeBGR;
+  }
+
+  return true;
+}
+
+bool probeWebP(ImageSource& source, ImageInfo& imageInfo) {
+  uchar chunk[30];
+  size_t offset = 12;
+  bool found = false;
+
+  imageInfo.format = "webp";
+
+  while (source.readExactly(offset, chunk, 8)) {
+    size_t length = readLE(chunk + 4, 4);
+
+    if (std::memcmp(chunk, "VP8X", 4) == 0 && source.readExactly(offset + 8, chunk + 8, 10)) {
+      imageInfo.type = (chunk[8] & 0x10) ? ImageTypeBGRA : ImageTypeBGR;
+      imageInfo.width = static_cast<int>(readLE(chunk + 12, 3)) + 1;
+      imageInfo.height = static_cast<int>(readLE(chunk + 15, 3)) + 1;
+      found = true;
+    } else if (std::memcmp(chunk, "VP8 ", 4) == 0 && !found && source.readExactly(offset + 8, chunk + 8, 10)) {
+      if (chunk[11] != 0x9D || chunk[12] != 0x01 || chunk[13] != 0x2A) {
+        return false;
+      }
+
+      imageInfo.type = ImageTypeBGR;
+      imageInfo.width = static_cast<int>(readLE(chunk + 14, 2) & 0x3FFF);
+      imageInfo.height = static_cast<int>(readLE(chunk + 16, 2) & 0x3FFF);
+
+      return true;
+    } else if (std::memcmp(chunk, "VP8L", 4) == 0 && !found && source.readExactly(offset + 8, chunk + 8, 5)) {
+      if (chunk[8] != 0x2F) {
+        return false;
+      }
+
+      uint32_t bits = readLE(chunk + 9, 4);
+
+      imageInfo.width = static_cast<int>(bits & 0x3FFF) + 1;
+      imageInfo.height = static_cast<int>((bits >> 14) & 0x3FFF) + 1;
+      imageInfo.type = ((bits >> 28) & 1) ? ImageTypeBGRA : ImageTypeBGR;
+
+      return true;
+    } else if (std::memcmp(chunk, "EXIF", 4) == 0) {
+      // The chunk length comes from the file, so at most as much as a JPEG APP1 segment
+      // is read. The orientation is in the first IFD near the start.
+      std::vector<uchar> exif(std::min<size_t>(length, MaxExifBytes));
+      exif.resize(source.read(offset + 8, exif.data(), exif.size()));
+
+      if (!exif.empty()) {
+        // Some encoders include the JPEG style "Exif\0\0" prefix.
+        size_t skip = exif.size() >= 6 && std::memcmp(exif.data(), "Exif\0\0", 6) == 0 ? 6 : 0;
+        imageInfo.orientation = parseExifOrientation(exif.data() + skip, exif.size() - skip);
+      }
+    }
+
+    // Chunks are padded to an even size.
+    offset += 8 + length + (length & 1);
+  }
+
+  return found;
+}
+
+ImageInfo probeImageSource(ImageSource& source) {
+  uchar magic[12];
+  ImageInfo imageInfo;
+  bool ok = false;
+
+  if (source.readExactly(0, magic, 3) && magic[0] == 0xFF && magic[1] == 0xD8 && magic[2] == 0xFF) {
+    ok = probeJPEG(source, imageInfo);
+  } else if (source.readExactly(0, magic, 8) && std::memcmp(magic, "\x89PNG\r\n\x1A\n", 8) == 0) {
+    ok = probePNG(source, imageInfo);
+  } else if (source.readExactly(0, magic, 12) && std::memcmp(magic, "RIFF", 4) == 0 && std::memcmp(magic + 8, "WEBP", 4) == 0) {
+    ok = probeWebP(source, imageInfo);
+  } else {
+    throw std::runtime_error("unsupported image format");
+  }
+
+  if (!ok || imageInfo.width <= 0 || imageInfo.height <= 0) {
+    throw std::runtime_error("invalid " + imageInfo.format + " header");
+  }
+
+  return imageInfo;
+}
+
+/**
+ * Either a file path or a copy of a buffer's data. Buffers must be copied
+ * because the probing may happen in a worker thread.
+ */
+struct ProbeInput {
+  std::string filePath;
+  std::vector<uchar> data;
+  bool isFile;
+};
+
+ImageInfo probeImageInput(const ProbeInput& input) {
+  if (input.isFile) {
+    FileImageSource source(input.filePath);
+    return probeImageSource(source);
+  } else {
+    BufferImageSource source(input.data.data(), input.data.size());
+    return probeImageSource(source);
+  }
+}
+
+bool getProbeInput(v8::Local<v8::Value> value, ProbeInput& input) {
+  if (value->IsString()) {
+    input.filePath = std::string(v8::String::Utf8Value(value->ToString()).operator*());
+    input.isFile = true;
+  } else if (node::Buffer::HasInstance(value)) {
+    auto bytes = reinterpret_cast<uchar*>(node::Buffer::Data(value));
+    input.data.assign(bytes, bytes + node::Buffer::Length(value));
+    input.isFile = false;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+v8::Local<v8::Value> imageInfoToObject(const ImageInfo& imageInfo) {
+  Nan::EscapableHandleScope scope;
+  auto obj = Nan::New<v8::Object>();
+
+  Nan::Set(obj, Nan::New("width").ToLocalChecked(), Nan::New(imageInfo.width));
+  Nan::Set(obj, Nan::New("height").ToLocalChecked(), Nan::New(imageInfo.height));
+  Nan::Set(obj, Nan::New("type").ToLocalChecked(), Nan::New(imageInfo.type));
+  Nan::Set(obj, Nan::New("format").ToLocalChecked(), Nan::New(imageInfo.format).ToLocalChecked());
+  Nan::Set(obj, Nan::New("orientation").ToLocalChecked(), Nan::New(imageInfo.orientation));
+
+  return scope.Escape(obj);
+}
+
+/**
+ * probeImage(filePath|buffer)
+ * probeImage(filePath|buffer, callback)
+ * probeImage([filePath|buffer, ...])
+ * probeImage([filePath|buffer, ...], callback)
+ */
+NAN_METHOD(probeImage) {
+  if (info.Length() < 1 || info.Length() > 2) {
+    Nan::ThrowError("expected at least one argument (image) and at most two arguments (image, callback)");
+    return;
+  }
+
+  if (info.Length() == 2 && !info[1]->IsFunction()) {
+    Nan::ThrowError("second argument (callback) must be a function");
+    return;
+  }
+
+  if (info[0]->IsArray()) {
+    auto arr = info[0].As<v8::Array>();
+    std::vector<ProbeInput> inputs(arr->Length());
+
+    for (unsigned i = 0; i < arr->Length(); ++i) {
+      if (!getProbeInput(Nan::Get(arr, i).ToLocalChecked(), inputs[i])) {
+        Nan::ThrowError("first argument (images) must be an array of file paths or Buffers");
+        return;
+      }
+    }
+
+    // A failing image doesn't fail the whole batch. Its result is null instead.
+    maybeAsyncOp<std::vector<std::pair<bool, ImageInfo>>>(info, [inputs]() {
+      std::vector<std::pair<bool, ImageInfo>> results(inputs.size());
+
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        try {
+          results[i] = std::make_pair(true, probeImageInput(inputs[i]));
+        } catch (std::exception&) {
+          results[i] = std::make_pair(false, ImageInfo());
+        }
+      }
+
+      return results;
+    }, [](const std::vector<std::pair<bool, ImageInfo>>& results) {
+      auto array = Nan::New<v8::Array>(results.size());
+
+      for (unsigned i = 0; i < results.size(); ++i) {
+        if (results[i].first) {
+          Nan::Set(array, i, imageInfoToObject(results[i].second));
+        } else {
+          Nan::Set(array, i, Nan::Null());
+        }
+      }
+
+      return array;
+    });
+  } else {
+    ProbeInput input;
+
+    if (!getProbeInput(info[0], input)) {
+      Nan::ThrowError("first argument (image) must be a file path, a Buffer or an array of them");
+      return;
+    }
+
+    maybeAsyncOp<ImageInfo>(info, [input]() {
+      return probeImageInput(input);
+    }, [](const ImageInfo& imageInfo) {
+      return imageInfoToObject(imageInfo);
+    });
+  }
+}
+
+#endif // SIMPLE_CV_PROBE_IMAGE_H
@@ -4,15 +4,22 @@
 #include "Matrix.h"
 #include "async.h"
 #include "constants.h"
+#include "utils.h"
+#include "orientation.h"
+#include "imageCache.h"
 
 /**
  * readImage(filePath)
  * readImage(filePath, callback)
  * readImage(filePath, readType)
  * readImage(filePath, readType, callback)
+ * readImage(filePath, {type?, autoOrient?, cache?})
+ * readImage(filePath, {type?, autoOrient?, cache?}, callback)
  */
 NAN_METHOD(readImage) {
   int readType = cv::IMREAD_UNCHANGED;
+  bool autoOrient = false;
+  bool cache = false;
 
   if (info.Length() < 1 || info.Length() > 3) {
     Nan::ThrowError("expected at least one argument (filePath) and at most three arguments (filePath, readType, callback)");
@@ -25,8 +32,29 @@ NAN_METHOD(readImage) {
   }
 
   if (info.Length() >= 2) {
-    if (info[1]->IsInt32()) {
-      int depth = Nan::To<int>(info[1]).FromJust();
+    auto type = info[1];
+    bool typeRequired = true;
+
+    if (info[1]->IsObject() && !info[1]->IsFunction()) {
+      auto opt = info[1];
+
+      if (has(opt, "autoOrient")) {
+        autoOrient = Nan::To<bool>(getValue(opt, "autoOrient")).FromJust();
+      }
+
+      if (has(opt, "cache")) {
+        cache = Nan::To<bool>(getValue(opt, "cache")).FromJust();
+      }
+
+      if (has(opt, "type")) {
+        type = getValue(opt, "type");
+      } else {
+        typeRequired = false;
+      }
+    }
+
+    if (type->IsInt32()) {
+      int depth = Nan::To<int>(type).FromJust();
 
       if (depth == ImageTypeGray) {
         readType = cv::IMREAD_GRAYSCALE;
@@ -34,12 +62,16 @@ NAN_METHOD(readImage) {
         readType = cv::IMREAD_COLOR;
       } else if (depth == ImageTypeBGRA) {
         readType = cv::IMREAD_UNCHANGED;
+      } else if (depth == ImageTypeGray16) {
+        readType = cv::IMREAD_GRAYSCALE | cv::IMREAD_ANYDEPTH;
+      } else if (depth == ImageTypeBGR16) {
+        readType = cv::IMREAD_COLOR | cv::IMREAD_ANYDEPTH;
       } else {
-        Nan::ThrowError("second argument (readType) must be a one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA]");
+        Nan::ThrowError("second argument (readType) must be a one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA, cv.ImageType.Gray16, cv.ImageType.BGR16]");
         return;
       }
-    } else if (!info[1]->IsFunction()) {
-      Nan::ThrowError("second argument (readType) must be a one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA]");
+    } else if (typeRequired && !type->IsFunction()) {
+      Nan::ThrowError("second argument (readType) must be a one of [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA, cv.ImageType.Gray16, cv.ImageType.BGR16]");
       return;
     }
   }
@@ -51,16 +83,34 @@ NAN_METHOD(readImage) {
 
   std::string filePath(v8::String::Utf8Value(info[0]->ToString()).operator*());
 
-  maybeAsyncOp<cv::Mat>(info, [filePath, readType]() {
-    auto image = cv::imread(filePath, readType);
+  maybeAsyncOp<cv::Mat>(info, [filePath, readType, autoOrient, cache]() {
+    auto key = cache ? ImageCache::fileKey(filePath, readType, autoOrient) : std::string();
 
-    if (image.empty()) {
-      throw std::runtime_error(std::string("invalid image file ") + "\"" + filePath + "\"");
-    }
+    return cachedImage(key, [&filePath, readType, autoOrient]() {
+      // OpenCV applies the EXIF orientation itself for some read types. We do it ourselves
+      // so that the result is the same for all types.
+      auto flags = autoOrient && readType != cv::IMREAD_UNCHANGED ? readType | cv::IMREAD_IGNORE_ORIENTATION : readType;
+      auto image = cv::imread(filePath, flags);
+
+      if (image.empty()) {
+        throw std::runtime_error(std::string("invalid image file ") + "\"" + filePath + "\"");
+      }
+
+      if (autoOrient) {
+        FileImageSource source(filePath);
+        applyOrientation(image, readOrientation(source));
+      }
+
+      // 8-bit files are scaled to the full 16-bit range when a 16-bit type is requested.
+      if (readType != cv::IMREAD_UNCHANGED && (readType & cv::IMREAD_ANYDEPTH) && image.depth() == CV_8U) {
+        image.convertTo(image, CV_16U, 257);
+      }
 
-    return image;
-  }, [](const cv::Mat& result) {
-    return Matrix::create(result);
+      return image;
+    });
+  }, [cache](const cv::Mat& result) {
+    // Images that may be shared through the cache are read-only.
+    return Matrix::create(result, cache);
   });
 }
 
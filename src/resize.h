@@ -6,29 +6,17 @@
 #include "utils.h"
 #include "constants.h"
 
-NAN_METHOD(resize) {
-  cv::Size size;
-
-  if (info.Length() < 2 || info.Length() > 3) {
-    Nan::ThrowError("expected at least two argument (image, sizeSpec) and at most three arguments (image, sizeSpec, callback)");
-    return;
-  }
-
-  if (!Matrix::isMatrix(info[0])) {
-    Nan::ThrowError("first argument (image) must be a Matrix");
-    return;
-  }
-
-  cv::Mat image = Matrix::get(info[0]);
-  v8::Local<v8::Value> sizeSpec = info[1];
-  const double aspectRatio = static_cast<double>(image.size().height) / static_cast<double>(image.size().width);
+/**
+ * Computes the output size of a sizeSpec. Returns an error message or nullptr on success.
+ */
+const char* getResizeSize(v8::Local<v8::Value> sizeSpec, const cv::Size& imageSize, cv::Size& size) {
+  const double aspectRatio = static_cast<double>(imageSize.height) / static_cast<double>(imageSize.width);
 
   if (sizeSpec->IsInt32()) {
     int width = Nan::To<int>(sizeSpec).FromJust();
 
     if (width <= 0) {
-      Nan::ThrowError("if the second argument (sizeSpec) is a number it must be a positive integer");
-      return;
+      return "if the second argument (sizeSpec) is a number it must be a positive integer";
     }
 
     size.width = width;
@@ -43,15 +31,13 @@ NAN_METHOD(resize) {
       size.height = get<int>(sizeSpec, "height");
 
       if (size.width <= 0 || size.height <= 0) {
-        Nan::ThrowError("width and height must be a positive integers");
-        return;
+        return "width and height must be a positive integers";
       }
     } else if (has(sizeSpec, "width") && getValue(sizeSpec, "width")->IsInt32()) {
       size.width = get<int>(sizeSpec, "width");
 
       if (size.width <= 0) {
-        Nan::ThrowError("width must be a positive integer");
-        return;
+        return "width must be a positive integer";
       }
 
       size.height = cvRound(size.width * aspectRatio);
@@ -59,8 +45,7 @@ NAN_METHOD(resize) {
       size.height = get<int>(sizeSpec, "height");
 
       if (size.height <= 0) {
-        Nan::ThrowError("height must be a positive integer");
-        return;
+        return "height must be a positive integer";
       }
 
       size.width = cvRound(size.height / aspectRatio);
@@ -68,12 +53,11 @@ NAN_METHOD(resize) {
       double scale = get<double>(sizeSpec, "scale");
 
       if (scale <= 0) {
-        Nan::ThrowError("scale must be positive floating point number");
-        return;
+        return "scale must be positive floating point number";
       }
 
-      size.width = cvRound(image.size().width * scale);
-      size.height = cvRound(image.size().height * scale);
+      size.width = cvRound(imageSize.width * scale);
+      size.height = cvRound(imageSize.height * scale);
     } else if (has(sizeSpec, "xScale")
         && has(sizeSpec, "yScale")
         && getValue(sizeSpec, "xScale")->IsNumber()
@@ -83,18 +67,84 @@ NAN_METHOD(resize) {
       double yScale = get<double>(sizeSpec, "yScale");
 
       if (xScale <= 0 || yScale <= 0) {
-        Nan::ThrowError("xScale and yScale must be positive floating point numbers");
-        return;
+        return "xScale and yScale must be positive floating point numbers";
       }
 
-      size.width = cvRound(image.size().width * xScale);
-      size.height = cvRound(image.size().height * yScale);
+      size.width = cvRound(imageSize.width * xScale);
+      size.height = cvRound(imageSize.height * yScale);
     } else {
-      Nan::ThrowError("second argument (sizeSpec) must be a valid sizeSpec object");
-      return;
+      return "second argument (sizeSpec) must be a valid sizeSpec object";
     }
   } else {
-    Nan::ThrowError("second argument (sizeSpec) must be an integer or an object");
+    return "second argument (sizeSpec) must be an integer or an object";
+  }
+
+  return nullptr;
+}
+
+/**
+ * Builds the pyrDown cascade of `image` needed for outputs of width `minWidth`.
+ * `levels[0]` is the image itself.
+ */
+std::vector<cv::Mat> resizePyramid(const cv::Mat& image, int minWidth) {
+  std::vector<cv::Mat> levels(1, image);
+
+  while (levels.back().cols / 2 >= minWidth) {
+    cv::Mat next;
+    cv::pyrDown(levels.back(), next);
+    levels.push_back(next);
+  }
+
+  return levels;
+}
+
+/**
+ * Resizes an image to `size` starting from the smallest pyramid level that is still at least
+ * twice as large as `size` and finishing with a bicubic resize. Upscaling uses pyrUp from
+ * the first level.
+ */
+cv::Mat resizeFromPyramid(const std::vector<cv::Mat>& levels, cv::Size size) {
+  cv::Mat output;
+  size_t level = 0;
+
+  while (level + 1 < levels.size() && levels[level].cols / 2 >= size.width) {
+    ++level;
+  }
+
+  output = levels[level];
+
+  while (output.cols * 2 <= size.width) {
+    cv::pyrUp(output, output);
+  }
+
+  if (output.cols != size.width || output.rows != size.height) {
+    cv::resize(output, output, size, 0, 0, cv::INTER_CUBIC);
+  } else if (output.data == levels[level].data) {
+    // Never share the data with the source image.
+    output = output.clone();
+  }
+
+  return output;
+}
+
+NAN_METHOD(resize) {
+  cv::Size size;
+
+  if (info.Length() < 2 || info.Length() > 3) {
+    Nan::ThrowError("expected at least two argument (image, sizeSpec) and at most three arguments (image, sizeSpec, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  cv::Mat image = Matrix::get(info[0]);
+  auto error = getResizeSize(info[1], image.size(), size);
+
+  if (error) {
+    Nan::ThrowError(error);
     return;
   }
 
@@ -104,27 +154,11 @@ NAN_METHOD(resize) {
   }
 
   maybeAsyncOp<cv::Mat>(info, [size, image]() {
-    cv::Mat output = image.clone();
-
     if (image.empty()) {
-      return output;
-    }
-
-    if (size.width > output.cols) {
-      while (output.cols * 2 <= size.width) {
-        cv::pyrUp(output, output);
-      }
-    } else {
-      while (output.cols / 2 >= size.width) {
-        cv::pyrDown(output, output);
-      }
-    }
-
-    if (output.cols != size.width || output.rows != size.height) {
-      cv::resize(output, output, size, 0, 0, cv::INTER_CUBIC);
+      return image.clone();
     }
 
-    return output;
+    return resizeFromPyramid(resizePyramid(image, size.width), size);
   }, [](const cv::Mat& result) {
     return Matrix::create(result);
   });
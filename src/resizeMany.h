@@ -0,0 +1,165 @@
+#ifndef SIMPLE_CV_RESIZE_MANY_H
+#define SIMPLE_CV_RESIZE_MANY_H
+
+#include "Matrix.h"
+#include "async.h"
+#include "utils.h"
+#include "resize.h"
+#include "encodeImage.h"
+
+struct ResizeManyResult {
+  std::vector<cv::Mat> images;
+  std::vector<std::vector<uchar>> encoded;
+};
+
+/**
+ * Resizes (and optionally encodes) each output in parallel. The pyramid levels
+ * are only read so they can be shared between the outputs.
+ */
+class ResizeManyBody : public cv::ParallelLoopBody {
+
+public:
+
+  ResizeManyBody(const std::vector<cv::Mat>& levels, const std::vector<cv::Size>& sizes, int encodeType, int quality, ResizeManyResult& result)
+    : levels(levels)
+    , sizes(sizes)
+    , encodeType(encodeType)
+    , quality(quality)
+    , result(result) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    for (int i = range.start; i < range.end; ++i) {
+      auto output = resizeFromPyramid(levels, sizes[i]);
+
+      if (encodeType >= 0) {
+        encodeWithQuality(output, encodeType, quality, result.encoded[i]);
+      } else {
+        result.images[i] = output;
+      }
+    }
+  }
+
+private:
+
+  const std::vector<cv::Mat>& levels;
+  const std::vector<cv::Size>& sizes;
+  int encodeType;
+  int quality;
+  ResizeManyResult& result;
+};
+
+/**
+ * resizeMany(image, [sizeSpec, ...])
+ * resizeMany(image, [sizeSpec, ...], callback)
+ * resizeMany(image, [sizeSpec, ...], {encode?, quality?})
+ * resizeMany(image, [sizeSpec, ...], {encode?, quality?}, callback)
+ */
+NAN_METHOD(resizeMany) {
+  if (info.Length() < 2 || info.Length() > 4) {
+    Nan::ThrowError("expected at least two arguments (image, sizeSpecs) and at most four arguments (image, sizeSpecs, opt, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  if (!info[1]->IsArray()) {
+    Nan::ThrowError("second argument (sizeSpecs) must be an array of sizeSpecs");
+    return;
+  }
+
+  cv::Mat image = Matrix::get(info[0]);
+  auto specs = info[1].As<v8::Array>();
+  std::vector<cv::Size> sizes;
+  auto encodeType = -1;
+  auto quality = -1;
+
+  for (unsigned i = 0; i < specs->Length(); ++i) {
+    cv::Size size;
+    auto error = getResizeSize(Nan::Get(specs, i).ToLocalChecked(), image.size(), size);
+
+    if (error) {
+      Nan::ThrowError(error);
+      return;
+    }
+
+    sizes.push_back(size);
+  }
+
+  if (info.Length() >= 3 && info[2]->IsObject() && !info[2]->IsFunction()) {
+    auto opt = info[2];
+
+    if (has(opt, "encode")) {
+      if (!isEncodeType(getValue(opt, "encode"))) {
+        Nan::ThrowError("encode must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG, cv.EncodeType.WebP]");
+        return;
+      }
+
+      encodeType = get<int>(opt, "encode");
+    }
+
+    if (has(opt, "quality")) {
+      quality = get<int>(opt, "quality");
+
+      if (encodeType != EncodeTypeJPEG && encodeType != EncodeTypeWebP) {
+        Nan::ThrowError("quality is only supported when encode is cv.EncodeType.JPEG or cv.EncodeType.WebP");
+        return;
+      }
+
+      if (quality < 1 || quality > 100) {
+        Nan::ThrowError("quality must be between 1 and 100");
+        return;
+      }
+    }
+  }
+
+  maybeAsyncOp<ResizeManyResult>(info, [image, sizes, encodeType, quality]() {
+    ResizeManyResult result;
+
+    if (encodeType >= 0) {
+      result.encoded.resize(sizes.size());
+    } else {
+      result.images.resize(sizes.size());
+    }
+
+    if (sizes.empty() || image.empty()) {
+      for (size_t i = 0; i < result.images.size(); ++i) {
+        result.images[i] = image.clone();
+      }
+
+      return result;
+    }
+
+    auto minWidth = std::min_element(sizes.begin(), sizes.end(), [](const cv::Size& a, const cv::Size& b) {
+      return a.width < b.width;
+    })->width;
+
+    // The pyrDown cascade is built once for the smallest output and every
+    // output starts from the nearest level that is large enough.
+    auto levels = resizePyramid(image, minWidth);
+
+    ResizeManyBody body(levels, sizes, encodeType, quality, result);
+    cv::parallel_for_(cv::Range(0, static_cast<int>(sizes.size())), body);
+
+    return result;
+  }, [encodeType](const ResizeManyResult& result) {
+    auto size = encodeType >= 0 ? result.encoded.size() : result.images.size();
+    auto arr = Nan::New<v8::Array>(size);
+
+    for (unsigned i = 0; i < size; ++i) {
+      if (encodeType >= 0) {
+        auto& data = result.encoded[i];
+        Nan::Set(arr, i, Nan::CopyBuffer(reinterpret_cast<const char*>(data.data()), static_cast<unsigned>(data.size())).ToLocalChecked());
+      } else {
+        Nan::Set(arr, i, Matrix::create(result.images[i]));
+      }
+    }
+
+    return arr;
+  });
+}
+
+#endif // SIMPLE_CV_RESIZE_MANY_H
@@ -0,0 +1,147 @@
+#ifndef SIMPLE_CV_ROTATE_QUARTER_TURNS_H
+#define SIMPLE_CV_ROTATE_QUARTER_TURNS_H
+
+#include "Matrix.h"
+#include "async.h"
+
+// Pixels are moved as opaque bytes so that one kernel works for all image types.
+template<int N>
+struct PixelBytes {
+  uchar bytes[N];
+};
+
+/**
+ * Rotates by 90 degrees one block of rows at a time. The destination is written
+ * sequentially while the reads stay inside a block of `BlockSize` source rows,
+ * which keeps both in the cache.
+ */
+template<typename T>
+class QuarterTurnBody : public cv::ParallelLoopBody {
+
+public:
+
+  static const int BlockSize = 32;
+
+  QuarterTurnBody(const cv::Mat& src, cv::Mat& dst, bool clockwise)
+    : src(src)
+    , dst(dst)
+    , clockwise(clockwise) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    for (int block = range.start; block < range.end; ++block) {
+      int rowStart = block * BlockSize;
+      int rowEnd = std::min(rowStart + BlockSize, dst.rows);
+
+      for (int colStart = 0; colStart < dst.cols; colStart += BlockSize) {
+        int colEnd = std::min(colStart + BlockSize, dst.cols);
+
+        for (int r = rowStart; r < rowEnd; ++r) {
+          T* out = dst.ptr<T>(r);
+
+          if (clockwise) {
+            for (int c = colStart; c < colEnd; ++c) {
+              out[c] = src.ptr<T>(src.rows - 1 - c)[r];
+            }
+          } else {
+            int srcCol = src.cols - 1 - r;
+
+            for (int c = colStart; c < colEnd; ++c) {
+              out[c] = src.ptr<T>(c)[srcCol];
+            }
+          }
+        }
+      }
+    }
+  }
+
+private:
+
+  const cv::Mat& src;
+  cv::Mat& dst;
+  bool clockwise;
+};
+
+template<typename T>
+void rotateQuarterTurn(const cv::Mat& src, cv::Mat& dst, bool clockwise) {
+  QuarterTurnBody<T> body(src, dst, clockwise);
+  int blocks = (dst.rows + QuarterTurnBody<T>::BlockSize - 1) / QuarterTurnBody<T>::BlockSize;
+  cv::parallel_for_(cv::Range(0, blocks), body);
+}
+
+/**
+ * Rotates an image by `turns` * 90 degrees counter-clockwise (the same direction
+ * as `cv::getRotationMatrix2D`). The result has the width and height swapped for
+ * odd number of turns and no pixel values are interpolated.
+ */
+cv::Mat rotateQuarterTurns(const cv::Mat& image, int turns) {
+  turns = ((turns % 4) + 4) % 4;
+
+  if (turns == 0) {
+    return image.clone();
+  }
+
+  cv::Mat output;
+
+  if (turns == 2) {
+    cv::flip(image, output, -1);
+    return output;
+  }
+
+  bool clockwise = turns == 3;
+  output.create(image.cols, image.rows, image.type());
+
+  switch (image.elemSize()) {
+    case 1: rotateQuarterTurn<PixelBytes<1>>(image, output, clockwise); break;
+    case 2: rotateQuarterTurn<PixelBytes<2>>(image, output, clockwise); break;
+    case 3: rotateQuarterTurn<PixelBytes<3>>(image, output, clockwise); break;
+    case 4: rotateQuarterTurn<PixelBytes<4>>(image, output, clockwise); break;
+    case 6: rotateQuarterTurn<PixelBytes<6>>(image, output, clockwise); break;
+    case 8: rotateQuarterTurn<PixelBytes<8>>(image, output, clockwise); break;
+    case 12: rotateQuarterTurn<PixelBytes<12>>(image, output, clockwise); break;
+    case 16: rotateQuarterTurn<PixelBytes<16>>(image, output, clockwise); break;
+    default:
+      cv::transpose(image, output);
+      cv::flip(output, output, clockwise ? 1 : 0);
+      break;
+  }
+
+  return output;
+}
+
+/**
+ * rotateQuarterTurns(image, turns)
+ * rotateQuarterTurns(image, turns, callback)
+ */
+NAN_METHOD(rotateQuarterTurns) {
+  if (info.Length() < 2 || info.Length() > 3) {
+    Nan::ThrowError("expected at least two arguments (image, turns) and at most three arguments (image, turns, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  if (!info[1]->IsInt32()) {
+    Nan::ThrowError("second argument (turns) must be an integer");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  cv::Mat image = Matrix::get(info[0]);
+  int turns = Nan::To<int>(info[1]).FromJust();
+
+  maybeAsyncOp<cv::Mat>(info, [image, turns]() {
+    return rotateQuarterTurns(image, turns);
+  }, [](const cv::Mat& result) {
+    return Matrix::create(result);
+  });
+}
+
+#endif // SIMPLE_CV_ROTATE_QUARTER_TURNS_H
@@ -0,0 +1,71 @@
+#ifndef SIMPLE_CV_SHARED_MATRIX_H
+#define SIMPLE_CV_SHARED_MATRIX_H
+
+#include <opencv2/opencv.hpp>
+#include <mutex>
+#include <map>
+
+/**
+ * Process wide registry of matrices that have been handed out to other threads.
+ *
+ * The addon is loaded only once per process even if it is required from multiple
+ * worker_threads, so the registry is shared by all of them. A `cv::Mat` is reference
+ * counted, which means that keeping a copy of the header here keeps the pixel data
+ * alive until the receiving thread takes it. No pixel data is ever copied, so read-only
+ * matrices stay read-only on the receiving side.
+ */
+class SharedMatrices {
+
+public:
+
+  static uint32_t put(const cv::Mat& mat, bool readOnly) {
+    std::lock_guard<std::mutex> lock(mutex());
+    uint32_t id = ++nextId();
+    entries()[id] = Entry{mat, readOnly};
+    return id;
+  }
+
+  static bool take(uint32_t id, cv::Mat& mat, bool& readOnly) {
+    std::lock_guard<std::mutex> lock(mutex());
+    auto it = entries().find(id);
+
+    if (it == entries().end()) {
+      return false;
+    }
+
+    mat = it->second.mat;
+    readOnly = it->second.readOnly;
+    entries().erase(it);
+
+    return true;
+  }
+
+  static bool release(uint32_t id) {
+    std::lock_guard<std::mutex> lock(mutex());
+    return entries().erase(id) != 0;
+  }
+
+private:
+
+  struct Entry {
+    cv::Mat mat;
+    bool readOnly;
+  };
+
+  static std::mutex& mutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  static uint32_t& nextId() {
+    static uint32_t nextId = 0;
+    return nextId;
+  }
+
+  static std::map<uint32_t, Entry>& entries() {
+    static std::map<uint32_t, Entry> entries;
+    return entries;
+  }
+};
+
+#endif //SIMPLE_CV_SHARED_MATRIX_H
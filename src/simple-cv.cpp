@@ -5,7 +5,10 @@
 #include "showImage.h"
 #include "waitKey.h"
 #include "resize.h"
+#include "resizeMany.h"
 #include "warpAffine.h"
+#include "createWarp.h"
+#include "Transform.h"
 #include "rotationMatrix.h"
 #include "flipUpDown.h"
 #include "flipLeftRight.h"
@@ -15,13 +18,35 @@
 #include "split.h"
 #include "merge.h"
 #include "lookup.h"
+#include "lookup3d.h"
 #include "gaussianBlur.h"
 #include "colorTemperature.h"
+#include "matrixFile.h"
+#include "probeImage.h"
+#include "rotateQuarterTurns.h"
+#include "imageCache.h"
+#include "openVideo.h"
+#include "createVideoWriter.h"
+#include "stats.h"
+#include "equalizeHist.h"
+#include "clahe.h"
+#include "perceptualHash.h"
+#include "HashIndex.h"
+#include "compare.h"
+#include "extractPatches.h"
+#include "composite.h"
+#include "boxes.h"
+#include "yuv.h"
 
 NAN_MODULE_INIT(Init) {
   initConstants(target);
 
   Matrix::init(target);
+  VideoReader::init(target);
+  VideoWriter::init(target);
+  HashIndex::init(target);
+  Warp::init(target);
+  Transform::init(target);
 
   Nan::SetMethod(target, "readImage", readImage);
   Nan::SetMethod(target, "decodeImage", decodeImage);
@@ -30,7 +55,9 @@ NAN_MODULE_INIT(Init) {
   Nan::SetMethod(target, "showImage", showImage);
   Nan::SetMethod(target, "waitKey", waitKey);
   Nan::SetMethod(target, "resize", resize);
+  Nan::SetMethod(target, "resizeMany", resizeMany);
   Nan::SetMethod(target, "warpAffine", warpAffine);
+  Nan::SetMethod(target, "createWarp", createWarp);
   Nan::SetMethod(target, "rotationMatrix", rotationMatrix);
   Nan::SetMethod(target, "flipUpDown", flipUpDown);
   Nan::SetMethod(target, "flipLeftRight", flipLeftRight);
@@ -40,8 +67,35 @@ NAN_MODULE_INIT(Init) {
   Nan::SetMethod(target, "split", split);
   Nan::SetMethod(target, "merge", merge);
   Nan::SetMethod(target, "lookup", lookup);
+  Nan::SetMethod(target, "composeLookups", composeLookups);
+  Nan::SetMethod(target, "lookup3d", lookup3d);
+  Nan::SetMethod(target, "readCubeLut", readCubeLut);
   Nan::SetMethod(target, "gaussianBlur", gaussianBlur);
   Nan::SetMethod(target, "colorTemperature", colorTemperature);
+  Nan::SetMethod(target, "mapMatrix", mapMatrix);
+  Nan::SetMethod(target, "saveMatrix", saveMatrix);
+  Nan::SetMethod(target, "probeImage", probeImage);
+  Nan::SetMethod(target, "rotateQuarterTurns", rotateQuarterTurns);
+  Nan::SetMethod(target, "setImageCacheLimit", setImageCacheLimit);
+  Nan::SetMethod(target, "clearImageCache", clearImageCache);
+  Nan::SetMethod(target, "imageCacheStats", imageCacheStats);
+  Nan::SetMethod(target, "openVideo", openVideo);
+  Nan::SetMethod(target, "createVideoWriter", createVideoWriter);
+  Nan::SetMethod(target, "stats", stats);
+  Nan::SetMethod(target, "histogram", histogram);
+  Nan::SetMethod(target, "countNonZero", countNonZero);
+  Nan::SetMethod(target, "equalizeHist", equalizeHist);
+  Nan::SetMethod(target, "clahe", clahe);
+  Nan::SetMethod(target, "perceptualHash", perceptualHash);
+  Nan::SetMethod(target, "hashDistance", hashDistance);
+  Nan::SetMethod(target, "compare", compare);
+  Nan::SetMethod(target, "extractPatches", extractPatches);
+  Nan::SetMethod(target, "composite", composite);
+  Nan::SetMethod(target, "nms", nms);
+  Nan::SetMethod(target, "boxIoU", boxIoU);
+  Nan::SetMethod(target, "clipBoxes", clipBoxes);
+  Nan::SetMethod(target, "fromYUV", fromYUV);
+  Nan::SetMethod(target, "toYUV", toYUV);
 }
 
-NODE_MODULE(simple_cv, Init)
\ No newline at end of file
+NAN_MODULE_WORKER_ENABLED(simple_cv, Init)
\ No newline at end of file
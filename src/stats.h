@@ -0,0 +1,362 @@
+#ifndef SIMPLE_CV_STATS_H
+#define SIMPLE_CV_STATS_H
+
+#include <mutex>
+#include <limits>
+
+#include "Matrix.h"
+#include "async.h"
+#include "utils.h"
+
+struct ChannelStats {
+  std::vector<double> mean;
+  std::vector<double> m2;
+  std::vector<double> min;
+  std::vector<double> max;
+  double count;
+
+  ChannelStats(int channels = 0)
+    : mean(channels, 0.0)
+    , m2(channels, 0.0)
+    , min(channels, std::numeric_limits<double>::infinity())
+    , max(channels, -std::numeric_limits<double>::infinity())
+    , count(0) {
+  }
+
+  /**
+   * Chan et al.'s pairwise update. `m2` is the sum of squared differences
+   * from the mean, so nothing large is subtracted from anything large.
+   */
+  void merge(const ChannelStats& other) {
+    if (other.count == 0) {
+      return;
+    }
+
+    double n = count + other.count;
+
+    for (size_t c = 0; c < mean.size(); ++c) {
+      double delta = other.mean[c] - mean[c];
+
+      mean[c] += delta * other.count / n;
+      m2[c] += other.m2[c] + delta * delta * count * other.count / n;
+      min[c] = std::min(min[c], other.min[c]);
+      max[c] = std::max(max[c], other.max[c]);
+    }
+
+    count = n;
+  }
+};
+
+/**
+ * Each stripe of rows is reduced into its own `ChannelStats` which are
+ * then merged. A stripe is read twice: once for the sum, minimum and
+ * maximum and once for the squared differences from the stripe mean.
+ */
+template<typename T>
+class ChannelStatsBody : public cv::ParallelLoopBody {
+
+public:
+
+  ChannelStatsBody(const cv::Mat& image, const cv::Mat& mask, ChannelStats& total, std::mutex& mutex)
+    : image(image)
+    , mask(mask)
+    , total(total)
+    , mutex(mutex) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    int channels = image.channels();
+    ChannelStats stats(channels);
+    std::vector<double> sum(channels, 0.0);
+
+    for (int row = range.start; row < range.end; ++row) {
+      auto p = image.ptr<T>(row);
+      auto m = mask.empty() ? nullptr : mask.ptr<uchar>(row);
+
+      for (int col = 0; col < image.cols; ++col, p += channels) {
+        if (m && !m[col]) {
+          continue;
+        }
+
+        for (int c = 0; c < channels; ++c) {
+          double value = p[c];
+
+          sum[c] += value;
+          stats.min[c] = std::min(stats.min[c], value);
+          stats.max[c] = std::max(stats.max[c], value);
+        }
+
+        ++stats.count;
+      }
+    }
+
+    if (stats.count == 0) {
+      return;
+    }
+
+    for (int c = 0; c < channels; ++c) {
+      stats.mean[c] = sum[c] / stats.count;
+    }
+
+    for (int row = range.start; row < range.end; ++row) {
+      auto p = image.ptr<T>(row);
+      auto m = mask.empty() ? nullptr : mask.ptr<uchar>(row);
+
+      for (int col = 0; col < image.cols; ++col, p += channels) {
+        if (m && !m[col]) {
+          continue;
+        }
+
+        for (int c = 0; c < channels; ++c) {
+          double delta = p[c] - stats.mean[c];
+          stats.m2[c] += delta * delta;
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    total.merge(stats);
+  }
+
+private:
+
+  const cv::Mat& image;
+  const cv::Mat& mask;
+  ChannelStats& total;
+  std::mutex& mutex;
+};
+
+template<typename T>
+ChannelStats channelStats(const cv::Mat& image, const cv::Mat& mask) {
+  ChannelStats total(image.channels());
+  std::mutex mutex;
+
+  ChannelStatsBody<T> body(image, mask, total, mutex);
+  cv::parallel_for_(cv::Range(0, image.rows), body);
+
+  return total;
+}
+
+ChannelStats channelStats(const cv::Mat& image, const cv::Mat& mask) {
+  switch (image.depth()) {
+    case CV_8U:
+      return channelStats<uchar>(image, mask);
+    case CV_16U:
+      return channelStats<ushort>(image, mask);
+    case CV_32F:
+      return channelStats<float>(image, mask);
+    default:
+      return channelStats<double>(image, mask);
+  }
+}
+
+/**
+ * Reads the optional `mask` option. Returns false if the mask is invalid.
+ */
+bool getMask(v8::Local<v8::Value> opt, const cv::Mat& image, cv::Mat& mask) {
+  if (!opt->IsObject() || opt->IsFunction() || !has(opt, "mask")) {
+    return true;
+  }
+
+  auto value = getValue(opt, "mask");
+
+  if (!Matrix::isMatrix(value)) {
+    return false;
+  }
+
+  mask = Matrix::get(value);
+  return mask.type() == ImageTypeGray && mask.size() == image.size();
+}
+
+/**
+ * stats(image)
+ * stats(image, callback)
+ * stats(image, {mask?})
+ * stats(image, {mask?}, callback)
+ */
+NAN_METHOD(stats) {
+  if (info.Length() < 1 || info.Length() > 3) {
+    Nan::ThrowError("expected at least one argument (image) and at most three arguments (image, opt, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  auto image = Matrix::get(info[0]);
+  cv::Mat mask;
+
+  if (info.Length() >= 2 && !getMask(info[1], image, mask)) {
+    Nan::ThrowError("mask must be a Gray matrix with the same size as the image");
+    return;
+  }
+
+  maybeAsyncOp<ChannelStats>(info, [image, mask]() {
+    return channelStats(image, mask);
+  }, [](const ChannelStats& stats) {
+    auto channels = stats.mean.size();
+    std::vector<double> mean(channels, 0.0);
+    std::vector<double> stddev(channels, 0.0);
+    std::vector<double> min(channels, 0.0);
+    std::vector<double> max(channels, 0.0);
+
+    if (stats.count > 0) {
+      for (size_t c = 0; c < channels; ++c) {
+        mean[c] = stats.mean[c];
+        stddev[c] = std::sqrt(stats.m2[c] / stats.count);
+        min[c] = stats.min[c];
+        max[c] = stats.max[c];
+      }
+    }
+
+    auto obj = Nan::New<v8::Object>();
+
+    Nan::Set(obj, Nan::New("mean").ToLocalChecked(), newTypedArray<v8::Float64Array>(mean.data(), channels));
+    Nan::Set(obj, Nan::New("stddev").ToLocalChecked(), newTypedArray<v8::Float64Array>(stddev.data(), channels));
+    Nan::Set(obj, Nan::New("min").ToLocalChecked(), newTypedArray<v8::Float64Array>(min.data(), channels));
+    Nan::Set(obj, Nan::New("max").ToLocalChecked(), newTypedArray<v8::Float64Array>(max.data(), channels));
+    Nan::Set(obj, Nan::New("count").ToLocalChecked(), Nan::New(stats.count));
+
+    return obj;
+  });
+}
+
+/**
+ * histogram(image)
+ * histogram(image, callback)
+ * histogram(image, {bins?, range?, mask?})
+ * histogram(image, {bins?, range?, mask?}, callback)
+ *
+ * Returns one Uint32Array per channel.
+ */
+NAN_METHOD(histogram) {
+  if (info.Length() < 1 || info.Length() > 3) {
+    Nan::ThrowError("expected at least one argument (image) and at most three arguments (image, opt, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  auto image = Matrix::get(info[0]);
+  auto bins = 256;
+  auto low = 0.0;
+  auto high = image.depth() == CV_16U ? 65536.0 : (image.depth() == CV_8U ? 256.0 : 1.0);
+  cv::Mat mask;
+
+  if (info.Length() >= 2 && info[1]->IsObject() && !info[1]->IsFunction()) {
+    auto opt = info[1];
+
+    if (has(opt, "bins")) {
+      bins = get<int>(opt, "bins");
+    }
+
+    if (has(opt, "range")) {
+      auto range = getValue(opt, "range");
+
+      if (!range->IsArray() || range.As<v8::Array>()->Length() != 2) {
+        Nan::ThrowError("range must be an array [min, max]");
+        return;
+      }
+
+      low = Nan::To<double>(Nan::Get(range.As<v8::Array>(), 0).ToLocalChecked()).FromJust();
+      high = Nan::To<double>(Nan::Get(range.As<v8::Array>(), 1).ToLocalChecked()).FromJust();
+    }
+  }
+
+  if (bins < 1 || bins > 65536) {
+    Nan::ThrowError("bins must be between 1 and 65536");
+    return;
+  }
+
+  if (high <= low) {
+    Nan::ThrowError("range must be an array [min, max] where min < max");
+    return;
+  }
+
+  if (info.Length() >= 2 && !getMask(info[1], image, mask)) {
+    Nan::ThrowError("mask must be a Gray matrix with the same size as the image");
+    return;
+  }
+
+  maybeAsyncOp<std::vector<std::vector<uint32_t>>>(info, [image, bins, low, high, mask]() {
+    cv::Mat source = image;
+
+    // calcHist doesn't support doubles.
+    if (source.depth() == CV_64F) {
+      source.convertTo(source, CV_MAKETYPE(CV_32F, source.channels()));
+    }
+
+    float range[] = { static_cast<float>(low), static_cast<float>(high) };
+    const float* ranges[] = { range };
+    std::vector<std::vector<uint32_t>> histograms;
+
+    for (int c = 0; c < source.channels(); ++c) {
+      cv::Mat hist;
+      cv::calcHist(&source, 1, &c, mask, hist, 1, &bins, ranges);
+
+      std::vector<uint32_t> counts(bins);
+
+      for (int i = 0; i < bins; ++i) {
+        counts[i] = static_cast<uint32_t>(hist.at<float>(i));
+      }
+
+      histograms.push_back(counts);
+    }
+
+    return histograms;
+  }, [](const std::vector<std::vector<uint32_t>>& histograms) {
+    auto arr = Nan::New<v8::Array>(histograms.size());
+
+    for (unsigned c = 0; c < histograms.size(); ++c) {
+      Nan::Set(arr, c, newTypedArray<v8::Uint32Array>(histograms[c].data(), histograms[c].size()));
+    }
+
+    return arr;
+  });
+}
+
+/**
+ * countNonZero(image)
+ * countNonZero(image, callback)
+ */
+NAN_METHOD(countNonZero) {
+  if (info.Length() < 1 || info.Length() > 2) {
+    Nan::ThrowError("expected at least one argument (image) and at most two arguments (image, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0]) || Matrix::get(info[0]).channels() != 1) {
+    Nan::ThrowError("first argument (image) must be a single channel Matrix");
+    return;
+  }
+
+  if (info.Length() == 2 && !info[1]->IsFunction()) {
+    Nan::ThrowError("second argument (callback) must be a function");
+    return;
+  }
+
+  auto image = Matrix::get(info[0]);
+
+  maybeAsyncOp<int>(info, [image]() {
+    return cv::countNonZero(image);
+  }, [](const int& count) {
+    return Nan::New(count);
+  });
+}
+
+#endif // SIMPLE_CV_STATS_H
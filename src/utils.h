@@ -2,6 +2,9 @@
 #define SIMPLE_CV_UTILS_H
 
 #include <nan.h>
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
 
 inline bool has(v8::Local<v8::Object> obj, const char* key) {
   Nan::HandleScope scope;
@@ -80,6 +83,19 @@ inline cv::Rect_<T> getRect(v8::Local<v8::Value> val) {
   return cv::Rect_<T>(get<T>(val, "x"), get<T>(val, "y"), get<T>(val, "width"), get<T>(val, "height"));
 }
 
+/**
+ * Whether `rect` is non-empty and lies inside `size`. The sides are compared to the space left
+ * after `x` and `y` instead of computing the right and bottom edges, which could overflow.
+ */
+inline bool isInside(const cv::Rect& rect, const cv::Size& size) {
+  return rect.width > 0
+    && rect.height > 0
+    && rect.x >= 0
+    && rect.y >= 0
+    && rect.width <= size.width - rect.x
+    && rect.height <= size.height - rect.y;
+}
+
 inline bool isColor(v8::Local<v8::Value> val) {
   Nan::HandleScope scope;
   return has(val, "red")
@@ -99,4 +115,29 @@ inline cv::Scalar_<T> getColor(v8::Local<v8::Value> val) {
   }
 }
 
+/**
+ * The largest typed array, in bytes, that `newTypedArray` can create.
+ */
+inline size_t maxTypedArrayBytes() {
+  return std::min<size_t>(node::Buffer::kMaxLength, UINT32_MAX);
+}
+
+/**
+ * Copies `length` values into a new typed array, for example `newTypedArray<v8::Float64Array>(values, n)`.
+ * Throws if the array would be larger than `maxTypedArrayBytes()`.
+ */
+template<typename Array, typename T>
+inline v8::Local<Array> newTypedArray(const T* data, size_t length) {
+  Nan::EscapableHandleScope scope;
+
+  if (length > maxTypedArrayBytes() / sizeof(T)) {
+    throw std::runtime_error("the result is too large for a typed array");
+  }
+
+  auto buffer = Nan::CopyBuffer(reinterpret_cast<const char *>(data), static_cast<uint32_t>(length * sizeof(T)));
+  auto bytes = buffer.ToLocalChecked().template As<v8::Uint8Array>();
+
+  return scope.Escape(Array::New(bytes->Buffer(), bytes->ByteOffset(), length));
+}
+
 #endif //SIMPLE_CV_UTILS_H
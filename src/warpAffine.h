@@ -6,11 +6,85 @@
 #include "utils.h"
 #include "constants.h"
 
+struct WarpOptions {
+  int borderType;
+  int borderValue;
+  int interpolation;
+
+  WarpOptions()
+    : borderType(BorderTypeConstant)
+    , borderValue(0)
+    , interpolation(InterpolationCubic) {
+  }
+};
+
+/**
+ * Reads the border and interpolation options shared by `warpAffine` and `createWarp`.
+ * Returns an error message or nullptr if the options are valid.
+ */
+const char* getWarpOptions(v8::Local<v8::Value> opt, WarpOptions& options) {
+  if (has(opt, "borderType")) {
+    if (!getValue(opt, "borderType")->IsInt32()) {
+      return "borderType must be one of cv.BorderType.[Constant, Reflect, Reflect101, Replicate, Wrap]";
+    }
+
+    options.borderType = get<int>(opt, "borderType");
+
+    if (options.borderType != BorderTypeConstant
+        && options.borderType != BorderTypeReflect
+        && options.borderType != BorderTypeReflect101
+        && options.borderType != BorderTypeReplicate
+        && options.borderType != BorderTypeWrap) {
+
+      return "borderType must be one of cv.BorderType.[Constant, Reflect, Reflect101, Replicate, Wrap]";
+    }
+  }
+
+  if (has(opt, "borderValue")) {
+    options.borderValue = get<int>(opt, "borderValue");
+  }
+
+  if (has(opt, "interpolation")) {
+    if (!getValue(opt, "interpolation")->IsInt32() || !isInterpolation(get<int>(opt, "interpolation"))) {
+      return "interpolation must be one of cv.Interpolation.[Nearest, Linear, Cubic, Lanczos4]";
+    }
+
+    options.interpolation = get<int>(opt, "interpolation");
+  }
+
+  return nullptr;
+}
+
+/**
+ * Reads an optional output size. Returns false if `key` is set but isn't a positive size.
+ */
+bool getWarpSize(v8::Local<v8::Value> opt, const char* key, cv::Size& size) {
+  if (!has(opt, key)) {
+    return true;
+  }
+
+  auto value = getValue(opt, key);
+
+  if (!isSize(value)) {
+    return false;
+  }
+
+  size = getSize<int>(value);
+  return size.width > 0 && size.height > 0;
+}
+
+/**
+ * Returns true if `trans` is a 3x2 float matrix.
+ */
+bool isAffineTransformation(const cv::Mat& trans) {
+  return trans.size().width == 3 && trans.size().height == 2 && trans.type() == ImageTypeFloat;
+}
+
 /**
  * warpAffine(image, transformation)
- * warpAffine(image, transformation, options)
+ * warpAffine(image, transformation, {borderType?, borderValue?, interpolation?, size?})
  * warpAffine(image, transformation, callback)
- * warpAffine(image, transformation, options, callback)
+ * warpAffine(image, transformation, {borderType?, borderValue?, interpolation?, size?}, callback)
  */
 NAN_METHOD(warpAffine) {
   if (info.Length() < 2 || info.Length() > 4) {
@@ -32,39 +106,27 @@ NAN_METHOD(warpAffine) {
 
   cv::Mat trans = Matrix::get(info[1]);
 
-  if (trans.size().width != 3 || trans.size().height != 2 || trans.type() != ImageTypeFloat) {
+  if (!isAffineTransformation(trans)) {
     Nan::ThrowError("second argument (transformation) must be a 3x2 float matrix");
     return;
   }
 
-  int borderType = BorderTypeConstant;
-  int borderValue = 0;
+  WarpOptions options;
+  cv::Size size = image.size();
 
   if (info.Length() >= 3) {
     if (info[2]->IsObject() && !info[2]->IsFunction()) {
       auto opt = info[2];
+      auto error = getWarpOptions(opt, options);
 
-      if (has(opt, "borderType")) {
-        if (!getValue(opt, "borderType")->IsInt32()) {
-          Nan::ThrowError("borderType must be one of cv.BorderType.[Constant, Reflect, Reflect101, Replicate, Wrap]");
-          return;
-        }
-
-        borderType = get<int>(opt, "borderType");
-
-        if (borderType != BorderTypeConstant
-            && borderType != BorderTypeReflect
-            && borderType != BorderTypeReflect101
-            && borderType != BorderTypeReplicate
-            && borderType != BorderTypeWrap) {
-
-          Nan::ThrowError("borderType must be one of cv.BorderType.[Constant, Reflect, Reflect101, Replicate, Wrap]");
-          return;
-        }
+      if (error) {
+        Nan::ThrowError(error);
+        return;
       }
 
-      if (has(opt, "borderValue")) {
-        borderValue = get<int>(opt, "borderValue");
+      if (!getWarpSize(opt, "size", size)) {
+        Nan::ThrowError("size must be a size {width, height} with a positive width and height");
+        return;
       }
     } else if (!info[2]->IsFunction()) {
       Nan::ThrowError("third argument must be either a callback or an options object");
@@ -72,9 +134,9 @@ NAN_METHOD(warpAffine) {
     }
   }
 
-  maybeAsyncOp<cv::Mat>(info, [image, trans, borderType, borderValue]() {
+  maybeAsyncOp<cv::Mat>(info, [image, trans, size, options]() {
     cv::Mat output;
-    cv::warpAffine(image, output, trans, image.size(), CV_INTER_CUBIC, borderType, borderValue);
+    cv::warpAffine(image, output, trans, size, options.interpolation, options.borderType, options.borderValue);
     return output;
   }, [](const cv::Mat& result) {
     return Matrix::create(result);
@@ -0,0 +1,493 @@
+#ifndef SIMPLE_CV_YUV_H
+#define SIMPLE_CV_YUV_H
+
+#include <cstring>
+#include <memory>
+
+#include "Matrix.h"
+#include "async.h"
+#include "utils.h"
+#include "constants.h"
+
+struct YUVLayout {
+  int format;
+  int width;
+  int height;
+  int stride;
+
+  bool planar() const {
+    return format == YUVFormatNV12 || format == YUVFormatNV21 || format == YUVFormatI420;
+  }
+
+  /**
+   * The number of bytes a frame occupies. Both planes of NV12 and NV21 use `stride`,
+   * the U and V planes of I420 use `stride / 2`.
+   */
+  size_t byteLength() const {
+    auto luma = static_cast<size_t>(stride) * height;
+
+    if (format == YUVFormatI420) {
+      return luma + 2 * static_cast<size_t>(stride / 2) * (height / 2);
+    } else if (planar()) {
+      return luma + static_cast<size_t>(stride) * (height / 2);
+    } else {
+      return luma;
+    }
+  }
+};
+
+inline bool isYUVFormat(int format) {
+  return format == YUVFormatNV12
+    || format == YUVFormatNV21
+    || format == YUVFormatI420
+    || format == YUVFormatYUYV
+    || format == YUVFormatUYVY;
+}
+
+/**
+ * BT.601 limited range YUV to BGR for full resolution chroma, in the same 20 bit fixed
+ * point as OpenCV's YUV420 conversions. The loop is branch free so that the compiler can
+ * vectorize it.
+ */
+class YUV444ToBGRBody : public cv::ParallelLoopBody {
+
+public:
+
+  YUV444ToBGRBody(const cv::Mat& y, const cv::Mat& u, const cv::Mat& v, cv::Mat& bgr)
+    : y(y)
+    , u(u)
+    , v(v)
+    , bgr(bgr) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    const int cy = 1220542;
+    const int cub = 2116026;
+    const int cug = -409993;
+    const int cvg = -852492;
+    const int cvr = 1673527;
+    const int round = 1 << 19;
+
+    for (int row = range.start; row < range.end; ++row) {
+      auto yp = y.ptr<uchar>(row);
+      auto up = u.ptr<uchar>(row);
+      auto vp = v.ptr<uchar>(row);
+      auto out = bgr.ptr<uchar>(row);
+
+      for (int col = 0; col < bgr.cols; ++col) {
+        int luma = std::max(yp[col] - 16, 0) * cy + round;
+        int du = up[col] - 128;
+        int dv = vp[col] - 128;
+
+        out[col * 3] = cv::saturate_cast<uchar>((luma + cub * du) >> 20);
+        out[col * 3 + 1] = cv::saturate_cast<uchar>((luma + cug * du + cvg * dv) >> 20);
+        out[col * 3 + 2] = cv::saturate_cast<uchar>((luma + cvr * dv) >> 20);
+      }
+    }
+  }
+
+private:
+
+  const cv::Mat& y;
+  const cv::Mat& u;
+  const cv::Mat& v;
+  cv::Mat& bgr;
+};
+
+/**
+ * Converts a 4:2:0 frame straight to half resolution BGR. The luma plane is box filtered
+ * down to the chroma resolution so that only a quarter of the pixels are converted. Used
+ * when the requested output is at most half the size of the frame.
+ */
+cv::Mat yuv420ToHalfBGR(const uchar* data, const YUVLayout& layout) {
+  const int w = layout.width;
+  const int h = layout.height;
+  const uchar* chroma = data + static_cast<size_t>(layout.stride) * h;
+
+  cv::Mat y(h, w, CV_8UC1, const_cast<uchar*>(data), layout.stride);
+  cv::Mat u, v;
+
+  if (layout.format == YUVFormatI420) {
+    auto chromaStride = static_cast<size_t>(layout.stride / 2);
+    u = cv::Mat(h / 2, w / 2, CV_8UC1, const_cast<uchar*>(chroma), chromaStride);
+    v = cv::Mat(h / 2, w / 2, CV_8UC1, const_cast<uchar*>(chroma) + chromaStride * (h / 2), chromaStride);
+  } else {
+    std::vector<cv::Mat> planes;
+    cv::split(cv::Mat(h / 2, w / 2, CV_8UC2, const_cast<uchar*>(chroma), layout.stride), planes);
+
+    u = planes[layout.format == YUVFormatNV12 ? 0 : 1];
+    v = planes[layout.format == YUVFormatNV12 ? 1 : 0];
+  }
+
+  cv::Mat halfY;
+  cv::Mat bgr(h / 2, w / 2, CV_8UC3);
+
+  cv::resize(y, halfY, u.size(), 0, 0, cv::INTER_AREA);
+
+  YUV444ToBGRBody body(halfY, u, v, bgr);
+  cv::parallel_for_(cv::Range(0, bgr.rows), body);
+
+  return bgr;
+}
+
+/**
+ * Returns the planar frame as a single continuous (height * 3 / 2) x width matrix, the
+ * layout cv::cvtColor expects. The buffer is used as is if it has no row padding.
+ */
+cv::Mat packedYUV420(const uchar* data, const YUVLayout& layout) {
+  const int w = layout.width;
+  const int h = layout.height;
+
+  if (layout.stride == w) {
+    return cv::Mat(h * 3 / 2, w, CV_8UC1, const_cast<uchar*>(data));
+  }
+
+  cv::Mat packed(h * 3 / 2, w, CV_8UC1);
+  auto dst = packed.data;
+  auto src = data;
+
+  for (int row = 0; row < h; ++row, dst += w, src += layout.stride) {
+    std::memcpy(dst, src, w);
+  }
+
+  if (layout.format == YUVFormatI420) {
+    auto chromaStride = layout.stride / 2;
+
+    // The U plane followed by the V plane.
+    for (int row = 0; row < h; ++row, dst += w / 2, src += chromaStride) {
+      std::memcpy(dst, src, w / 2);
+    }
+  } else {
+    for (int row = 0; row < h / 2; ++row, dst += w, src += layout.stride) {
+      std::memcpy(dst, src, w);
+    }
+  }
+
+  return packed;
+}
+
+cv::Mat convertFromYUV(const uchar* data, const YUVLayout& layout, int type, cv::Size size) {
+  const int w = layout.width;
+  const int h = layout.height;
+  const bool resize = size.area() != 0 && size != cv::Size(w, h);
+  cv::Mat output;
+
+  if (type == ImageTypeGray && layout.planar()) {
+    // The luma plane is the gray image. Nothing needs to be converted.
+    cv::Mat y(h, w, CV_8UC1, const_cast<uchar*>(data), layout.stride);
+
+    if (!resize) {
+      return y.clone();
+    }
+
+    output = y;
+  } else if (type == ImageTypeBGR && layout.planar() && resize && size.width * 2 <= w && size.height * 2 <= h) {
+    output = yuv420ToHalfBGR(data, layout);
+  } else if (layout.planar()) {
+    int codes[] = { cv::COLOR_YUV2BGR_NV12, cv::COLOR_YUV2BGR_NV21, cv::COLOR_YUV2BGR_I420 };
+    cv::cvtColor(packedYUV420(data, layout), output, codes[layout.format]);
+  } else {
+    cv::Mat packed(h, w, CV_8UC2, const_cast<uchar*>(data), layout.stride);
+    int code;
+
+    if (layout.format == YUVFormatYUYV) {
+      code = type == ImageTypeGray ? cv::COLOR_YUV2GRAY_YUYV : cv::COLOR_YUV2BGR_YUYV;
+    } else {
+      code = type == ImageTypeGray ? cv::COLOR_YUV2GRAY_UYVY : cv::COLOR_YUV2BGR_UYVY;
+    }
+
+    cv::cvtColor(packed, output, code);
+  }
+
+  if (resize) {
+    auto shrink = size.width < output.cols || size.height < output.rows;
+    cv::Mat resized;
+    cv::resize(output, resized, size, 0, 0, shrink ? cv::INTER_AREA : cv::INTER_LINEAR);
+    output = resized;
+  }
+
+  return output;
+}
+
+/**
+ * BGR to BT.601 limited range YUV, the inverse of OpenCV's YUV to BGR conversions. Each job
+ * converts a stripe of rows. The chroma of 4:2:0 formats is computed from the average color
+ * of each 2x2 block and the chroma of 4:2:2 formats from the average of each pixel pair.
+ */
+class BGRToYUVBody : public cv::ParallelLoopBody {
+
+public:
+
+  BGRToYUVBody(const cv::Mat& image, int format, uchar* output)
+    : image(image)
+    , format(format)
+    , output(output) {
+  }
+
+  void operator()(const cv::Range& range) const {
+    const int w = image.cols;
+    const int channels = image.channels();
+    const bool planar = format == YUVFormatNV12 || format == YUVFormatNV21 || format == YUVFormatI420;
+
+    // Rows for 4:2:2, pairs of rows for 4:2:0.
+    for (int i = range.start; i < range.end; ++i) {
+      const int row = planar ? i * 2 : i;
+      const int rows = planar ? 2 : 1;
+
+      for (int k = 0; k < rows; ++k) {
+        auto p = image.ptr<uchar>(row + k);
+
+        if (planar) {
+          auto y = output + static_cast<size_t>(row + k) * w;
+
+          for (int col = 0; col < w; ++col, p += channels) {
+            y[col] = luma(p[0], p[1], p[2]);
+          }
+        } else {
+          auto out = output + static_cast<size_t>(row) * w * 2;
+          auto yIndex = format == YUVFormatYUYV ? 0 : 1;
+          auto cIndex = format == YUVFormatYUYV ? 1 : 0;
+
+          for (int col = 0; col < w; col += 2, p += channels * 2, out += 4) {
+            auto b = (p[0] + p[channels] + 1) >> 1;
+            auto g = (p[1] + p[channels + 1] + 1) >> 1;
+            auto r = (p[2] + p[channels + 2] + 1) >> 1;
+
+            out[yIndex] = luma(p[0], p[1], p[2]);
+            out[yIndex + 2] = luma(p[channels], p[channels + 1], p[channels + 2]);
+            out[cIndex] = chromaU(b, g, r);
+            out[cIndex + 2] = chromaV(b, g, r);
+          }
+        }
+      }
+
+      if (planar) {
+        writeChroma420(i);
+      }
+    }
+  }
+
+private:
+
+  static inline uchar luma(int b, int g, int r) {
+    return static_cast<uchar>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+  }
+
+  static inline uchar chromaU(int b, int g, int r) {
+    return static_cast<uchar>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+  }
+
+  static inline uchar chromaV(int b, int g, int r) {
+    return static_cast<uchar>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+  }
+
+  void writeChroma420(int chromaRow) const {
+    const int w = image.cols;
+    const int h = image.rows;
+    const int channels = image.channels();
+    const size_t lumaSize = static_cast<size_t>(w) * h;
+
+    auto p0 = image.ptr<uchar>(chromaRow * 2);
+    auto p1 = image.ptr<uchar>(chromaRow * 2 + 1);
+
+    for (int col = 0; col < w / 2; ++col, p0 += channels * 2, p1 += channels * 2) {
+      auto b = (p0[0] + p0[channels] + p1[0] + p1[channels] + 2) >> 2;
+      auto g = (p0[1] + p0[channels + 1] + p1[1] + p1[channels + 1] + 2) >> 2;
+      auto r = (p0[2] + p0[channels + 2] + p1[2] + p1[channels + 2] + 2) >> 2;
+      auto u = chromaU(b, g, r);
+      auto v = chromaV(b, g, r);
+
+      if (format == YUVFormatI420) {
+        auto planeSize = static_cast<size_t>(w / 2) * (h / 2);
+        auto index = lumaSize + static_cast<size_t>(chromaRow) * (w / 2) + col;
+
+        output[index] = u;
+        output[index + planeSize] = v;
+      } else {
+        auto index = lumaSize + static_cast<size_t>(chromaRow) * w + col * 2;
+
+        output[index] = format == YUVFormatNV12 ? u : v;
+        output[index + 1] = format == YUVFormatNV12 ? v : u;
+      }
+    }
+  }
+
+  const cv::Mat& image;
+  int format;
+  uchar* output;
+};
+
+/**
+ * fromYUV(data, {format, width, height, stride?, type?, size?})
+ * fromYUV(data, {format, width, height, stride?, type?, size?}, callback)
+ */
+NAN_METHOD(fromYUV) {
+  if (info.Length() < 2 || info.Length() > 3) {
+    Nan::ThrowError("expected at least two arguments (data, opt) and at most three arguments (data, opt, callback)");
+    return;
+  }
+
+  if (!node::Buffer::HasInstance(info[0])) {
+    Nan::ThrowError("first argument (data) must be a Buffer");
+    return;
+  }
+
+  if (!info[1]->IsObject() || info[1]->IsFunction()) {
+    Nan::ThrowError("second argument (opt) must be an object");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  auto opt = info[1];
+  YUVLayout layout;
+  auto type = ImageTypeBGR;
+  cv::Size size;
+
+  if (!has(opt, "format") || !getValue(opt, "format")->IsInt32() || !isYUVFormat(get<int>(opt, "format"))) {
+    Nan::ThrowError("format must be one of cv.YUVFormat.[NV12, NV21, I420, YUYV, UYVY]");
+    return;
+  }
+
+  layout.format = get<int>(opt, "format");
+
+  if (!isSize(opt) || !getValue(opt, "width")->IsInt32() || !getValue(opt, "height")->IsInt32()) {
+    Nan::ThrowError("width and height must be positive integers");
+    return;
+  }
+
+  layout.width = get<int>(opt, "width");
+  layout.height = get<int>(opt, "height");
+
+  if (layout.width <= 0 || layout.height <= 0) {
+    Nan::ThrowError("width and height must be positive integers");
+    return;
+  }
+
+  if (layout.width % 2 != 0 || (layout.planar() && layout.height % 2 != 0)) {
+    Nan::ThrowError(layout.planar() ? "width and height must be even" : "width must be even");
+    return;
+  }
+
+  auto minStride = layout.planar() ? layout.width : layout.width * 2;
+  layout.stride = has(opt, "stride") ? get<int>(opt, "stride") : minStride;
+
+  if (layout.stride < minStride) {
+    auto message = "stride must be at least " + std::to_string(minStride);
+    Nan::ThrowError(message.c_str());
+    return;
+  }
+
+  // The chroma planes of I420 are read with `stride / 2`, which only lines up for even strides.
+  if (layout.format == YUVFormatI420 && layout.stride % 2 != 0) {
+    Nan::ThrowError("stride must be even for cv.YUVFormat.I420");
+    return;
+  }
+
+  if (has(opt, "type")) {
+    type = get<int>(opt, "type");
+
+    if (type != ImageTypeGray && type != ImageTypeBGR) {
+      Nan::ThrowError("type must be one of [cv.ImageType.Gray, cv.ImageType.BGR]");
+      return;
+    }
+  }
+
+  if (has(opt, "size")) {
+    auto value = getValue(opt, "size");
+
+    if (isSize(value)) {
+      size = getSize<int>(value);
+    }
+
+    if (size.width <= 0 || size.height <= 0) {
+      Nan::ThrowError("size must be a size {width, height} with a positive width and height");
+      return;
+    }
+  }
+
+  if (node::Buffer::Length(info[0]) < layout.byteLength()) {
+    auto message = "data must have at least " + std::to_string(layout.byteLength()) + " bytes";
+    Nan::ThrowError(message.c_str());
+    return;
+  }
+
+  // Synchronous calls convert straight from the buffer. An asynchronous job gets its own
+  // copy of the frame since the caller could modify the buffer, or transfer its memory
+  // to another thread, while the worker is reading it.
+  auto data = reinterpret_cast<const uchar*>(node::Buffer::Data(info[0]));
+  auto copy = std::make_shared<std::vector<uchar>>();
+
+  if (info[info.Length() - 1]->IsFunction()) {
+    copy->assign(data, data + layout.byteLength());
+    data = copy->data();
+  }
+
+  maybeAsyncOp<cv::Mat>(info, [data, copy, layout, type, size]() {
+    return convertFromYUV(data, layout, type, size);
+  }, [](const cv::Mat& result) {
+    return Matrix::create(result);
+  });
+}
+
+/**
+ * toYUV(image, format)
+ * toYUV(image, format, callback)
+ *
+ * Returns a Buffer with the frame without row padding.
+ */
+NAN_METHOD(toYUV) {
+  if (info.Length() < 2 || info.Length() > 3) {
+    Nan::ThrowError("expected at least two arguments (image, format) and at most three arguments (image, format, callback)");
+    return;
+  }
+
+  if (!Matrix::isMatrix(info[0])) {
+    Nan::ThrowError("first argument (image) must be a Matrix");
+    return;
+  }
+
+  if (!info[1]->IsInt32() || !isYUVFormat(Nan::To<int>(info[1]).FromJust())) {
+    Nan::ThrowError("second argument (format) must be one of cv.YUVFormat.[NV12, NV21, I420, YUYV, UYVY]");
+    return;
+  }
+
+  if (info.Length() == 3 && !info[2]->IsFunction()) {
+    Nan::ThrowError("third argument (callback) must be a function");
+    return;
+  }
+
+  cv::Mat image = Matrix::get(info[0]);
+
+  if (image.type() != ImageTypeBGR && image.type() != ImageTypeBGRA) {
+    Nan::ThrowError("first argument (image) must be a BGR or BGRA image");
+    return;
+  }
+
+  YUVLayout layout;
+  layout.format = Nan::To<int>(info[1]).FromJust();
+  layout.width = image.cols;
+  layout.height = image.rows;
+  layout.stride = layout.planar() ? image.cols : image.cols * 2;
+
+  if (layout.width % 2 != 0 || (layout.planar() && layout.height % 2 != 0)) {
+    Nan::ThrowError(layout.planar() ? "the image width and height must be even" : "the image width must be even");
+    return;
+  }
+
+  maybeAsyncOp<std::vector<uchar>>(info, [image, layout]() {
+    std::vector<uchar> output(layout.byteLength());
+
+    BGRToYUVBody body(image, layout.format, output.data());
+    cv::parallel_for_(cv::Range(0, layout.planar() ? layout.height / 2 : layout.height), body);
+
+    return output;
+  }, [](const std::vector<uchar>& output) {
+    return Nan::CopyBuffer(reinterpret_cast<const char*>(output.data()), static_cast<uint32_t>(output.size())).ToLocalChecked();
+  });
+}
+
+#endif // SIMPLE_CV_YUV_H
@@ -17,6 +17,21 @@ describe('simple-cv', () => {
   const alphaImageWidth = 90;
   const alphaImageHeight = 75;
 
+  // Inserts an EXIF APP1 segment with the given orientation after the SOI marker of a JPEG.
+  const withExifOrientation = (jpeg, orientation) => {
+    const tiff = Buffer.from([
+      0x4D, 0x4D, 0x00, 0x2A, 0x00, 0x00, 0x00, 0x08,
+      0x00, 0x01,
+      0x01, 0x12, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, orientation, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00
+    ]);
+
+    const header = Buffer.from([0xFF, 0xE1, 0x00, 0x00]);
+    header.writeUInt16BE(2 + 6 + tiff.length, 2);
+
+    return Buffer.concat([jpeg.slice(0, 2), header, Buffer.from('Exif\0\0', 'binary'), tiff, jpeg.slice(2)]);
+  };
+
   describe('cv.Matrix', () => {
 
     it('should be able to create from an array data', () => {
@@ -59,6 +74,26 @@ describe('simple-cv', () => {
       expect(matrix.toArray()).to.eql([1, 2, 3, 4, 5, 44 /* overflow */]);
     });
 
+    it('should be able to create 16 bit and 32 bit float matrices', () => {
+      const gray16 = new cv.Matrix({width: 2, height: 1, data: [1000, 65535], type: cv.ImageType.Gray16});
+      const bgr16 = new cv.Matrix({width: 1, height: 2, data: [1, 2, 300, 400, 5000, 6000], type: cv.ImageType.BGR16});
+      const float32 = new cv.Matrix({width: 2, height: 1, data: [0.5, -1.25], type: cv.ImageType.Float32});
+      const bgrFloat32 = new cv.Matrix(3, 4, cv.ImageType.BGRFloat32);
+
+      expect(gray16.type).to.equal(cv.ImageType.Gray16);
+      expect(gray16.toArray()).to.eql([1000, 65535]);
+
+      expect(bgr16.type).to.equal(cv.ImageType.BGR16);
+      expect(bgr16.toArray()).to.eql([1, 2, 300, 400, 5000, 6000]);
+
+      expect(float32.type).to.equal(cv.ImageType.Float32);
+      expect(float32.toArray()).to.eql([0.5, -1.25]);
+
+      expect(bgrFloat32.width).to.equal(3);
+      expect(bgrFloat32.height).to.equal(4);
+      expect(bgrFloat32.type).to.equal(cv.ImageType.BGRFloat32);
+    });
+
     it('should be able to create from width and height', () => {
       const matrix = new cv.Matrix(10, 20);
 
@@ -211,6 +246,26 @@ describe('simple-cv', () => {
         });
       });
 
+      it('should create a copy-on-write view', () => {
+        const matrix = new cv.Matrix([
+          [1, 2, 3],
+          [4, 5, 6],
+          [7, 8, 9]
+        ]);
+
+        let view;
+
+        return matrix.crop({x: 1, y: 1, width: 2, height: 2}, {view: true}).then(res => {
+          view = res;
+          expect(view.toArray()).to.eql([5, 6, 8, 9]);
+
+          return view.add(10);
+        }).then(() => {
+          expect(view.toArray()).to.eql([15, 16, 18, 19]);
+          expect(matrix.toArray()).to.eql([1, 2, 3, 4, 5, 6, 7, 8, 9]);
+        });
+      });
+
     });
 
     describe('Matrix.cropSync', () => {
@@ -251,6 +306,43 @@ describe('simple-cv', () => {
         });
       });
 
+      it('should copy the parent before it is modified if a view exists', () => {
+        const matrix = new cv.Matrix([
+          [1, 2, 3],
+          [4, 5, 6],
+          [7, 8, 9]
+        ]);
+
+        const view1 = matrix.cropSync({x: 0, y: 0, width: 2, height: 1}, {view: true});
+        const view2 = matrix.cropSync({x: 0, y: 0, width: 2, height: 1}, {view: true});
+
+        matrix.mulSync(2);
+        cv.drawRectangle(view1, {x: 0, y: 0, width: 2, height: 1}, {red: 0, green: 0, blue: 0}, -1);
+
+        expect(matrix.toArray()).to.eql([2, 4, 6, 8, 10, 12, 14, 16, 18]);
+        expect(view1.toArray()).to.eql([0, 0]);
+        expect(view2.toArray()).to.eql([1, 2]);
+      });
+
+      it('should create writable views of read-only matrices', () => {
+        cv.clearImageCache();
+        cv.setImageCacheLimit(64 * 1024 * 1024);
+
+        return cv.readImage(testImagePath, {cache: true}).then(image => {
+          expect(image.readOnly).to.equal(true);
+          const view = image.cropSync({x: 0, y: 0, width: 2, height: 2}, {view: true});
+
+          expect(view.readOnly).to.equal(false);
+          view.setSync(cv.matrix({width: 2, height: 2, type: cv.ImageType.BGR, data: _.range(12).map(() => 0)}), {x: 0, y: 0});
+
+          expect(view.toArray()).to.eql(_.range(12).map(() => 0));
+          expect(image.cropSync({x: 0, y: 0, width: 2, height: 2}).toArray()).to.eql(cv.readImageSync(testImagePath).cropSync({x: 0, y: 0, width: 2, height: 2}).toArray());
+        }).then(() => {
+          cv.clearImageCache();
+          cv.setImageCacheLimit(0);
+        });
+      });
+
     });
 
     describe('Matrix.clone', () => {
@@ -290,6 +382,58 @@ describe('simple-cv', () => {
 
     });
 
+    describe('Matrix.share', () => {
+
+      it('should share the matrix data without copying', () => {
+        const matrix = new cv.Matrix([
+          [1, 2],
+          [3, 4]
+        ]);
+
+        const handle = matrix.share();
+
+        expect(handle.width).to.equal(2);
+        expect(handle.height).to.equal(2);
+        expect(handle.type).to.equal(cv.ImageType.Float);
+
+        const shared = cv.Matrix.fromShared(handle);
+        matrix.addSync(10);
+
+        expect(shared.toArray()).to.eql([11, 12, 13, 14]);
+      });
+
+      it('should only allow a handle to be used once', () => {
+        const handle = new cv.Matrix(2, 2).share();
+
+        expect(cv.Matrix.releaseShared(handle)).to.equal(true);
+        expect(cv.Matrix.releaseShared(handle)).to.equal(false);
+
+        expect(() => cv.Matrix.fromShared(handle)).to.throwException(err => {
+          expect(err.message).to.equal('the shared matrix handle has already been used or released');
+        });
+      });
+
+      it('should pass a matrix to a worker thread', () => {
+        const { Worker } = require('worker_threads');
+        const matrix = new cv.Matrix([[1, 2, 3]]);
+
+        const worker = new Worker(`
+          const { parentPort, workerData } = require('worker_threads');
+          const cv = require(${JSON.stringify(__dirname)});
+          const matrix = cv.Matrix.fromShared(workerData);
+          parentPort.postMessage(matrix.toArray());
+        `, {eval: true, workerData: matrix.share()});
+
+        return new Promise((resolve, reject) => {
+          worker.on('message', resolve);
+          worker.on('error', reject);
+        }).then(data => {
+          expect(data).to.eql([1, 2, 3]);
+        });
+      });
+
+    });
+
     describe('Matrix.add', () => {
 
       it('should add a number', () => {
@@ -613,6 +757,120 @@ describe('simple-cv', () => {
 
     });
 
+    describe('Matrix.setMany', () => {
+
+      it('should set many tiles and resolve to the matrix', () => {
+        const target = new cv.Matrix([
+          [1, 2, 3],
+          [4, 5, 6],
+          [7, 8, 9]
+        ]);
+
+        return target.setMany([
+          {source: new cv.Matrix([[11], [22]]), x: 0, y: 0},
+          {source: new cv.Matrix([[33, 44]]), x: 1, y: 2}
+        ]).then(result => {
+          expect(result).to.equal(target);
+          expect(target.toArray()).to.eql([
+            11, 2, 3,
+            22, 5, 6,
+            7, 33, 44
+          ]);
+        });
+      });
+
+    });
+
+    describe('Matrix.setManySync', () => {
+
+      it('should draw later tiles over earlier ones', () => {
+        const target = new cv.Matrix([
+          [1, 2, 3],
+          [4, 5, 6],
+          [7, 8, 9]
+        ]);
+
+        const source = new cv.Matrix([
+          [11, 22],
+          [33, 44],
+        ]);
+
+        target.setManySync([
+          {source, x: 0, y: 0},
+          {source, x: 1, y: 1},
+          {source: new cv.Matrix([[55]]), x: 2, y: 0}
+        ]);
+
+        expect(target.toArray()).to.eql([
+          11, 22, 55,
+          33, 11, 22,
+          7,  33, 44
+        ]);
+      });
+
+      it('should resize tiles to the given width and height', () => {
+        const target = cv.matrix({width: 4, height: 4, type: cv.ImageType.Gray, data: new Array(16).fill(0)});
+        const source = cv.matrix({width: 1, height: 1, type: cv.ImageType.Gray, data: [200]});
+
+        target.setManySync([
+          {source, x: 1, y: 1, width: 2, height: 3}
+        ]);
+
+        expect(target.toArray()).to.eql([
+          0, 0,   0,   0,
+          0, 200, 200, 0,
+          0, 200, 200, 0,
+          0, 200, 200, 0
+        ]);
+      });
+
+      it('should not modify crop views of the matrix', () => {
+        const target = new cv.Matrix([
+          [1, 2],
+          [3, 4]
+        ]);
+
+        const view = target.cropSync({x: 0, y: 0, width: 1, height: 1}, {view: true});
+        target.setManySync([{source: new cv.Matrix([[9]]), x: 0, y: 0}]);
+
+        expect(target.toArray()).to.eql([9, 2, 3, 4]);
+        expect(view.toArray()).to.eql([1]);
+      });
+
+      it('should fail gracefully if a tile goes out of borders', () => {
+        const target = new cv.Matrix([
+          [1, 2, 3],
+          [4, 5, 6],
+          [7, 8, 9]
+        ]);
+
+        const source = new cv.Matrix([
+          [11, 22],
+          [33, 44],
+        ]);
+
+        expect(() => {
+          target.setManySync([{source, x: 0, y: 0}, {source, x: 2, y: 2}]);
+        }).to.throwException(err => {
+          expect(err.message).to.equal('tiles[1] (x=2..4, y=2..4) goes outside the matrix bounds (w=3, h=3)');
+        });
+
+        expect(target.toArray()).to.eql([1, 2, 3, 4, 5, 6, 7, 8, 9]);
+      });
+
+      it('should fail if the tile width overflows', () => {
+        const target = new cv.Matrix(3, 3, cv.ImageType.Gray);
+        const source = new cv.Matrix(1, 1, cv.ImageType.Gray);
+
+        expect(() => {
+          target.setManySync([{source, x: 2, y: 0, width: 2147483647}]);
+        }).to.throwException(err => {
+          expect(err.message).to.equal('tiles[0] (x=2..2147483649, y=0..1) goes outside the matrix bounds (w=3, h=3)');
+        });
+      });
+
+    });
+
     describe('Matrix.toBuffers', () => {
 
       it('should return an array with data buffer for each channel', () => {
@@ -678,6 +936,31 @@ describe('simple-cv', () => {
         expect(_.range(r.length).map(it => r[it])).eql([7, 7, 7, 8, 8, 8, 9, 9, 9]);
       });
 
+      it('should work with views', () => {
+        const matrix = cv.matrix({
+          width: 3,
+          height: 2,
+          type: cv.ImageType.BGR,
+          data: [
+            1, 2, 3,
+            4, 5, 6,
+
+            7, 8, 9,
+            10, 11, 12,
+
+            13, 14, 15,
+            16, 17, 18
+          ]
+        });
+
+        const view = matrix.cropSync({x: 1, y: 0, width: 2, height: 2}, {view: true});
+        const [b, g, r] = view.toBuffers().map(it => Array.from(it.data));
+
+        expect(b).to.eql([2, 3, 5, 6]);
+        expect(g).to.eql([8, 9, 11, 12]);
+        expect(r).to.eql([14, 15, 17, 18]);
+      });
+
     });
 
   });
@@ -726,6 +1009,83 @@ describe('simple-cv', () => {
 
   });
 
+  describe('Matrix.toTypedArray', () => {
+
+    it('should return a typed array that matches the depth of the matrix', () => {
+      const gray = cv.matrix({width: 2, height: 1, data: [1, 2], type: cv.ImageType.Gray});
+      const gray16 = cv.matrix({width: 2, height: 1, data: [1000, 2000], type: cv.ImageType.Gray16});
+      const float32 = cv.matrix({width: 2, height: 1, data: [0.5, 1.5], type: cv.ImageType.Float32});
+      const float = cv.matrix({width: 2, height: 1, data: [0.1, 0.2], type: cv.ImageType.Float});
+      const bgr16 = cv.matrix({width: 2, height: 1, data: [1, 2, 3, 4, 5, 6], type: cv.ImageType.BGR16});
+
+      expect(gray.toTypedArray()).to.be.a(Uint8Array);
+      expect(Array.from(gray.toTypedArray())).to.eql([1, 2]);
+
+      expect(gray16.toTypedArray()).to.be.a(Uint16Array);
+      expect(Array.from(gray16.toTypedArray())).to.eql([1000, 2000]);
+
+      expect(float32.toTypedArray()).to.be.a(Float32Array);
+      expect(Array.from(float32.toTypedArray())).to.eql([0.5, 1.5]);
+
+      expect(float.toTypedArray()).to.be.a(Float64Array);
+      expect(Array.from(float.toTypedArray())).to.eql([0.1, 0.2]);
+
+      // Interleaved like toBuffer.
+      expect(Array.from(bgr16.toTypedArray())).to.eql([1, 3, 5, 2, 4, 6]);
+      expect(bgr16.toBuffer().length).to.equal(12);
+    });
+
+  });
+
+  describe('Matrix.convertTo', () => {
+
+    it('should convert a matrix to another type', () => {
+      const gray = cv.matrix({width: 3, height: 1, data: [0, 128, 255], type: cv.ImageType.Gray});
+
+      return Promise.all([
+        gray.convertTo(cv.ImageType.Float32, {scale: 1 / 255}),
+        gray.convertTo(cv.ImageType.Gray16, {scale: 257}),
+        gray.convertTo(cv.ImageType.Float, {scale: 2, offset: -1})
+      ]).then(([float32, gray16, float]) => {
+        expect(float32.type).to.equal(cv.ImageType.Float32);
+        expect(float32.toArray().map(it => Math.round(it * 1000))).to.eql([0, 502, 1000]);
+
+        expect(gray16.type).to.equal(cv.ImageType.Gray16);
+        expect(gray16.toArray()).to.eql([0, 32896, 65535]);
+
+        expect(float.type).to.equal(cv.ImageType.Float);
+        expect(float.toArray()).to.eql([-1, 255, 509]);
+      });
+    });
+
+    it('should fail if the number of channels changes', (done) => {
+      const gray = cv.matrix({width: 3, height: 1, data: [0, 128, 255], type: cv.ImageType.Gray});
+
+      gray.convertTo(cv.ImageType.BGRFloat32).catch(err => {
+        expect(err.message).to.equal('first argument (type) must have the same number of channels as the matrix. Use convertColor to change the number of channels');
+        done();
+      });
+    });
+
+  });
+
+  describe('Matrix.convertToSync', () => {
+
+    it('should convert a matrix to another type', () => {
+      const bgr = cv.matrix({width: 1, height: 1, data: [10, 20, 30], type: cv.ImageType.BGR});
+      const bgrFloat32 = bgr.convertToSync(cv.ImageType.BGRFloat32, {scale: 0.5});
+
+      expect(bgrFloat32.type).to.equal(cv.ImageType.BGRFloat32);
+      expect(bgrFloat32.toArray()).to.eql([5, 10, 15]);
+
+      const back = bgrFloat32.convertToSync(cv.ImageType.BGR, {scale: 2});
+
+      expect(back.type).to.equal(cv.ImageType.BGR);
+      expect(back.toArray()).to.eql([10, 20, 30]);
+    });
+
+  });
+
   describe('cv.readImage', () => {
 
     it('should read an image', () => {
@@ -770,6 +1130,23 @@ describe('simple-cv', () => {
       });
     });
 
+    it('should apply the EXIF orientation if autoOrient is given', () => {
+      const filePath = path.join(os.tmpdir(), 'tmp-orientation.jpg');
+      fs.writeFileSync(filePath, withExifOrientation(fs.readFileSync(testImagePath), 8));
+
+      return Promise.all([
+        cv.readImage(filePath, {autoOrient: true}),
+        cv.readImage(filePath, {type: cv.ImageType.Gray, autoOrient: true}),
+        cv.readImage(filePath)
+      ]).then(([rotated, rotatedGray, unchanged]) => {
+        expect(rotated.width).to.equal(testImageHeight);
+        expect(rotated.height).to.equal(testImageWidth);
+        expect(rotatedGray.type).to.equal(cv.ImageType.Gray);
+        expect(rotatedGray.width).to.equal(testImageHeight);
+        expect(unchanged.width).to.equal(testImageWidth);
+      });
+    });
+
     it('should fail if trying to read an invalid or unsupported image', (done) => {
       cv.readImage(invalidImagePath).then(() => {
         done(new Error('should not get here'));
@@ -779,6 +1156,18 @@ describe('simple-cv', () => {
       }).catch(done);
     });
 
+    it('should read an image as 16 bit', () => {
+      return cv.readImage(testImagePath, cv.ImageType.Gray16).then(matrix => {
+        expect(matrix.type).to.equal(cv.ImageType.Gray16);
+        expect(matrix.width).to.equal(testImageWidth);
+
+        return cv.readImage(testImagePath, cv.ImageType.Gray).then(gray => {
+          // 8 bit images are scaled to the full 16 bit range.
+          expect(matrix.toTypedArray()[1000]).to.equal(gray.toTypedArray()[1000] * 257);
+        });
+      });
+    });
+
   });
 
   describe('cv.readImageSync', () => {
@@ -880,6 +1269,28 @@ describe('simple-cv', () => {
         .catch(done);
     });
 
+    it('should apply the EXIF orientation if autoOrient is given', () => {
+      const data = fs.readFileSync(testImagePath);
+
+      return Promise.all([
+        cv.decodeImage(data),
+        cv.decodeImage(withExifOrientation(data, 6), {autoOrient: true}),
+        cv.decodeImage(withExifOrientation(data, 3), {autoOrient: true})
+      ]).then(([original, rotated, upsideDown]) => {
+        expect(rotated.width).to.equal(testImageHeight);
+        expect(rotated.height).to.equal(testImageWidth);
+        expect(upsideDown.width).to.equal(testImageWidth);
+
+        // Orientation 6 is a 90 degree clockwise rotation: the bottom left pixel becomes the top left pixel.
+        const originalFirst = original.crop({x: 0, y: testImageHeight - 1, width: 1, height: 1});
+        const rotatedFirst = rotated.crop({x: 0, y: 0, width: 1, height: 1});
+
+        return Promise.all([originalFirst, rotatedFirst]);
+      }).then(([originalFirst, rotatedFirst]) => {
+        expect(rotatedFirst.toArray()).to.eql(originalFirst.toArray());
+      });
+    });
+
     it('should fail if invalid image data is given', (done) => {
       const buffer = fs.readFileSync(alphaImagePath);
 
@@ -945,6 +1356,14 @@ describe('simple-cv', () => {
       });
     });
 
+    it('should apply the EXIF orientation if autoOrient is given', () => {
+      const data = withExifOrientation(fs.readFileSync(testImagePath), 5);
+      const image = cv.decodeImageSync(data, {type: cv.ImageType.BGR, autoOrient: true});
+
+      expect(image.width).to.equal(testImageHeight);
+      expect(image.height).to.equal(testImageWidth);
+    });
+
     it('should fail if invalid image data is given', () => {
       expect(() => {
         cv.decodeImageSync(Buffer.allocUnsafe(1234))
@@ -955,1141 +1374,2881 @@ describe('simple-cv', () => {
 
   });
 
-  describe('cv.writeImage', () => {
-    const filePath = path.join(os.tmpdir(), 'tmp.png');
+  describe('cv.setImageCacheLimit', () => {
 
-    beforeEach(() => {
-      if (fs.existsSync(filePath)) {
-        fs.unlinkSync(filePath);
-      }
+    afterEach(() => {
+      cv.setImageCacheLimit(0);
+      cv.clearImageCache();
     });
 
-    it('should write an image', () => {
-      const filePath = path.join(os.tmpdir(), 'tmp.png');
-      const mat = new cv.Matrix([
-        [10, 20, 30],
-        [40, 50, 60]
-      ]);
+    it('should cache images read with the cache option', () => {
+      cv.setImageCacheLimit(100 * 1024 * 1024);
+      const before = cv.imageCacheStats();
+
+      return cv.readImage(testImagePath, {cache: true}).then(first => {
+        expect(first.readOnly).to.equal(true);
+        return Promise.all([first, cv.readImage(testImagePath, {cache: true})]);
+      }).then(([first, second]) => {
+        const stats = cv.imageCacheStats();
+
+        expect(stats.misses - before.misses).to.equal(1);
+        expect(stats.hits - before.hits).to.equal(1);
+        expect(stats.entries).to.equal(1);
+        expect(stats.bytes).to.equal(testImageWidth * testImageHeight * 3);
+        expect(second.toBuffer().equals(first.toBuffer())).to.equal(true);
+      });
+    });
 
-      return cv.writeImage(mat, filePath).then(() => {
-        expect(fs.existsSync(filePath)).to.equal(true);
-        return cv.readImage(filePath, cv.ImageType.Gray);
-      }).then(image => {
-        expect(image.toArray()).to.eql([10, 20, 30, 40, 50, 60]);
+    it('should keep cached images read-only when they are shared', () => {
+      cv.setImageCacheLimit(100 * 1024 * 1024);
+
+      return cv.readImage(testImagePath, {cache: true}).then(image => {
+        const shared = cv.Matrix.fromShared(image.share());
+
+        expect(shared.readOnly).to.equal(true);
+        expect(() => shared.setSync(cv.matrix({width: 1, height: 1, type: cv.ImageType.BGR, data: [0, 0, 0]}), {x: 0, y: 0})).to.throwException(err => {
+          expect(err.message).to.equal('the matrix is read-only');
+        });
       });
     });
 
-    it('should write an image with an alpha channel', () => {
-      return cv.readImage(alphaImagePath).then(image => {
-        return cv.writeImage(image, filePath);
-      }).then(() => {
-        return cv.readImage(filePath);
+    it('should cache decoded images by content', () => {
+      cv.setImageCacheLimit(100 * 1024 * 1024);
+      const data = fs.readFileSync(alphaImagePath);
+
+      return cv.decodeImage(data, {cache: true}).then(() => {
+        return cv.decodeImage(Buffer.from(data), {cache: true});
       }).then(image => {
-        expect(image.width).to.equal(alphaImageWidth);
-        expect(image.height).to.equal(alphaImageHeight);
         expect(image.type).to.equal(cv.ImageType.BGRA);
+        expect(cv.imageCacheStats().hits).to.be.greaterThan(0);
       });
     });
 
-  });
+    it('should evict the least recently used images', () => {
+      cv.setImageCacheLimit(testImageWidth * testImageHeight * 3);
+      const before = cv.imageCacheStats();
 
-  describe('cv.writeImageSync', () => {
-    const filePath = path.join(os.tmpdir(), 'tmp.png');
+      return cv.readImage(testImagePath, {cache: true}).then(() => {
+        return cv.readImage(testImagePath, {type: cv.ImageType.Gray, cache: true});
+      }).then(() => {
+        const stats = cv.imageCacheStats();
 
-    beforeEach(() => {
-      if (fs.existsSync(filePath)) {
-        fs.unlinkSync(filePath);
-      }
+        expect(stats.evictions - before.evictions).to.equal(1);
+        expect(stats.entries).to.equal(1);
+        expect(stats.bytes).to.equal(testImageWidth * testImageHeight);
+      });
     });
 
-    it('should write an image', () => {
-      const filePath = path.join(os.tmpdir(), 'tmp.png');
-      const mat = new cv.Matrix([
-        [10, 20, 30],
-        [40, 50, 60]
-      ]);
-
-      cv.writeImageSync(mat, filePath);
-      const image = cv.readImageSync(filePath, cv.ImageType.Gray);
-      expect(image.toArray()).to.eql([10, 20, 30, 40, 50, 60]);
-    });
+    it('should not allow modifying cached images', () => {
+      cv.setImageCacheLimit(100 * 1024 * 1024);
+      const image = cv.readImageSync(testImagePath, {cache: true});
 
-    it('should write an image with an alpha channel', () => {
-      cv.writeImageSync(cv.readImageSync(alphaImagePath), filePath);
-      const image = cv.readImageSync(filePath);
+      expect(() => image.addSync(1)).to.throwException(err => {
+        expect(err.message).to.equal('the matrix is read-only');
+      });
 
-      expect(image.width).to.equal(alphaImageWidth);
-      expect(image.height).to.equal(alphaImageHeight);
-      expect(image.type).to.equal(cv.ImageType.BGRA);
+      expect(image.clone().readOnly).to.equal(false);
     });
 
   });
 
-  describe('cv.encodeImage', () => {
+  describe('cv.probeImage', () => {
 
-    it('should encode an image', () => {
-      const filePath = path.join(os.tmpdir(), 'tmp.jpg');
+    it('should read the size and type of a JPEG file', () => {
+      return cv.probeImage(testImagePath).then(info => {
+        expect(info).to.eql({
+          width: testImageWidth,
+          height: testImageHeight,
+          type: cv.ImageType.BGR,
+          format: 'jpeg',
+          orientation: 1
+        });
+      });
+    });
 
-      if (fs.existsSync(filePath)) {
-        fs.unlinkSync(filePath);
-      }
-
-      return cv.readImage(testImagePath).then(image => {
-        return Promise.all([
-          cv.encodeImage(image, cv.EncodeType.JPEG),
-          cv.writeImage(image, filePath)
-        ]).then(([buffer]) => {
-          expect(buffer.equals(fs.readFileSync(filePath))).to.equal(true);
+    it('should read the size and type of a PNG buffer', () => {
+      return cv.probeImage(fs.readFileSync(alphaImagePath)).then(info => {
+        expect(info).to.eql({
+          width: alphaImageWidth,
+          height: alphaImageHeight,
+          type: cv.ImageType.BGRA,
+          format: 'png',
+          orientation: 1
         });
       });
-
     });
 
-    it('should fail if the first argument is not a matrix', (done) => {
-      cv.encodeImage({}, cv.EncodeType.JPEG)
-        .then(() => done(new Error('should not get here')))
-        .catch(err => {
-          expect(err.message).to.equal('first argument (image) must be a Matrix');
-          done();
-        })
-        .catch(done)
-    });
+    it('should read the EXIF orientation', () => {
+      const jpeg = withExifOrientation(fs.readFileSync(testImagePath), 6);
 
-    it('should fail if the second argument is not a cv.EncodeType (1)', (done) => {
-      cv.encodeImage(cv.matrix([[1, 2, 3, 4], [5, 6, 7, 8]]), 'png')
-        .then(() => done(new Error('should not get here')))
-        .catch(err => {
-          expect(err.message).to.equal('second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG]');
-          done();
-        })
-        .catch(done)
+      return cv.probeImage(jpeg).then(info => {
+        expect(info.width).to.equal(testImageWidth);
+        expect(info.orientation).to.equal(6);
+      });
     });
 
-    it('should fail if the second argument is not a cv.EncodeType (2)', (done) => {
-      cv.encodeImage(cv.matrix([[1, 2, 3, 4], [5, 6, 7, 8]]), 666)
-        .then(() => done(new Error('should not get here')))
-        .catch(err => {
-          expect(err.message).to.equal('second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG]');
-          done();
-        })
-        .catch(done)
-    });
+    it('should not trust the length of a WebP EXIF chunk', () => {
+      const tiff = Buffer.from([
+        0x4D, 0x4D, 0x00, 0x2A, 0x00, 0x00, 0x00, 0x08,
+        0x00, 0x01,
+        0x01, 0x12, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x06, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00
+      ]);
 
-  });
+      const vp8x = Buffer.alloc(18);
+      vp8x.write('VP8X', 0, 'ascii');
+      vp8x.writeUInt32LE(10, 4);
+      vp8x.writeUIntLE(99, 12, 3);
+      vp8x.writeUIntLE(49, 15, 3);
 
-  describe('cv.encodeImageSync', () => {
+      // The EXIF chunk claims almost 4 GB but the file ends after the TIFF header.
+      const exif = Buffer.alloc(8);
+      exif.write('EXIF', 0, 'ascii');
+      exif.writeUInt32LE(0xFFFFFFF0, 4);
 
-    it('should encode an image', () => {
-      const filePath = path.join(os.tmpdir(), 'tmp.jpg');
+      const webp = Buffer.concat([Buffer.from('RIFF\0\0\0\0WEBP', 'binary'), vp8x, exif, tiff]);
 
-      if (fs.existsSync(filePath)) {
-        fs.unlinkSync(filePath);
-      }
+      return cv.probeImage(webp).then(info => {
+        expect(info.format).to.equal('webp');
+        expect(info.width).to.equal(100);
+        expect(info.height).to.equal(50);
+        expect(info.orientation).to.equal(6);
+      });
+    });
 
-      return cv.readImage(testImagePath).then(image => {
-        const buffer = cv.encodeImageSync(image, cv.EncodeType.JPEG);
+    it('should probe a batch of images', () => {
+      return cv.probeImage([testImagePath, fs.readFileSync(alphaImagePath), invalidImagePath]).then(infos => {
+        expect(infos).to.have.length(3);
+        expect(infos[0].format).to.equal('jpeg');
+        expect(infos[1].format).to.equal('png');
+        expect(infos[2]).to.equal(null);
+      });
+    });
 
-        return cv.writeImage(image, filePath).then(() => {
-          expect(buffer.equals(fs.readFileSync(filePath))).to.equal(true);
-        });
+    it('should fail if the image format is not supported', (done) => {
+      cv.probeImage(invalidImagePath).catch(err => {
+        expect(err.message).to.equal('unsupported image format');
+        done();
       });
+    });
+
+  });
 
+  describe('cv.probeImageSync', () => {
+
+    it('should read the size and type of a JPEG file', () => {
+      const info = cv.probeImageSync(testImagePath);
+
+      expect(info.width).to.equal(testImageWidth);
+      expect(info.height).to.equal(testImageHeight);
+      expect(info.type).to.equal(cv.ImageType.BGR);
+      expect(info.format).to.equal('jpeg');
     });
 
-    it('should fail if the first argument is not a matrix', () => {
+    it('should fail if the first argument is not a path or a buffer', () => {
       expect(() => {
-        cv.encodeImageSync({}, cv.EncodeType.JPEG);
+        cv.probeImageSync(123);
       }).to.throwException(err => {
-        expect(err.message).to.equal('first argument (image) must be a Matrix');
+        expect(err.message).to.equal('first argument (image) must be a file path, a Buffer or an array of them');
       });
     });
 
-    it('should fail if the second argument is not a cv.EncodeType (1)', () => {
-      expect(() => {
-        cv.encodeImageSync(cv.matrix([[1, 2, 3, 4], [5, 6, 7, 8]]), 'png')
-      }).to.throwException(err => {
-        expect(err.message).to.equal('second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG]');
+  });
+
+  describe('cv.openVideo', () => {
+
+    it('should fail if the file is not a video', (done) => {
+      cv.openVideo(invalidImagePath).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal(`could not open video file "${invalidImagePath}"`);
+        done();
+      }).catch(done);
+    });
+
+    it('should return the frames in order with concurrent reads', () => {
+      const videoPath = path.join(os.tmpdir(), 'simple-cv-test-read.avi');
+      const size = {width: 64, height: 48};
+      const writer = cv.createVideoWriterSync(videoPath, {fourcc: 'MJPG', fps: 10, size});
+
+      _.range(6).forEach(i => {
+        const data = _.range(size.width * size.height * 3).map(() => i * 20);
+        writer.writeSync(cv.matrix({width: size.width, height: size.height, type: cv.ImageType.BGR, data}));
+      });
+
+      writer.closeSync();
+
+      return cv.openVideo(videoPath, {queueSize: 2, poolSize: 2}).then(video => {
+        return Promise.all(_.range(7).map(() => video.read())).then(frames => {
+          video.close();
+          fs.unlinkSync(videoPath);
+
+          expect(frames[6]).to.equal(null);
+
+          frames.slice(0, 6).forEach((frame, i) => {
+            expect(frame.width).to.equal(size.width);
+            expect(frame.toArray()[0]).to.be.within(i * 20 - 3, i * 20 + 3);
+
+            frame.release();
+            expect(frame.width).to.equal(0);
+          });
+        });
       });
     });
 
-    it('should fail if the second argument is not a cv.EncodeType (2)', () => {
+    it('should validate the options', () => {
       expect(() => {
-        cv.encodeImageSync(cv.matrix([[1, 2, 3, 4], [5, 6, 7, 8]]), 666)
+        cv.openVideoSync(invalidImagePath, {step: 0});
       }).to.throwException(err => {
-        expect(err.message).to.equal('second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG]');
+        expect(err.message).to.equal('start must be non-negative and step and queueSize must be positive');
       });
     });
 
   });
 
-  describe('cv.resize', () => {
+  describe('cv.createVideoWriter', () => {
+    const videoPath = path.join(os.tmpdir(), 'simple-cv-test-video.avi');
+    const size = {width: 64, height: 48};
 
-    it('should resize image to width preserving aspect ratio', () => {
-      return cv.readImage(testImagePath).then(matrix => {
-        return Promise.all([
-          cv.resize(matrix, testImageWidth / 2),
-          cv.resize(matrix, testImageWidth / 2),
-          cv.resize(matrix, testImageWidth / 2),
-          cv.resize(matrix, testImageWidth / 2),
-          cv.resize(matrix, testImageWidth / 2),
-          cv.resize(matrix, testImageWidth / 2),
-          cv.resize(matrix, testImageWidth / 2),
-          cv.resize(matrix, testImageWidth / 2)
-        ])
-      }).then(([matrix]) => {
-        expect(matrix.width).to.equal(testImageWidth / 2);
-        expect(matrix.height).to.equal(testImageHeight / 2);
-        expect(matrix.type).to.equal(cv.ImageType.BGR);
+    afterEach(() => {
+      if (fs.existsSync(videoPath)) {
+        fs.unlinkSync(videoPath);
+      }
+    });
 
-        if (process.env.SHOW_IMAGES) {
-          cv.showImage("resized image", matrix);
-          cv.waitKey();
+    function frame(i) {
+      const data = _.range(size.width * size.height * 3).map(() => i * 20);
+      return cv.matrix({width: size.width, height: size.height, type: cv.ImageType.BGR, data});
+    }
+
+    it('should write frames that can be read back with openVideo', () => {
+      return cv.createVideoWriter(videoPath, {fourcc: 'MJPG', fps: 10, size, queueSize: 2}).then(writer => {
+        return _.range(10).reduce((promise, i) => promise.then(() => writer.write(frame(i))), Promise.resolve())
+          .then(() => writer.close());
+      }).then(() => {
+        return cv.openVideo(videoPath);
+      }).then(video => {
+        expect(video.width).to.equal(size.width);
+        expect(video.height).to.equal(size.height);
+
+        const frames = [];
+
+        function next() {
+          return video.read().then(frame => {
+            if (frame) {
+              frames.push(frame);
+              return next();
+            }
+          });
         }
+
+        return next().then(() => {
+          expect(frames.length).to.equal(10);
+
+          frames.forEach((frame, i) => {
+            expect(frame.type).to.equal(cv.ImageType.BGR);
+            expect(frame.toArray()[0]).to.be.within(i * 20 - 3, i * 20 + 3);
+          });
+        });
       });
     });
 
-    it('should resize gray image to width preserving aspect ratio', () => {
-      return cv.readImage(testImagePath, cv.ImageType.Gray).then(matrix => {
-        return cv.resize(matrix, testImageWidth / 2);
-      }).then(matrix => {
-        expect(matrix.width).to.equal(testImageWidth / 2);
-        expect(matrix.height).to.equal(testImageHeight / 2);
-        expect(matrix.type).to.equal(cv.ImageType.Gray);
+    it('should keep the order of writes that are not awaited', () => {
+      const writer = cv.createVideoWriterSync(videoPath, {fourcc: 'MJPG', fps: 10, size, queueSize: 2});
 
-        if (process.env.SHOW_IMAGES) {
-          cv.showImage("gray resized image", matrix);
-          cv.waitKey();
+      return Promise.all(_.range(10).map(i => writer.write(frame(i)))).then(() => {
+        return writer.close();
+      }).then(() => {
+        const video = cv.openVideoSync(videoPath);
+        const values = [];
+        let frame;
+
+        while ((frame = video.readSync())) {
+          values.push(Math.round(frame.toArray()[0] / 20));
         }
+
+        video.close();
+        expect(values).to.eql(_.range(10));
       });
     });
 
-    it('should resize image to width preserving aspect ratio', () => {
-      return cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {width: testImageWidth / 4});
-      }).then(matrix => {
-        expect(matrix.width).to.equal(testImageWidth / 4);
-        expect(matrix.height).to.equal(testImageHeight / 4);
-        expect(matrix.type).to.equal(cv.ImageType.BGR);
-      });
+    it('should only return every step\'th frame with openVideo', () => {
+      const writer = cv.createVideoWriterSync(videoPath, {fourcc: 'MJPG', fps: 10, size});
+      _.range(10).forEach(i => writer.writeSync(frame(i)));
+      writer.closeSync();
+
+      const video = cv.openVideoSync(videoPath, {start: 1, step: 3});
+      const values = [];
+      let frame;
+
+      while ((frame = video.readSync())) {
+        values.push(Math.round(frame.toArray()[0] / 20));
+      }
+
+      video.close();
+      expect(values).to.eql([1, 4, 7]);
     });
 
-    it('should resize image to height preserving aspect ratio', () => {
-      return cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {height: testImageHeight / 4});
-      }).then(matrix => {
-        expect(matrix.width).to.equal(testImageWidth / 4);
-        expect(matrix.height).to.equal(testImageHeight / 4);
-        expect(matrix.type).to.equal(cv.ImageType.BGR);
+    it('should fail if the frame has a wrong size', () => {
+      const writer = cv.createVideoWriterSync(videoPath, {fourcc: 'MJPG', fps: 10, size});
+
+      expect(() => {
+        writer.writeSync(new cv.Matrix(10, 10, cv.ImageType.BGR));
+      }).to.throwException(err => {
+        expect(err.message).to.equal('first argument (frame) must be a BGR image of size 64x48');
       });
+
+      writer.closeSync();
     });
 
-    it('should resize image to scale preserving aspect ratio', () => {
-      return cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {scale: 0.5});
-      }).then(matrix => {
-        expect(matrix.width).to.equal(testImageWidth / 2);
-        expect(matrix.height).to.equal(testImageHeight / 2);
-        expect(matrix.type).to.equal(cv.ImageType.BGR);
+    it('should fail after the writer has been closed', (done) => {
+      const writer = cv.createVideoWriterSync(videoPath, {fourcc: 'MJPG', fps: 10, size});
+      writer.closeSync();
+
+      writer.write(frame(0)).catch(err => {
+        expect(err.message).to.equal('the video writer has been closed');
+        done();
       });
     });
 
-    it('should resize image to scale', () => {
-      return cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {xScale: 0.5, yScale: 0.25});
-      }).then(matrix => {
-        expect(matrix.width).to.equal(testImageWidth / 2);
-        expect(matrix.height).to.equal(testImageHeight / 4);
-        expect(matrix.type).to.equal(cv.ImageType.BGR);
-      });
+  });
+
+  describe('cv.writeImage', () => {
+    const filePath = path.join(os.tmpdir(), 'tmp.png');
+
+    beforeEach(() => {
+      if (fs.existsSync(filePath)) {
+        fs.unlinkSync(filePath);
+      }
     });
 
-    it('should resize image to size', () => {
-      return cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {width: 128, height: 200});
-      }).then(matrix => {
-        expect(matrix.width).to.equal(128);
-        expect(matrix.height).to.equal(200);
-        expect(matrix.type).to.equal(cv.ImageType.BGR);
+    it('should write an image', () => {
+      const filePath = path.join(os.tmpdir(), 'tmp.png');
+      const mat = new cv.Matrix([
+        [10, 20, 30],
+        [40, 50, 60]
+      ]);
+
+      return cv.writeImage(mat, filePath).then(() => {
+        expect(fs.existsSync(filePath)).to.equal(true);
+        return cv.readImage(filePath, cv.ImageType.Gray);
+      }).then(image => {
+        expect(image.toArray()).to.eql([10, 20, 30, 40, 50, 60]);
       });
     });
 
-    it('should fail if no second argument is given', (done) => {
-      cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix);
+    it('should write an image with an alpha channel', () => {
+      return cv.readImage(alphaImagePath).then(image => {
+        return cv.writeImage(image, filePath);
       }).then(() => {
-        done(new Error('should not get here'));
-      }).catch(err => {
-        expect(err.message).to.equal('second argument (sizeSpec) must be a valid sizeSpec object');
-        done();
-      }).catch(done);
+        return cv.readImage(filePath);
+      }).then(image => {
+        expect(image.width).to.equal(alphaImageWidth);
+        expect(image.height).to.equal(alphaImageHeight);
+        expect(image.type).to.equal(cv.ImageType.BGRA);
+      });
     });
 
-    it('should fail if an empty object is given', (done) => {
-      cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {});
-      }).then(() => {
-        done(new Error('should not get here'));
-      }).catch(err => {
-        expect(err.message).to.equal('second argument (sizeSpec) must be a valid sizeSpec object');
-        done();
-      }).catch(done);
-    });
+  });
 
-    it('should fail if a string is given', (done) => {
-      cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, 'balls');
-      }).then(() => {
-        done(new Error('should not get here'));
-      }).catch(err => {
-        expect(err.message).to.equal('second argument (sizeSpec) must be an integer or an object');
-        done();
-      }).catch(done);
-    });
+  describe('cv.writeImageSync', () => {
+    const filePath = path.join(os.tmpdir(), 'tmp.png');
 
-    it('should fail if only xScale is given', (done) => {
-      cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {xScale: 2});
-      }).then(() => {
-        done(new Error('should not get here'));
-      }).catch(err => {
-        expect(err.message).to.equal('second argument (sizeSpec) must be a valid sizeSpec object');
-        done();
-      }).catch(done);
+    beforeEach(() => {
+      if (fs.existsSync(filePath)) {
+        fs.unlinkSync(filePath);
+      }
     });
 
-    it('should fail if only yScale is given', (done) => {
-      cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {yScale: 2});
-      }).then(() => {
-        done(new Error('should not get here'));
-      }).catch(err => {
-        expect(err.message).to.equal('second argument (sizeSpec) must be a valid sizeSpec object');
-        done();
-      }).catch(done);
+    it('should write an image', () => {
+      const filePath = path.join(os.tmpdir(), 'tmp.png');
+      const mat = new cv.Matrix([
+        [10, 20, 30],
+        [40, 50, 60]
+      ]);
+
+      cv.writeImageSync(mat, filePath);
+      const image = cv.readImageSync(filePath, cv.ImageType.Gray);
+      expect(image.toArray()).to.eql([10, 20, 30, 40, 50, 60]);
     });
 
-    it('should fail with invalid width', (done) => {
-      cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, 0);
-      }).then(() => {
-        done(new Error('should not get here'));
-      }).catch(err => {
-        expect(err.message).to.equal('if the second argument (sizeSpec) is a number it must be a positive integer');
-        done();
-      }).catch(done);
+    it('should write an image with an alpha channel', () => {
+      cv.writeImageSync(cv.readImageSync(alphaImagePath), filePath);
+      const image = cv.readImageSync(filePath);
+
+      expect(image.width).to.equal(alphaImageWidth);
+      expect(image.height).to.equal(alphaImageHeight);
+      expect(image.type).to.equal(cv.ImageType.BGRA);
     });
 
-    it('should fail with invalid width (object version)', (done) => {
-      cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {width: -1});
-      }).then(() => {
-        done(new Error('should not get here'));
-      }).catch(err => {
-        expect(err.message).to.equal('width must be a positive integer');
-        done();
-      }).catch(done);
+  });
+
+  describe('cv.saveMatrix', () => {
+    const filePath = path.join(os.tmpdir(), 'tmp.scvm');
+
+    beforeEach(() => {
+      if (fs.existsSync(filePath)) {
+        fs.unlinkSync(filePath);
+      }
     });
 
-    it('should fail with invalid scale', (done) => {
-      cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {scale: -10});
-      }).then(() => {
-        done(new Error('should not get here'));
-      }).catch(err => {
-        expect(err.message).to.equal('scale must be positive floating point number');
-        done();
-      }).catch(done);
+    it('should save a matrix that can be mapped back', () => {
+      const mat = new cv.Matrix([
+        [0.5, 1.5, 2.5],
+        [3.5, 4.5, 5.5]
+      ]);
+
+      return cv.saveMatrix(mat, filePath).then(() => {
+        expect(fs.statSync(filePath).size).to.equal(64 + 6 * 8);
+        return cv.mapMatrix(filePath);
+      }).then(mapped => {
+        expect(mapped.width).to.equal(3);
+        expect(mapped.height).to.equal(2);
+        expect(mapped.type).to.equal(cv.ImageType.Float);
+        expect(mapped.toArray()).to.eql([0.5, 1.5, 2.5, 3.5, 4.5, 5.5]);
+      });
     });
 
-    it('should fail with invalid xScale', (done) => {
-      cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {xScale: 0, yScale: 1});
-      }).then(() => {
-        done(new Error('should not get here'));
-      }).catch(err => {
-        expect(err.message).to.equal('xScale and yScale must be positive floating point numbers');
-        done();
-      }).catch(done);
+    it('should save a BGR image', () => {
+      return cv.readImage(testImagePath).then(image => {
+        return cv.saveMatrix(image, filePath).then(() => cv.mapMatrix(filePath)).then(mapped => {
+          expect(mapped.type).to.equal(cv.ImageType.BGR);
+          expect(mapped.toBuffer().equals(image.toBuffer())).to.equal(true);
+        });
+      });
     });
 
-    it('should fail with invalid yScale', (done) => {
-      cv.readImage(testImagePath).then(matrix => {
-        return cv.resize(matrix, {xScale: 1, yScale: -1});
-      }).then(() => {
-        done(new Error('should not get here'));
-      }).catch(err => {
-        expect(err.message).to.equal('xScale and yScale must be positive floating point numbers');
+  });
+
+  describe('cv.saveMatrixSync', () => {
+    const filePath = path.join(os.tmpdir(), 'tmp-sync.scvm');
+
+    it('should save a matrix that can be mapped back', () => {
+      const mat = new cv.Matrix({width: 2, height: 2, type: cv.ImageType.Gray, data: [1, 2, 3, 4]});
+
+      cv.saveMatrixSync(mat, filePath);
+      const mapped = cv.mapMatrixSync(filePath);
+
+      expect(mapped.type).to.equal(cv.ImageType.Gray);
+      expect(mapped.toArray()).to.eql([1, 2, 3, 4]);
+    });
+
+    it('should not write in-place modifications back to the file', () => {
+      const mat = new cv.Matrix({width: 2, height: 2, type: cv.ImageType.Gray, data: [1, 2, 3, 4]});
+
+      cv.saveMatrixSync(mat, filePath);
+      cv.mapMatrixSync(filePath).addSync(10);
+
+      expect(cv.mapMatrixSync(filePath).toArray()).to.eql([1, 2, 3, 4]);
+    });
+
+  });
+
+  describe('cv.mapMatrix', () => {
+
+    it('should fail if the file is not a matrix file', (done) => {
+      cv.mapMatrix(testImagePath).catch(err => {
+        expect(err.message).to.equal(`invalid matrix file "${testImagePath}"`);
         done();
-      }).catch(done);
+      });
     });
 
   });
 
-  describe('cv.resizeSync', () => {
+  describe('cv.mapMatrixSync', () => {
 
-    it('should resize image to width preserving aspect ratio', () => {
-      const image = cv.readImageSync(testImagePath);
-      const resized = cv.resizeSync(image, testImageWidth / 2);
+    it('should fail if the file is not a matrix file', () => {
+      expect(() => {
+        cv.mapMatrixSync(testImagePath);
+      }).to.throwException(err => {
+        expect(err.message).to.equal(`invalid matrix file "${testImagePath}"`);
+      });
+    });
 
-      expect(resized.width).to.equal(testImageWidth / 2);
-      expect(resized.height).to.equal(testImageHeight / 2);
-      expect(resized.type).to.equal(cv.ImageType.BGR);
+    it('should fail if the payload size overflows', () => {
+      const filePath = path.join(os.tmpdir(), 'tmp-overflow.scvm');
+      const header = Buffer.alloc(64 + 8);
+
+      header.write('SCVM', 0, 'ascii');
+      header.writeUInt32LE(1, 4);
+      header.writeInt32LE(1, 8);
+      header.writeInt32LE(2, 12);
+      header.writeInt32LE(cv.ImageType.Gray, 16);
+      header.writeUInt32LE(0x01020304, 20);
+      // A stride of 2^63 makes dataOffset + stride * height wrap around to 64.
+      header.writeUInt32LE(0, 24);
+      header.writeUInt32LE(0x80000000, 28);
+      header.writeUInt32LE(64, 32);
+      fs.writeFileSync(filePath, header);
+
+      expect(() => {
+        cv.mapMatrixSync(filePath);
+      }).to.throwException(err => {
+        expect(err.message).to.equal(`invalid matrix file "${filePath}"`);
+      });
     });
 
-    it('should resize gray image to width preserving aspect ratio', () => {
-      const image = cv.readImageSync(testImagePath, cv.ImageType.Gray);
-      const resized = cv.resizeSync(image, testImageWidth / 2);
+    it('should fail with a stride that is not a multiple of the channel size', () => {
+      const filePath = path.join(os.tmpdir(), 'tmp-stride.scvm');
+      const header = Buffer.alloc(64 + 16);
 
-      expect(resized.width).to.equal(testImageWidth / 2);
-      expect(resized.height).to.equal(testImageHeight / 2);
-      expect(resized.type).to.equal(cv.ImageType.Gray);
+      header.write('SCVM', 0, 'ascii');
+      header.writeUInt32LE(1, 4);
+      header.writeInt32LE(1, 8);
+      header.writeInt32LE(1, 12);
+      header.writeInt32LE(cv.ImageType.Float, 16);
+      header.writeUInt32LE(0x01020304, 20);
+      header.writeUInt32LE(12, 24);
+      header.writeUInt32LE(64, 32);
+      fs.writeFileSync(filePath, header);
+
+      expect(() => {
+        cv.mapMatrixSync(filePath);
+      }).to.throwException(err => {
+        expect(err.message).to.equal(`invalid matrix file "${filePath}"`);
+      });
     });
 
-    it('should resize image to width preserving aspect ratio', () => {
-      const image = cv.readImageSync(testImagePath);
-      const resized = cv.resizeSync(image, {width: testImageWidth / 4});
+    it('should fail with a type that is not an image type', () => {
+      const filePath = path.join(os.tmpdir(), 'tmp-type.scvm');
+      const mat = new cv.Matrix({width: 2, height: 2, type: cv.ImageType.Gray, data: [1, 2, 3, 4]});
 
-      expect(resized.width).to.equal(testImageWidth / 4);
-      expect(resized.height).to.equal(testImageHeight / 4);
-      expect(resized.type).to.equal(cv.ImageType.BGR);
+      cv.saveMatrixSync(mat, filePath);
+
+      // CV_32SC1
+      const data = fs.readFileSync(filePath);
+      data.writeInt32LE(4, 16);
+      fs.writeFileSync(filePath, data);
+
+      expect(() => {
+        cv.mapMatrixSync(filePath);
+      }).to.throwException(err => {
+        expect(err.message).to.equal(`invalid matrix file "${filePath}"`);
+      });
     });
 
-    it('should resize image to height preserving aspect ratio', () => {
-      const image = cv.readImageSync(testImagePath);
-      const resized = cv.resizeSync(image, {height: testImageHeight / 4});
+    it('should fail if the file was written with the other byte order', () => {
+      const filePath = path.join(os.tmpdir(), 'tmp-byte-order.scvm');
+      const mat = new cv.Matrix({width: 2, height: 2, type: cv.ImageType.Gray, data: [1, 2, 3, 4]});
 
-      expect(resized.width).to.equal(testImageWidth / 4);
-      expect(resized.height).to.equal(testImageHeight / 4);
-      expect(resized.type).to.equal(cv.ImageType.BGR);
+      cv.saveMatrixSync(mat, filePath);
+
+      const data = fs.readFileSync(filePath);
+      data.writeUInt32BE(data.readUInt32LE(20), 20);
+      fs.writeFileSync(filePath, data);
+
+      expect(() => {
+        cv.mapMatrixSync(filePath);
+      }).to.throwException(err => {
+        expect(err.message).to.equal(`invalid matrix file "${filePath}"`);
+      });
     });
 
   });
 
-  describe('cv.warpAffine', () => {
+  describe('cv.encodeImage', () => {
 
-    it('should transform an image', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+    it('should encode an image', () => {
+      const filePath = path.join(os.tmpdir(), 'tmp.jpg');
 
-      const transpose = cv.matrix([
-        [0, 1, 0],
-        [1, 0, 0]
-      ]);
+      if (fs.existsSync(filePath)) {
+        fs.unlinkSync(filePath);
+      }
 
-      // Test a simple transpose transformation.
-      return cv.warpAffine(matrix, transpose).then(image => {
-        expect(image.toArray()).to.eql([
-          1, 3, 0,
-          2, 4, 0,
-          0, 0, 0
+      return cv.readImage(testImagePath).then(image => {
+        return Promise.all([
+          cv.encodeImage(image, cv.EncodeType.JPEG),
+          cv.writeImage(image, filePath)
+        ]).then(([buffer]) => {
+          expect(buffer.equals(fs.readFileSync(filePath))).to.equal(true);
+        });
+      });
+
+    });
+
+    it('should encode with a given quality', () => {
+      return cv.readImage(testImagePath).then(image => {
+        return Promise.all([
+          cv.encodeImage(image, {type: cv.EncodeType.JPEG, quality: 20}),
+          cv.encodeImage(image, {type: cv.EncodeType.JPEG, quality: 90})
         ]);
+      }).then(([low, high]) => {
+        expect(low.length).to.be.lessThan(high.length);
       });
     });
 
-    it('should accept options object', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+    it('should search the highest quality that fits into maxBytes', () => {
+      let image;
+
+      return cv.readImage(testImagePath).then(it => {
+        image = it;
+        return cv.encodeImage(image, {type: cv.EncodeType.JPEG, maxBytes: 50000});
+      }).then(result => {
+        expect(result.data.length).to.be.lessThan(50001);
+        expect(result.quality).to.be.within(10, 99);
+        expect(result.width).to.equal(1280);
+        expect(result.height).to.equal(1024);
+
+        expect(result.data.equals(cv.encodeImageSync(image, {type: cv.EncodeType.JPEG, quality: result.quality}))).to.equal(true);
+        expect(cv.encodeImageSync(image, {type: cv.EncodeType.JPEG, quality: result.quality + 1}).length).to.be.greaterThan(50000);
+      });
+    });
+
+    it('should downscale the image if minQuality doesn\'t fit', () => {
+      return cv.readImage(testImagePath).then(image => {
+        return cv.encodeImage(image, {type: cv.EncodeType.JPEG, maxBytes: 5000, minQuality: 50, downscale: true});
+      }).then(result => {
+        expect(result.data.length).to.be.lessThan(5001);
+        expect(result.quality).to.be.within(50, 100);
+        expect(result.width).to.be.lessThan(1280);
+        expect(Math.abs(result.width / result.height - 1.25)).to.be.lessThan(0.05);
+
+        return cv.decodeImage(result.data);
+      }).then(decoded => {
+        expect(decoded.width).to.be.lessThan(1280);
+      });
+    });
+
+    it('should fail if the image doesn\'t fit into maxBytes', (done) => {
+      cv.readImage(testImagePath).then(image => {
+        return cv.encodeImage(image, {type: cv.EncodeType.JPEG, maxBytes: 5000, minQuality: 50});
+      }).then(() => done(new Error('should not get here'))).catch(err => {
+        expect(err.message).to.equal('could not encode the image into 5000 bytes');
+        done();
+      }).catch(done);
+    });
+
+    it('should fail if the first argument is not a matrix', (done) => {
+      cv.encodeImage({}, cv.EncodeType.JPEG)
+        .then(() => done(new Error('should not get here')))
+        .catch(err => {
+          expect(err.message).to.equal('first argument (image) must be a Matrix');
+          done();
+        })
+        .catch(done)
+    });
+
+    it('should fail if the second argument is not a cv.EncodeType (1)', (done) => {
+      cv.encodeImage(cv.matrix([[1, 2, 3, 4], [5, 6, 7, 8]]), 'png')
+        .then(() => done(new Error('should not get here')))
+        .catch(err => {
+          expect(err.message).to.equal('second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG, cv.EncodeType.WebP]');
+          done();
+        })
+        .catch(done)
+    });
+
+    it('should fail if the second argument is not a cv.EncodeType (2)', (done) => {
+      cv.encodeImage(cv.matrix([[1, 2, 3, 4], [5, 6, 7, 8]]), 666)
+        .then(() => done(new Error('should not get here')))
+        .catch(err => {
+          expect(err.message).to.equal('second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG, cv.EncodeType.WebP]');
+          done();
+        })
+        .catch(done)
+    });
+
+  });
+
+  describe('cv.encodeImageSync', () => {
+
+    it('should encode an image', () => {
+      const filePath = path.join(os.tmpdir(), 'tmp.jpg');
+
+      if (fs.existsSync(filePath)) {
+        fs.unlinkSync(filePath);
+      }
+
+      return cv.readImage(testImagePath).then(image => {
+        const buffer = cv.encodeImageSync(image, cv.EncodeType.JPEG);
+
+        return cv.writeImage(image, filePath).then(() => {
+          expect(buffer.equals(fs.readFileSync(filePath))).to.equal(true);
+        });
+      });
+
+    });
+
+    it('should fail with quality for PNG', () => {
+      expect(() => {
+        cv.encodeImageSync(cv.matrix([[1, 2], [3, 4]]), {type: cv.EncodeType.PNG, maxBytes: 1000});
+      }).to.throwException(err => {
+        expect(err.message).to.equal('quality and maxBytes are only supported for cv.EncodeType.JPEG and cv.EncodeType.WebP');
+      });
+    });
+
+    it('should fail if the first argument is not a matrix', () => {
+      expect(() => {
+        cv.encodeImageSync({}, cv.EncodeType.JPEG);
+      }).to.throwException(err => {
+        expect(err.message).to.equal('first argument (image) must be a Matrix');
+      });
+    });
+
+    it('should fail if the second argument is not a cv.EncodeType (1)', () => {
+      expect(() => {
+        cv.encodeImageSync(cv.matrix([[1, 2, 3, 4], [5, 6, 7, 8]]), 'png')
+      }).to.throwException(err => {
+        expect(err.message).to.equal('second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG, cv.EncodeType.WebP]');
+      });
+    });
+
+    it('should fail if the second argument is not a cv.EncodeType (2)', () => {
+      expect(() => {
+        cv.encodeImageSync(cv.matrix([[1, 2, 3, 4], [5, 6, 7, 8]]), 666)
+      }).to.throwException(err => {
+        expect(err.message).to.equal('second argument (type) must be one of [cv.EncodeType.JPEG, cv.EncodeType.PNG, cv.EncodeType.WebP]');
+      });
+    });
+
+  });
+
+  describe('cv.fromYUV', () => {
+
+    it('should convert all formats back from toYUV', () => {
+      const image = cv.readImageSync(testImagePath);
+      const formats = ['NV12', 'NV21', 'I420', 'YUYV', 'UYVY'];
+
+      return Promise.all(formats.map(format => {
+        return cv.toYUV(image, cv.YUVFormat[format]).then(data => {
+          return cv.fromYUV(data, {format: cv.YUVFormat[format], width: testImageWidth, height: testImageHeight});
+        });
+      })).then(results => {
+        results.forEach(result => {
+          expect(result.type).to.equal(cv.ImageType.BGR);
+          expect(cv.compareSync(result, image, {metrics: ['psnr']}).psnr).to.be.greaterThan(30);
+        });
+      });
+    });
+
+    it('should resize while converting', () => {
+      const image = cv.readImageSync(testImagePath);
+      const size = {width: testImageWidth / 4, height: testImageHeight / 4};
+      const data = cv.toYUVSync(image, cv.YUVFormat.I420);
+
+      return cv.fromYUV(data, {format: cv.YUVFormat.I420, width: testImageWidth, height: testImageHeight, size}).then(result => {
+        expect(result.width).to.equal(size.width);
+        expect(result.height).to.equal(size.height);
+        expect(cv.compareSync(result, cv.resizeSync(image, size), {metrics: ['psnr']}).psnr).to.be.greaterThan(28);
+      });
+    });
+
+    it('should not be affected by changes to the buffer after the call', () => {
+      const data = Buffer.from([10, 20, 30, 40, 128, 128]);
+      const promise = cv.fromYUV(data, {format: cv.YUVFormat.NV12, width: 2, height: 2, type: cv.ImageType.Gray});
+
+      data.fill(0);
+
+      return promise.then(result => {
+        expect(result.toArray()).to.eql([10, 20, 30, 40]);
+      });
+    });
+
+  });
+
+  describe('cv.fromYUVSync', () => {
+
+    it('should return the Y plane as a gray image and respect the stride', () => {
+      const data = Buffer.from([
+        10, 20, 99, 99,
+        30, 40, 99, 99,
+        128, 128, 99, 99
+      ]);
+
+      const result = cv.fromYUVSync(data, {format: cv.YUVFormat.NV12, width: 2, height: 2, stride: 4, type: cv.ImageType.Gray});
+
+      expect(result.type).to.equal(cv.ImageType.Gray);
+      expect(result.toArray()).to.eql([10, 20, 30, 40]);
+    });
+
+    it('should fail with an odd I420 stride', () => {
+      expect(() => {
+        cv.fromYUVSync(Buffer.alloc(64), {format: cv.YUVFormat.I420, width: 2, height: 2, stride: 3});
+      }).to.throwException(err => {
+        expect(err.message).to.equal('stride must be even for cv.YUVFormat.I420');
+      });
+    });
+
+    it('should fail if the buffer is too small', () => {
+      expect(() => {
+        cv.fromYUVSync(Buffer.alloc(5), {format: cv.YUVFormat.NV12, width: 2, height: 2});
+      }).to.throwException(err => {
+        expect(err.message).to.equal('data must have at least 6 bytes');
+      });
+    });
+
+  });
+
+  describe('cv.toYUVSync', () => {
+
+    it('should convert a BGR image into a YUV frame', () => {
+      const image = cv.matrix({width: 2, height: 2, type: cv.ImageType.BGR, data: new Array(12).fill(128)});
+
+      expect(Array.from(cv.toYUVSync(image, cv.YUVFormat.NV12))).to.eql([126, 126, 126, 126, 128, 128]);
+      expect(Array.from(cv.toYUVSync(image, cv.YUVFormat.YUYV))).to.eql([126, 128, 126, 128, 126, 128, 126, 128]);
+    });
+
+    it('should fail with an odd width', () => {
+      const image = cv.matrix({width: 3, height: 2, type: cv.ImageType.BGR, data: new Array(18).fill(0)});
+
+      expect(() => {
+        cv.toYUVSync(image, cv.YUVFormat.I420);
+      }).to.throwException(err => {
+        expect(err.message).to.equal('the image width and height must be even');
+      });
+    });
+
+  });
+
+  describe('cv.resize', () => {
+
+    it('should resize image to width preserving aspect ratio', () => {
+      return cv.readImage(testImagePath).then(matrix => {
+        return Promise.all([
+          cv.resize(matrix, testImageWidth / 2),
+          cv.resize(matrix, testImageWidth / 2),
+          cv.resize(matrix, testImageWidth / 2),
+          cv.resize(matrix, testImageWidth / 2),
+          cv.resize(matrix, testImageWidth / 2),
+          cv.resize(matrix, testImageWidth / 2),
+          cv.resize(matrix, testImageWidth / 2),
+          cv.resize(matrix, testImageWidth / 2)
+        ])
+      }).then(([matrix]) => {
+        expect(matrix.width).to.equal(testImageWidth / 2);
+        expect(matrix.height).to.equal(testImageHeight / 2);
+        expect(matrix.type).to.equal(cv.ImageType.BGR);
+
+        if (process.env.SHOW_IMAGES) {
+          cv.showImage("resized image", matrix);
+          cv.waitKey();
+        }
+      });
+    });
+
+    it('should resize gray image to width preserving aspect ratio', () => {
+      return cv.readImage(testImagePath, cv.ImageType.Gray).then(matrix => {
+        return cv.resize(matrix, testImageWidth / 2);
+      }).then(matrix => {
+        expect(matrix.width).to.equal(testImageWidth / 2);
+        expect(matrix.height).to.equal(testImageHeight / 2);
+        expect(matrix.type).to.equal(cv.ImageType.Gray);
+
+        if (process.env.SHOW_IMAGES) {
+          cv.showImage("gray resized image", matrix);
+          cv.waitKey();
+        }
+      });
+    });
+
+    it('should resize image to width preserving aspect ratio', () => {
+      return cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {width: testImageWidth / 4});
+      }).then(matrix => {
+        expect(matrix.width).to.equal(testImageWidth / 4);
+        expect(matrix.height).to.equal(testImageHeight / 4);
+        expect(matrix.type).to.equal(cv.ImageType.BGR);
+      });
+    });
+
+    it('should resize image to height preserving aspect ratio', () => {
+      return cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {height: testImageHeight / 4});
+      }).then(matrix => {
+        expect(matrix.width).to.equal(testImageWidth / 4);
+        expect(matrix.height).to.equal(testImageHeight / 4);
+        expect(matrix.type).to.equal(cv.ImageType.BGR);
+      });
+    });
+
+    it('should resize image to scale preserving aspect ratio', () => {
+      return cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {scale: 0.5});
+      }).then(matrix => {
+        expect(matrix.width).to.equal(testImageWidth / 2);
+        expect(matrix.height).to.equal(testImageHeight / 2);
+        expect(matrix.type).to.equal(cv.ImageType.BGR);
+      });
+    });
+
+    it('should resize image to scale', () => {
+      return cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {xScale: 0.5, yScale: 0.25});
+      }).then(matrix => {
+        expect(matrix.width).to.equal(testImageWidth / 2);
+        expect(matrix.height).to.equal(testImageHeight / 4);
+        expect(matrix.type).to.equal(cv.ImageType.BGR);
+      });
+    });
+
+    it('should resize image to size', () => {
+      return cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {width: 128, height: 200});
+      }).then(matrix => {
+        expect(matrix.width).to.equal(128);
+        expect(matrix.height).to.equal(200);
+        expect(matrix.type).to.equal(cv.ImageType.BGR);
+      });
+    });
+
+    it('should fail if no second argument is given', (done) => {
+      cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix);
+      }).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal('second argument (sizeSpec) must be a valid sizeSpec object');
+        done();
+      }).catch(done);
+    });
+
+    it('should fail if an empty object is given', (done) => {
+      cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {});
+      }).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal('second argument (sizeSpec) must be a valid sizeSpec object');
+        done();
+      }).catch(done);
+    });
+
+    it('should fail if a string is given', (done) => {
+      cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, 'balls');
+      }).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal('second argument (sizeSpec) must be an integer or an object');
+        done();
+      }).catch(done);
+    });
+
+    it('should fail if only xScale is given', (done) => {
+      cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {xScale: 2});
+      }).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal('second argument (sizeSpec) must be a valid sizeSpec object');
+        done();
+      }).catch(done);
+    });
+
+    it('should fail if only yScale is given', (done) => {
+      cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {yScale: 2});
+      }).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal('second argument (sizeSpec) must be a valid sizeSpec object');
+        done();
+      }).catch(done);
+    });
+
+    it('should fail with invalid width', (done) => {
+      cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, 0);
+      }).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal('if the second argument (sizeSpec) is a number it must be a positive integer');
+        done();
+      }).catch(done);
+    });
+
+    it('should fail with invalid width (object version)', (done) => {
+      cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {width: -1});
+      }).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal('width must be a positive integer');
+        done();
+      }).catch(done);
+    });
+
+    it('should fail with invalid scale', (done) => {
+      cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {scale: -10});
+      }).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal('scale must be positive floating point number');
+        done();
+      }).catch(done);
+    });
+
+    it('should fail with invalid xScale', (done) => {
+      cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {xScale: 0, yScale: 1});
+      }).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal('xScale and yScale must be positive floating point numbers');
+        done();
+      }).catch(done);
+    });
+
+    it('should fail with invalid yScale', (done) => {
+      cv.readImage(testImagePath).then(matrix => {
+        return cv.resize(matrix, {xScale: 1, yScale: -1});
+      }).then(() => {
+        done(new Error('should not get here'));
+      }).catch(err => {
+        expect(err.message).to.equal('xScale and yScale must be positive floating point numbers');
+        done();
+      }).catch(done);
+    });
+
+  });
+
+  describe('cv.resizeSync', () => {
+
+    it('should resize image to width preserving aspect ratio', () => {
+      const image = cv.readImageSync(testImagePath);
+      const resized = cv.resizeSync(image, testImageWidth / 2);
+
+      expect(resized.width).to.equal(testImageWidth / 2);
+      expect(resized.height).to.equal(testImageHeight / 2);
+      expect(resized.type).to.equal(cv.ImageType.BGR);
+    });
+
+    it('should resize gray image to width preserving aspect ratio', () => {
+      const image = cv.readImageSync(testImagePath, cv.ImageType.Gray);
+      const resized = cv.resizeSync(image, testImageWidth / 2);
+
+      expect(resized.width).to.equal(testImageWidth / 2);
+      expect(resized.height).to.equal(testImageHeight / 2);
+      expect(resized.type).to.equal(cv.ImageType.Gray);
+    });
+
+    it('should resize image to width preserving aspect ratio', () => {
+      const image = cv.readImageSync(testImagePath);
+      const resized = cv.resizeSync(image, {width: testImageWidth / 4});
+
+      expect(resized.width).to.equal(testImageWidth / 4);
+      expect(resized.height).to.equal(testImageHeight / 4);
+      expect(resized.type).to.equal(cv.ImageType.BGR);
+    });
+
+    it('should resize image to height preserving aspect ratio', () => {
+      const image = cv.readImageSync(testImagePath);
+      const resized = cv.resizeSync(image, {height: testImageHeight / 4});
+
+      expect(resized.width).to.equal(testImageWidth / 4);
+      expect(resized.height).to.equal(testImageHeight / 4);
+      expect(resized.type).to.equal(cv.ImageType.BGR);
+    });
+
+  });
+
+  describe('cv.resizeMany', () => {
+
+    it('should produce the same outputs as cv.resize', () => {
+      const sizes = [testImageWidth * 2, testImageWidth, {width: 512}, {height: 100}, 64, {scale: 0.3}];
+
+      return cv.readImage(testImagePath).then(image => {
+        return cv.resizeMany(image, sizes).then(outputs => {
+          expect(outputs).to.have.length(sizes.length);
+
+          outputs.forEach((output, i) => {
+            const expected = cv.resizeSync(image, sizes[i]);
+
+            expect(output.width).to.equal(expected.width);
+            expect(output.height).to.equal(expected.height);
+            expect(output.toBuffer().equals(expected.toBuffer())).to.equal(true);
+          });
+        });
+      });
+    });
+
+    it('should encode the outputs', () => {
+      return cv.readImage(testImagePath).then(image => {
+        return cv.resizeMany(image, [256, 64], {encode: cv.EncodeType.JPEG, quality: 80}).then(buffers => {
+          expect(buffers[0].equals(cv.encodeImageSync(cv.resizeSync(image, 256), {type: cv.EncodeType.JPEG, quality: 80}))).to.equal(true);
+          return Promise.all(buffers.map(it => cv.decodeImage(it)));
+        });
+      }).then(([first, second]) => {
+        expect(first.width).to.equal(256);
+        expect(second.width).to.equal(64);
+      });
+    });
+
+    it('should fail with an invalid sizeSpec', (done) => {
+      cv.resizeMany(cv.matrix([[1, 2]]), [10, {width: -1}]).catch(err => {
+        expect(err.message).to.equal('width must be a positive integer');
+        done();
+      });
+    });
+
+  });
+
+  describe('cv.resizeManySync', () => {
+
+    it('should resize to each size', () => {
+      const outputs = cv.resizeManySync(cv.matrix([[1, 2, 3, 4], [5, 6, 7, 8]]), [2, {width: 8, height: 1}]);
+
+      expect(outputs.map(it => [it.width, it.height])).to.eql([[2, 1], [8, 1]]);
+    });
+
+    it('should fail if the second argument is not an array', () => {
+      expect(() => {
+        cv.resizeManySync(cv.matrix([[1]]), 10);
+      }).to.throwException(err => {
+        expect(err.message).to.equal('second argument (sizeSpecs) must be an array of sizeSpecs');
+      });
+    });
+
+  });
+
+  describe('cv.warpAffine', () => {
+
+    it('should transform an image', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      const transpose = cv.matrix([
+        [0, 1, 0],
+        [1, 0, 0]
+      ]);
+
+      // Test a simple transpose transformation.
+      return cv.warpAffine(matrix, transpose).then(image => {
+        expect(image.toArray()).to.eql([
+          1, 3, 0,
+          2, 4, 0,
+          0, 0, 0
+        ]);
+      });
+    });
+
+    it('should accept options object', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      const rot = cv.rotationMatrix({x: 0, y: 0}, 90);
+
+      return Promise.all([
+        cv.warpAffine(matrix, rot, {borderType: cv.BorderType.Replicate}).then(image => {
+          expect(image.toArray()).to.eql([
+            1, 3, 0,
+            1, 3, 0,
+            1, 3, 0
+          ]);
+        }),
+        cv.warpAffine(matrix, rot, {borderType: cv.BorderType.Constant, borderValue: 5}).then(image => {
+          expect(image.toArray()).to.eql([
+            1, 3, 0,
+            5, 5, 5,
+            5, 5, 5
+          ]);
+        })
+      ])
+    });
+
+  });
+
+  describe('cv.warpAffineSync', () => {
+
+    it('should transform an image', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      const transpose = cv.matrix([
+        [0, 1, 0],
+        [1, 0, 0]
+      ]);
+
+      // Test a simple transpose transformation.
+      const result = cv.warpAffineSync(matrix, transpose);
+
+      expect(result.toArray()).to.eql([
+        1, 3, 0,
+        2, 4, 0,
+        0, 0, 0
+      ]);
+    });
+
+    it('should accept options object', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      const rot = cv.rotationMatrix({x: 0, y: 0}, 90);
+
+      const res1 = cv.warpAffineSync(matrix, rot, {borderType: cv.BorderType.Replicate});
+
+      expect(res1.toArray()).to.eql([
+        1, 3, 0,
+        1, 3, 0,
+        1, 3, 0
+      ]);
+
+      const res2 = cv.warpAffineSync(matrix, rot, {borderType: cv.BorderType.Constant, borderValue: 5});
+
+      expect(res2.toArray()).to.eql([
+        1, 3, 0,
+        5, 5, 5,
+        5, 5, 5
+      ]);
+    });
+
+    it('should accept size and interpolation options', () => {
+      const matrix = cv.matrix({width: 3, height: 3, type: cv.ImageType.Gray, data: [
+        1, 2, 0,
+        3, 4, 0,
+        0, 0, 0
+      ]});
+
+      const transpose = cv.matrix([
+        [0, 1, 0],
+        [1, 0, 0]
+      ]);
+
+      const result = cv.warpAffineSync(matrix, transpose, {
+        size: {width: 2, height: 2},
+        interpolation: cv.Interpolation.Nearest
+      });
+
+      expect(result.width).to.equal(2);
+      expect(result.height).to.equal(2);
+      expect(result.toArray()).to.eql([
+        1, 3,
+        2, 4
+      ]);
+    });
+
+    it('should fail with an invalid interpolation', () => {
+      expect(() => {
+        cv.warpAffineSync(cv.matrix([[1]]), cv.matrix([[1, 0, 0], [0, 1, 0]]), {interpolation: 42});
+      }).to.throwException(err => {
+        expect(err.message).to.equal('interpolation must be one of cv.Interpolation.[Nearest, Linear, Cubic, Lanczos4]');
+      });
+    });
+
+  });
+
+  describe('cv.createWarp', () => {
+
+    it('should produce the same result as warpAffine', () => {
+      const image = cv.readImageSync(testImagePath);
+      const rotation = cv.rotationMatrix({x: testImageWidth / 2, y: testImageHeight / 2}, 3);
+      const opt = {interpolation: cv.Interpolation.Linear, borderType: cv.BorderType.Replicate};
+
+      return cv.createWarp(rotation, Object.assign({srcSize: {width: testImageWidth, height: testImageHeight}}, opt)).then(warp => {
+        expect(warp).to.be.a(cv.Warp);
+        expect(warp.width).to.equal(testImageWidth);
+        expect(warp.height).to.equal(testImageHeight);
+
+        return Promise.all([
+          warp.apply(image),
+          warp.apply(image),
+          cv.warpAffine(image, rotation, opt)
+        ]);
+      }).then(([warped1, warped2, expected]) => {
+        expect(warped1.toArray()).to.eql(warped2.toArray());
+        expect(cv.compareSync(warped1, expected, {metrics: ['psnr']}).psnr).to.be.greaterThan(40);
+      });
+    });
+
+  });
+
+  describe('cv.createWarpSync', () => {
+
+    it('should support an output size', () => {
+      const matrix = cv.matrix({width: 3, height: 3, type: cv.ImageType.Gray, data: [
+        1, 2, 0,
+        3, 4, 0,
+        0, 0, 0
+      ]});
+
+      const transpose = cv.matrix([
+        [0, 1, 0],
+        [1, 0, 0]
+      ]);
+
+      const warp = cv.createWarpSync(transpose, {
+        srcSize: {width: 3, height: 3},
+        dstSize: {width: 2, height: 2},
+        interpolation: cv.Interpolation.Nearest
+      });
+
+      expect(warp.applySync(matrix).toArray()).to.eql([
+        1, 3,
+        2, 4
+      ]);
+    });
+
+    it('should fail if the image size is not srcSize', () => {
+      const warp = cv.createWarpSync(cv.matrix([[1, 0, 0], [0, 1, 0]]), {srcSize: {width: 3, height: 3}});
+
+      expect(() => {
+        warp.applySync(cv.matrix({width: 2, height: 2, type: cv.ImageType.Gray, data: [1, 2, 3, 4]}));
+      }).to.throwException(err => {
+        expect(err.message).to.equal('first argument (image) must have the size the warp was created for (w=3, h=3)');
+      });
+    });
+
+    it('should fail without srcSize', () => {
+      expect(() => {
+        cv.createWarpSync(cv.matrix([[1, 0, 0], [0, 1, 0]]), {});
+      }).to.throwException(err => {
+        expect(err.message).to.equal('srcSize must be a size {width, height} with a positive width and height');
+      });
+    });
+
+  });
+
+  describe('cv.Transform', () => {
+    const gray = (width, height, data) => cv.matrix({width, height, type: cv.ImageType.Gray, data});
+
+    it('should chain operations into a single matrix', () => {
+      const transform = new cv.Transform().scale(2).translate(1, 0);
+      expect(transform.toMatrix().toArray()).to.eql([2, 0, 1, 0, 2, 0]);
+
+      transform.compose(new cv.Transform().scale(0.5, 1));
+      expect(transform.toMatrix().toArray()).to.eql([1, 0, 0.5, 0, 2, 0]);
+
+      transform.invert();
+      expect(transform.toMatrix().toArray()).to.eql([1, 0, -0.5, 0, 0.5, 0]);
+    });
+
+    it('should accept a transformation matrix', () => {
+      const transform = new cv.Transform(cv.matrix([[0, 1, 0], [1, 0, 0]]));
+      transform.compose(cv.matrix([[1, 0, 2], [0, 1, 3]]));
+
+      expect(transform.toMatrix().toArray()).to.eql([0, 1, 2, 1, 0, 3]);
+    });
+
+    it('should flip and rotate an image exactly into the output bounds', () => {
+      const image = gray(3, 2, [
+        1, 2, 3,
+        4, 5, 6
+      ]);
+
+      const opt = {interpolation: cv.Interpolation.Nearest};
+
+      return Promise.all([
+        new cv.Transform().flipLeftRight().apply(image, opt),
+        new cv.Transform().rotate(90).applySync(image, opt),
+        new cv.Transform().scale(2).rotate(90).flipUpDown().apply(image, opt)
+      ]).then(([flipped, rotated, combined]) => {
+        expect(flipped.toArray()).to.eql([
+          3, 2, 1,
+          6, 5, 4
+        ]);
+
+        expect(rotated.width).to.equal(2);
+        expect(rotated.height).to.equal(3);
+        expect(rotated.toArray()).to.eql([
+          3, 6,
+          2, 5,
+          1, 4
+        ]);
+
+        expect(combined.width).to.equal(4);
+        expect(combined.height).to.equal(6);
+      });
+    });
+
+    it('should use the given output size', () => {
+      const image = gray(2, 2, [1, 2, 3, 4]);
+      const result = new cv.Transform().translate(1, 0).applySync(image, {
+        size: {width: 3, height: 2},
+        interpolation: cv.Interpolation.Nearest
+      });
+
+      expect(result.toArray()).to.eql([
+        0, 1, 2,
+        0, 3, 4
+      ]);
+    });
+
+    it('should fail to invert a singular transformation', () => {
+      expect(() => {
+        new cv.Transform().scale(0).invert();
+      }).to.throwException(err => {
+        expect(err.message).to.equal('the transformation is not invertible');
+      });
+    });
+
+    it('should fail with non-finite numbers', () => {
+      expect(() => {
+        new cv.Transform().scale(Infinity);
+      }).to.throwException(err => {
+        expect(err.message).to.equal('scaleX and scaleY must be finite numbers');
+      });
+
+      expect(() => {
+        new cv.Transform().rotate(NaN);
+      }).to.throwException(err => {
+        expect(err.message).to.equal('first argument (angle) must be a finite number');
+      });
+
+      expect(() => {
+        new cv.Transform().translate(0, -Infinity);
+      }).to.throwException(err => {
+        expect(err.message).to.equal('x and y must be finite numbers');
+      });
+    });
+
+    it('should fail if the fitted output is too large', () => {
+      expect(() => {
+        new cv.Transform().scale(1e6).applySync(gray(2, 2, [1, 2, 3, 4]));
+      }).to.throwException(err => {
+        expect(err.message).to.equal('the transformed image is too large, pass an explicit size');
+      });
+    });
+
+  });
+
+  describe('cv.rotationMatrix', () => {
+
+    it('should create an affine rotation transformation matrix', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      const rotation = cv.rotationMatrix({x: 1, y: 1}, 90);
+
+      // Test a simple flip transformation.
+      return cv.warpAffine(matrix, rotation).then(image => {
+        expect(image.toArray()).to.eql([
+          0, 0, 0,
+          2, 4, 0,
+          1, 3, 0
+        ]);
+      });
+    });
+
+  });
+
+  describe('cv.rotate', () => {
+
+    it('should rotate an image', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      return cv.rotate(matrix, 90).then(image => {
+        expect(image.toArray()).to.eql([
+          0, 0, 0,
+          2, 4, 0,
+          1, 3, 0
+        ]);
+      });
+    });
+
+    it('should accept an options object', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      return cv.rotate(matrix, {angle: 90, xCenter: 0, yCenter: 1}).then(image => {
+        expect(image.toArray()).to.eql([
+          4, 0, 0,
+          3, 0, 0,
+          0, 0, 0
+        ]);
+      });
+    });
+
+    it('should rotate by multiples of 90 degrees without cropping', () => {
+      const matrix = cv.matrix([
+        [1, 2, 3],
+        [4, 5, 6]
+      ]);
+
+      return Promise.all([
+        cv.rotate(matrix, 90),
+        cv.rotate(matrix, -90),
+        cv.rotate(matrix, {angle: 180}),
+        cv.rotate(matrix, 360)
+      ]).then(([ccw, cw, upsideDown, same]) => {
+        expect(ccw.width).to.equal(2);
+        expect(ccw.height).to.equal(3);
+        expect(ccw.toArray()).to.eql([
+          3, 6,
+          2, 5,
+          1, 4
+        ]);
+
+        expect(cw.toArray()).to.eql([
+          4, 1,
+          5, 2,
+          6, 3
+        ]);
+
+        expect(upsideDown.toArray()).to.eql([
+          6, 5, 4,
+          3, 2, 1
+        ]);
+
+        expect(same.toArray()).to.eql([
+          1, 2, 3,
+          4, 5, 6
+        ]);
+      });
+    });
+
+    it('should rotate a BGR image by 90 degrees', () => {
+      return cv.readImage(testImagePath).then(image => {
+        return Promise.all([cv.rotate(image, 90), cv.rotate(image, 270)]);
+      }).then(([ccw, cw]) => {
+        expect(ccw.width).to.equal(testImageHeight);
+        expect(ccw.height).to.equal(testImageWidth);
+        expect(cw.width).to.equal(testImageHeight);
+        expect(cw.height).to.equal(testImageWidth);
+        return cv.rotate(ccw, 180);
+      }).then(rotated => {
+        expect(rotated.width).to.equal(testImageHeight);
+      });
+    });
+
+  });
+
+  describe('cv.rotateSync', () => {
+
+    it('should rotate an image', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      const result = cv.rotateSync(matrix, 90);
+
+      expect(result.toArray()).to.eql([
+        0, 0, 0,
+        2, 4, 0,
+        1, 3, 0
+      ]);
+    });
+
+    it('should accept an options object', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      const result = cv.rotateSync(matrix, {angle: 90, xCenter: 0, yCenter: 1});
+
+      expect(result.toArray()).to.eql([
+        4, 0, 0,
+        3, 0, 0,
+        0, 0, 0
+      ]);
+    });
+
+    it('should rotate by multiples of 90 degrees without cropping', () => {
+      const matrix = cv.matrix({
+        width: 3,
+        height: 2,
+        type: cv.ImageType.Gray,
+        data: [
+          1, 2, 3,
+          4, 5, 6
+        ]
+      });
+
+      const result = cv.rotateSync(matrix, 270);
+
+      expect(result.type).to.equal(cv.ImageType.Gray);
+      expect(result.toArray()).to.eql([
+        4, 1,
+        5, 2,
+        6, 3
+      ]);
+    });
+
+  });
+
+  describe('cv.flipLeftRight', () => {
+
+    it('should flip an image', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      return cv.flipLeftRight(matrix).then(matrix => {
+        expect(matrix.toArray()).to.eql([
+          0, 2, 1,
+          0, 4, 3,
+          0, 0, 0
+        ]);
+      });
+    });
+
+  });
+
+  describe('cv.flipLeftRightSync', () => {
+
+    it('should flip an image', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      const result = cv.flipLeftRightSync(matrix);
+
+      expect(result.toArray()).to.eql([
+        0, 2, 1,
+        0, 4, 3,
+        0, 0, 0
+      ]);
+    });
+
+  });
+
+  describe('cv.flipUpDown', () => {
+
+    it('should flip an image', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      return cv.flipUpDown(matrix).then(matrix => {
+        expect(matrix.toArray()).to.eql([
+          0, 0, 0,
+          3, 4, 0,
+          1, 2, 0
+        ]);
+      });
+    });
+
+  });
+
+  describe('cv.flipUpDownSync', () => {
+
+    it('should flip an image', () => {
+      const matrix = cv.matrix([
+        [1, 2, 0],
+        [3, 4, 0],
+        [0, 0, 0]
+      ]);
+
+      const result = cv.flipUpDownSync(matrix);
+
+      expect(result.toArray()).to.eql([
+        0, 0, 0,
+        3, 4, 0,
+        1, 2, 0
+      ]);
+    });
+
+  });
+
+  describe('cv.split', () => {
+
+    it('should split matrix into channels', () => {
+      const matrix = cv.matrix({
+        width: 3,
+        height: 3,
+        type: cv.ImageType.BGR,
+        data: [
+          1, 1, 1,
+          2, 2, 2,
+          3, 3, 3,
+
+          4, 4, 4,
+          5, 5, 5,
+          6, 6, 6,
+
+          7, 7, 7,
+          8, 8, 8,
+          9, 9, 9
+        ]
+      });
+
+      return cv.split(matrix).then(channels => {
+        expect(channels).to.have.length(3);
+
+        expect(channels[0]).to.be.a(cv.Matrix);
+        expect(channels[1]).to.be.a(cv.Matrix);
+        expect(channels[2]).to.be.a(cv.Matrix);
+
+        expect(channels[0].toArray()).to.eql([
+          1, 1, 1,
+          2, 2, 2,
+          3, 3, 3
+        ]);
+
+        expect(channels[1].toArray()).to.eql([
+          4, 4, 4,
+          5, 5, 5,
+          6, 6, 6
+        ]);
+
+        expect(channels[2].toArray()).to.eql([
+          7, 7, 7,
+          8, 8, 8,
+          9, 9, 9
+        ]);
+      });
+    });
+
+  });
+
+  describe('cv.splitSync', () => {
+
+    it('should split matrix into channels', () => {
+      const matrix = cv.matrix({
+        width: 3,
+        height: 3,
+        type: cv.ImageType.BGR,
+        data: [
+          1, 1, 1,
+          2, 2, 2,
+          3, 3, 3,
+
+          4, 4, 4,
+          5, 5, 5,
+          6, 6, 6,
+
+          7, 7, 7,
+          8, 8, 8,
+          9, 9, 9
+        ]
+      });
+
+      const channels =  cv.splitSync(matrix);
+      expect(channels).to.have.length(3);
+
+      expect(channels[0]).to.be.a(cv.Matrix);
+      expect(channels[1]).to.be.a(cv.Matrix);
+      expect(channels[2]).to.be.a(cv.Matrix);
+
+      expect(channels[0].type).to.equal(cv.ImageType.Gray);
+      expect(channels[1].type).to.equal(cv.ImageType.Gray);
+      expect(channels[2].type).to.equal(cv.ImageType.Gray);
+
+      expect(channels[0].toArray()).to.eql([
+        1, 1, 1,
+        2, 2, 2,
+        3, 3, 3
+      ]);
+
+      expect(channels[1].toArray()).to.eql([
+        4, 4, 4,
+        5, 5, 5,
+        6, 6, 6
+      ]);
+
+      expect(channels[2].toArray()).to.eql([
+        7, 7, 7,
+        8, 8, 8,
+        9, 9, 9
+      ]);
+    });
+
+  });
+
+  describe('cv.merge', () => {
+
+    it('should merge channels into a matrix', () => {
+      const matrix = cv.matrix({
+        width: 3,
+        height: 3,
+        type: cv.ImageType.BGR,
+        data: [
+          1, 1, 1,
+          2, 2, 2,
+          3, 3, 3,
+
+          4, 4, 4,
+          5, 5, 5,
+          6, 6, 6,
+
+          7, 7, 7,
+          8, 8, 8,
+          9, 9, 9
+        ]
+      });
+
+      return cv.split(matrix).then(channels => {
+        return cv.merge(...channels);
+      }).then(merged => {
+        expect(merged.type).to.equal(cv.ImageType.BGR);
+        expect(merged.toArray()).to.eql([
+          1, 1, 1,
+          2, 2, 2,
+          3, 3, 3,
+
+          4, 4, 4,
+          5, 5, 5,
+          6, 6, 6,
+
+          7, 7, 7,
+          8, 8, 8,
+          9, 9, 9
+        ]);
+      });
+    });
+
+  });
+
+  describe('cv.mergeSync', () => {
+
+    it('should merge channels into a matrix', () => {
+      const matrix = cv.matrix({
+        width: 3,
+        height: 3,
+        type: cv.ImageType.BGR,
+        data: [
+          1, 1, 1,
+          2, 2, 2,
+          3, 3, 3,
+
+          4, 4, 4,
+          5, 5, 5,
+          6, 6, 6,
+
+          7, 7, 7,
+          8, 8, 8,
+          9, 9, 9
+        ]
+      });
+
+      const channels = cv.splitSync(matrix);
+      const merged = cv.mergeSync(...channels);
+
+      expect(merged.type).to.equal(cv.ImageType.BGR);
+      expect(merged.toArray()).to.eql([
+        1, 1, 1,
+        2, 2, 2,
+        3, 3, 3,
+
+        4, 4, 4,
+        5, 5, 5,
+        6, 6, 6,
+
+        7, 7, 7,
+        8, 8, 8,
+        9, 9, 9
+      ]);
+    });
+
+  });
+
+  describe('cv.lookup', () => {
+
+    it('should map a matrix through a lookup table', () => {
+      const matrix = cv.matrix({
+        width: 3,
+        height: 3,
+        type: cv.ImageType.Gray,
+        data: [
+          0,   32,  64,
+          96,  128, 160,
+          192, 224, 255
+        ]
+      });
+
+      const x = [0, 32, 64, 96, 128, 160, 192, 224, 255];
+      const y = [1, 10, 20, 40, 80,  120, 180, 220, 240]
+
+      const lookupTable = cv.matrix({
+        width: 256,
+        height: 1,
+        type: cv.ImageType.Gray,
+        data: _.range(256).map(it => spline(it, x, y))
+      });
+
+      const lu = lookupTable.toArray();
+
+      return cv.lookup(matrix, lookupTable).then(result => {
+        expect(result.type).to.equal(cv.ImageType.Gray);
+
+        expect(matrix.toArray()).to.eql([
+          0,   32,  64,
+          96,  128, 160,
+          192, 224, 255
+        ]);
+
+        expect(result.toArray()).to.eql([
+          lu[0],   lu[32],  lu[64],
+          lu[96],  lu[128], lu[160],
+          lu[192], lu[224], lu[255]
+        ]);
+      });
+    });
+
+  });
+
+  describe('cv.lookupSync', () => {
+
+    it('should map a matrix through a lookup table', () => {
+      const matrix = cv.matrix({
+        width: 3,
+        height: 3,
+        type: cv.ImageType.Gray,
+        data: [
+          0,   32,  64,
+          96,  128, 160,
+          192, 224, 255
+        ]
+      });
+
+      const x = [0, 32, 64, 96, 128, 160, 192, 224, 255];
+      const y = [1, 10, 20, 40, 80,  120, 180, 220, 240]
+
+      const lookupTable = cv.matrix({
+        width: 256,
+        height: 1,
+        type: cv.ImageType.Gray,
+        data: _.range(256).map(it => spline(it, x, y))
+      });
+
+      const lu = lookupTable.toArray();
+      const result = cv.lookupSync(matrix, lookupTable);
+
+      expect(result.type).to.equal(cv.ImageType.Gray);
+
+      expect(matrix.toArray()).to.eql([
+        0,   32,  64,
+        96,  128, 160,
+        192, 224, 255
+      ]);
+
+      expect(result.toArray()).to.eql([
+        lu[0],   lu[32],  lu[64],
+        lu[96],  lu[128], lu[160],
+        lu[192], lu[224], lu[255]
+      ]);
+    });
+
+  });
+
+  describe('cv.lookup with multiple tables', () => {
+
+    it('should apply a separate table for each channel', () => {
+      const matrix = cv.matrix({
+        width: 2,
+        height: 1,
+        type: cv.ImageType.BGR,
+        data: [
+          10, 20,
+          30, 40,
+          50, 60
+        ]
+      });
+
+      const lookupTable = cv.matrix({
+        width: 256,
+        height: 3,
+        type: cv.ImageType.Gray,
+        data: [].concat(
+          _.range(256).map(it => it + 1),
+          _.range(256).map(it => it + 2),
+          _.range(256).map(it => it + 3)
+        )
+      });
+
+      return cv.lookup(matrix, lookupTable).then(result => {
+        expect(result.type).to.equal(cv.ImageType.BGR);
+        expect(result.toArray()).to.eql([
+          11, 21,
+          32, 42,
+          53, 63
+        ]);
+      });
+    });
+
+    it('should compose a chain of tables', () => {
+      const matrix = cv.matrix({width: 3, height: 1, type: cv.ImageType.Gray, data: [0, 100, 200]});
+      const double = cv.matrix({width: 256, height: 1, type: cv.ImageType.Gray, data: _.range(256).map(it => Math.min(255, it * 2))});
+      const invert = cv.matrix({width: 256, height: 1, type: cv.ImageType.Gray, data: _.range(256).map(it => 255 - it)});
+
+      const composed = cv.composeLookups([double, invert]);
+      expect(composed.toArray().slice(0, 3)).to.eql([255, 253, 251]);
+
+      return cv.lookup(matrix, [double, invert]).then(result => {
+        expect(result.toArray()).to.eql([255, 55, 0]);
+      });
+    });
+
+  });
+
+  describe('cv.lookup3d', () => {
+    const filePath = path.join(os.tmpdir(), 'tmp-invert.cube');
+
+    const identityLut = size => cv.matrix({
+      width: 3,
+      height: size * size * size,
+      type: cv.ImageType.Float,
+      data: _.flatten(_.range(size * size * size).map(i => [
+        (i % size) / (size - 1),
+        (Math.floor(i / size) % size) / (size - 1),
+        Math.floor(i / (size * size)) / (size - 1)
+      ]))
+    });
+
+    it('should map colors through a 3D lookup table', () => {
+      return cv.readImage(testImagePath).then(image => {
+        return Promise.all([image, cv.lookup3d(image, identityLut(17))]);
+      }).then(([image, result]) => {
+        expect(result.type).to.equal(cv.ImageType.BGR);
+        expect(result.toBuffer().equals(image.toBuffer())).to.equal(true);
+      });
+    });
+
+    it('should read a .cube file', () => {
+      fs.writeFileSync(filePath, [
+        '# Inverts all colors',
+        'TITLE "invert"',
+        'LUT_3D_SIZE 2',
+        '1 1 1', '0 1 1', '1 0 1', '0 0 1',
+        '1 1 0', '0 1 0', '1 0 0', '0 0 0'
+      ].join('\n'));
+
+      const matrix = cv.matrix({width: 1, height: 1, type: cv.ImageType.BGR, data: [10, 100, 200]});
+
+      return cv.readCubeLut(filePath).then(lut => {
+        expect(lut.width).to.equal(3);
+        expect(lut.height).to.equal(8);
+        return cv.lookup3d(matrix, lut);
+      }).then(result => {
+        expect(result.toArray()).to.eql([245, 155, 55]);
+      });
+    });
+
+  });
+
+  describe('cv.lookup3dSync', () => {
+
+    it('should fail if the lookup table is not a 3D lookup table', () => {
+      const matrix = new cv.Matrix(2, 2, cv.ImageType.BGR);
+
+      expect(() => {
+        cv.lookup3dSync(matrix, cv.matrix([[1, 2, 3]]));
+      }).to.throwException(err => {
+        expect(err.message).to.equal('second argument (lookupTable) must be a 3D lookup table returned by cv.readCubeLut');
+      });
+    });
+
+  });
+
+  describe('cv.gaussianBlur', () => {
+
+    it('should blur an image', () => {
+      const matrix = cv.matrix([
+        [0, 0, 0, 0, 0],
+        [0, 0, 0, 0, 0],
+        [0, 0, 10, 0, 0],
+        [0, 0, 0, 0, 0],
+        [0, 0, 0, 0, 0]
+      ]);
+
+      return Promise.all([
+        cv.gaussianBlur(matrix, {kernelSize: 5}),
+        cv.gaussianBlur(matrix, {kernelSize: {width: 5, height: 1}}),
+        cv.gaussianBlur(matrix, {kernelSize: 5, sigma: 0.8}),
+      ]).then(([res1, res2, res3]) => {
+        res1 = res1.toArray().map(it => Math.round(it * 10));
+        res2 = res2.toArray().map(it => Math.round(it * 10));
+        res3 = res3.toArray().map(it => Math.round(it * 10));
+
+        expect(res1).to.eql([
+          2, 3, 5,  3, 2,
+          3, 6, 9,  6, 3,
+          5, 9, 14, 9, 5,
+          3, 6, 9,  6, 3,
+          2, 3, 5,  3, 2
+        ]);
+
+        expect(res2).to.eql([
+          0,  0,  0,  0,  0,
+          0,  0,  0,  0,  0,
+          13, 25, 38, 25, 13,
+          0,  0,  0,  0,  0,
+          0,  0,  0,  0,  0
+        ]);
+
+        expect(res3).to.eql([
+          0, 1,  2,  1,  0,
+          1, 5,  11, 5,  1,
+          2, 11, 25, 11, 2,
+          1, 5,  11, 5,  1,
+          0, 1,  2,  1,  0
+        ]);
+      });
+    });
 
-      const rot = cv.rotationMatrix({x: 0, y: 0}, 90);
+    it('should blur with a recursive filter or box filters for large sigmas', () => {
+      const size = 201;
+      const data = _.range(size * size).map(() => 0);
+      data[100 * size + 100] = 1000000;
+
+      const matrix = cv.matrix({width: size, height: size, type: cv.ImageType.Float, data});
 
       return Promise.all([
-        cv.warpAffine(matrix, rot, {borderType: cv.BorderType.Replicate}).then(image => {
-          expect(image.toArray()).to.eql([
-            1, 3, 0,
-            1, 3, 0,
-            1, 3, 0
-          ]);
-        }),
-        cv.warpAffine(matrix, rot, {borderType: cv.BorderType.Constant, borderValue: 5}).then(image => {
-          expect(image.toArray()).to.eql([
-            1, 3, 0,
-            5, 5, 5,
-            5, 5, 5
-          ]);
-        })
-      ])
+        cv.gaussianBlur(matrix, {sigma: 20, method: 'iir'}),
+        cv.gaussianBlur(matrix, {sigma: 20, method: 'box3'}),
+        cv.gaussianBlur(matrix, {sigma: 20, method: 'auto'}),
+        cv.gaussianBlur(matrix, {sigma: 20, kernelSize: 121})
+      ]).then(results => {
+        const reference = results[3].toArray();
+        const center = reference[100 * size + 100];
+
+        results.slice(0, 3).map(it => it.toArray()).forEach(result => {
+          // Symmetric around the center.
+          expect(result[100 * size + 80]).to.be.within(result[100 * size + 120] * 0.99, result[100 * size + 120] * 1.01);
+          expect(result[80 * size + 100]).to.be.within(result[120 * size + 100] * 0.99, result[120 * size + 100] * 1.01);
+
+          // Close to the exact gaussian.
+          expect(result[100 * size + 100]).to.be.within(center * 0.9, center * 1.1);
+          expect(result[100 * size + 120]).to.be.within(reference[100 * size + 120] * 0.9, reference[100 * size + 120] * 1.1);
+        });
+      });
     });
 
-  });
+    it('should keep a constant image constant', () => {
+      const matrix = cv.matrix({width: 64, height: 64, type: cv.ImageType.BGR, data: _.range(64 * 64 * 3).map(() => 128)});
 
-  describe('cv.warpAffineSync', () => {
+      return Promise.all([
+        cv.gaussianBlur(matrix, {sigma: 30, method: 'iir'}),
+        cv.gaussianBlur(matrix, {sigma: 30, method: 'box3'})
+      ]).then(([iir, box3]) => {
+        expect(_.uniq(iir.toArray())).to.eql([128]);
+        expect(_.uniq(box3.toArray())).to.eql([128]);
+      });
+    });
 
-    it('should transform an image', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+    it('should choose the method for each axis with auto', () => {
+      const image = cv.readImageSync(testImagePath);
 
-      const transpose = cv.matrix([
-        [0, 1, 0],
-        [1, 0, 0]
-      ]);
+      return Promise.all([
+        cv.gaussianBlur(image, {xSigma: 10, ySigma: 0.2, method: 'auto'}),
+        cv.gaussianBlur(image, {xSigma: 10, ySigma: 0.2, kernelSize: 0})
+      ]).then(([auto, kernel]) => {
+        expect(cv.compareSync(auto, kernel, {metrics: ['psnr']}).psnr).to.be.greaterThan(30);
+      });
+    });
 
-      // Test a simple transpose transformation.
-      const result = cv.warpAffineSync(matrix, transpose);
+    it('should fail with a small sigma and the recursive filter', (done) => {
+      cv.gaussianBlur(cv.matrix([[1]]), {xSigma: 10, ySigma: 0.2, method: 'iir'}).catch(err => {
+        expect(err.message).to.equal("sigma must be at least 0.5 when method is 'iir'");
+        done();
+      });
+    });
 
-      expect(result.toArray()).to.eql([
-        1, 3, 0,
-        2, 4, 0,
-        0, 0, 0
-      ]);
+    it('should fail with an invalid method', (done) => {
+      cv.gaussianBlur(cv.matrix([[1]]), {sigma: 2, method: 'fft'}).catch(err => {
+        expect(err.message).to.equal("method must be one of ['kernel', 'box3', 'iir', 'auto']");
+        done();
+      });
     });
 
-    it('should accept options object', () => {
+  });
+
+  describe('cv.gaussianBlurSync', () => {
+
+    it('should blur an image', () => {
       const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
+        [0, 0, 0],
+        [0, 1, 0],
         [0, 0, 0]
       ]);
 
-      const rot = cv.rotationMatrix({x: 0, y: 0}, 90);
+      let res1 = cv.gaussianBlurSync(matrix, {kernelSize: 3, xSigma: 0.5, ySigma: 0.5});
+      let res2 = cv.gaussianBlurSync(matrix, {kernelSize: {width: 3, height: 1}, sigma: 0.5});
+      let res3 = cv.gaussianBlurSync(matrix, {kernelSize: 3, sigma: 0.6});
 
-      const res1 = cv.warpAffineSync(matrix, rot, {borderType: cv.BorderType.Replicate});
+      res1 = res1.toArray().map(it => Math.round(it * 10));
+      res2 = res2.toArray().map(it => Math.round(it * 10));
+      res3 = res3.toArray().map(it => Math.round(it * 10));
 
-      expect(res1.toArray()).to.eql([
-        1, 3, 0,
-        1, 3, 0,
-        1, 3, 0
+      expect(res1).to.eql([
+        0, 2, 0,
+        2, 6, 2,
+        0, 2, 0
       ]);
 
-      const res2 = cv.warpAffineSync(matrix, rot, {borderType: cv.BorderType.Constant, borderValue: 5});
+      expect(res2).to.eql([
+        0, 0, 0,
+        2, 8, 2,
+        0, 0, 0
+      ]);
 
-      expect(res2.toArray()).to.eql([
-        1, 3, 0,
-        5, 5, 5,
-        5, 5, 5
+      expect(res3).to.eql([
+        1, 2, 1,
+        2, 4, 2,
+        1, 2, 1
       ]);
     });
 
   });
 
-  describe('cv.rotationMatrix', () => {
+  describe('cv.colorTemperature', () => {
 
-    it('should create an affine rotation transformation matrix', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+    it('should change the color temperature of the image', () => {
+      const matrix = cv.matrix({
+        width: 3,
+        height: 3,
+        type: cv.ImageType.BGR,
+        data: [
+          0,   0,   0,
+          128, 128, 128,
+          255, 255, 255,
 
-      const rotation = cv.rotationMatrix({x: 1, y: 1}, 90);
+          0,   0,   0,
+          128, 128, 128,
+          255, 255, 255,
 
-      // Test a simple flip transformation.
-      return cv.warpAffine(matrix, rotation).then(image => {
-        expect(image.toArray()).to.eql([
-          0, 0, 0,
-          2, 4, 0,
-          1, 3, 0
-        ]);
+          0,   0,   0,
+          128, 128, 128,
+          255, 255, 255
+        ]
       });
-    });
 
-  });
-
-  describe('cv.rotate', () => {
+      return cv.colorTemperature(matrix, 4000, 1).then(result => {
+        expect(result.toArray()).to.eql([
+          0,   0,   0,
+          95,  95,  95,
+          255, 255, 255,
 
-    it('should rotate an image', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+          0,   0,   0,
+          124, 124, 124,
+          255, 255, 255,
 
-      return cv.rotate(matrix, 90).then(image => {
-        expect(image.toArray()).to.eql([
-          0, 0, 0,
-          2, 4, 0,
-          1, 3, 0
+          0,   0,   0,
+          161, 161, 161,
+          255, 255, 255
         ]);
       });
     });
 
-    it('should accept an options object', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+  });
 
-      return cv.rotate(matrix, {angle: 90, xCenter: 0, yCenter: 1}).then(image => {
-        expect(image.toArray()).to.eql([
-          4, 0, 0,
-          3, 0, 0,
-          0, 0, 0
-        ]);
-      });
-    });
+  describe('cv.colorTemperatureSync', () => {
 
-  });
+    it('should change the color temperature of the image', () => {
+      const matrix = cv.matrix({
+        width: 3,
+        height: 3,
+        type: cv.ImageType.BGR,
+        data: [
+          0,   0,   0,
+          128, 128, 128,
+          255, 255, 255,
 
-  describe('cv.rotateSync', () => {
+          0,   0,   0,
+          128, 128, 128,
+          255, 255, 255,
 
-    it('should rotate an image', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+          0,   0,   0,
+          128, 128, 128,
+          255, 255, 255
+        ]
+      });
 
-      const result = cv.rotateSync(matrix, 90);
+      const result =  cv.colorTemperatureSync(matrix, 4000, 1);
 
       expect(result.toArray()).to.eql([
-        0, 0, 0,
-        2, 4, 0,
-        1, 3, 0
-      ]);
-    });
-
-    it('should accept an options object', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+        0,   0,   0,
+        95,  95,  95,
+        255, 255, 255,
 
-      const result = cv.rotateSync(matrix, {angle: 90, xCenter: 0, yCenter: 1});
+        0,   0,   0,
+        124, 124, 124,
+        255, 255, 255,
 
-      expect(result.toArray()).to.eql([
-        4, 0, 0,
-        3, 0, 0,
-        0, 0, 0
+        0,   0,   0,
+        161, 161, 161,
+        255, 255, 255
       ]);
     });
 
   });
 
-  describe('cv.flipLeftRight', () => {
+  describe('cv.compare', () => {
 
-    it('should flip an image', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+    it('should compute psnr, ssim and msssim', () => {
+      return cv.readImage(testImagePath).then(image => {
+        const blurred = cv.gaussianBlurSync(image, {sigma: 2, method: 'auto'});
 
-      return cv.flipLeftRight(matrix).then(matrix => {
-        expect(matrix.toArray()).to.eql([
-          0, 2, 1,
-          0, 4, 3,
-          0, 0, 0
+        return Promise.all([
+          cv.compare(image, image, {metrics: ['psnr', 'ssim', 'msssim']}),
+          cv.compare(image, blurred, {metrics: ['psnr', 'ssim', 'msssim']}),
+          cv.compare(image, cv.gaussianBlurSync(image, {sigma: 6, method: 'auto'}), {metrics: ['psnr', 'ssim', 'msssim']})
         ]);
+      }).then(([same, slightlyBlurred, veryBlurred]) => {
+        expect(same.psnr).to.equal(Infinity);
+        expect(same.ssim).to.be.within(0.9999, 1.0001);
+        expect(same.msssim).to.be.within(0.9999, 1.0001);
+
+        expect(slightlyBlurred.psnr).to.be.greaterThan(veryBlurred.psnr);
+        expect(slightlyBlurred.ssim).to.be.greaterThan(veryBlurred.ssim);
+        expect(slightlyBlurred.msssim).to.be.greaterThan(veryBlurred.msssim);
+        expect(slightlyBlurred.ssim).to.be.lessThan(1);
       });
     });
 
-  });
+    it('should return the ssim map', () => {
+      return cv.readImage(alphaImagePath).then(image => {
+        return cv.compare(image, cv.gaussianBlurSync(image, {sigma: 2, method: 'auto'}), {metrics: ['ssim'], ssimMap: true});
+      }).then(result => {
+        expect(result.psnr).to.equal(undefined);
+        expect(result.ssimMap.width).to.equal(90);
+        expect(result.ssimMap.height).to.equal(75);
+        expect(result.ssimMap.type).to.equal(cv.ImageType.Float32);
+
+        const stats = cv.statsSync(result.ssimMap);
+        expect(stats.mean[0]).to.be.within(result.ssim - 1e-4, result.ssim + 1e-4);
+      });
+    });
 
-  describe('cv.flipLeftRightSync', () => {
+    it('should fail with images of different sizes', (done) => {
+      cv.compare(cv.matrix([[1, 2]]), cv.matrix([[1]])).catch(err => {
+        expect(err.message).to.equal('second argument (image2) must have the same size and type as the first argument (image1)');
+        done();
+      });
+    });
 
-    it('should flip an image', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+    it('should fail with too small images for msssim', (done) => {
+      cv.compare(cv.matrix([[1, 2]]), cv.matrix([[1, 2]]), {metrics: ['msssim']}).catch(err => {
+        expect(err.message).to.equal('msssim requires images of at least 176x176 pixels');
+        done();
+      });
+    });
 
-      const result = cv.flipLeftRightSync(matrix);
+  });
 
-      expect(result.toArray()).to.eql([
-        0, 2, 1,
-        0, 4, 3,
-        0, 0, 0
-      ]);
+  describe('cv.compareSync', () => {
+
+    it('should compute the psnr of a known error', () => {
+      const image1 = cv.matrix({width: 2, height: 1, type: cv.ImageType.Gray, data: [100, 100]});
+      const image2 = cv.matrix({width: 2, height: 1, type: cv.ImageType.Gray, data: [110, 90]});
+      const result = cv.compareSync(image1, image2, {metrics: ['psnr']});
+      expect(result.psnr).to.be.within(28.13, 28.14);
+    });
+
+    it('should fail with an invalid metric', () => {
+      expect(() => {
+        cv.compareSync(cv.matrix([[1]]), cv.matrix([[1]]), {metrics: ['mse']});
+      }).to.throwException(err => {
+        expect(err.message).to.equal("metrics must be a non-empty array of ['psnr', 'ssim', 'msssim']");
+      });
     });
 
   });
 
-  describe('cv.flipUpDown', () => {
+  describe('cv.extractPatches', () => {
 
-    it('should flip an image', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+    // 4x2 BGR image where each pixel's blue value is its index.
+    const image = cv.matrix({
+      width: 4,
+      height: 2,
+      type: cv.ImageType.BGR,
+      data: [].concat(_.range(8), _.range(8).map(it => it + 100), _.range(8).map(it => it + 200))
+    });
 
-      return cv.flipUpDown(matrix).then(matrix => {
-        expect(matrix.toArray()).to.eql([
-          0, 0, 0,
-          3, 4, 0,
-          1, 2, 0
+    it('should pack patches in NCHW layout', () => {
+      return cv.extractPatches(image, [{x: 0, y: 0, width: 2, height: 2}, {x: 2, y: 0, width: 2, height: 2}], {size: 2}).then(tensor => {
+        expect(tensor).to.be.a(Float32Array);
+        expect(Array.from(tensor)).to.eql([
+          0, 1, 4, 5, 100, 101, 104, 105, 200, 201, 204, 205,
+          2, 3, 6, 7, 102, 103, 106, 107, 202, 203, 206, 207
         ]);
       });
     });
 
-  });
+    it('should pack patches in NHWC layout with normalization', () => {
+      const opt = {size: {width: 1, height: 1}, layout: 'NHWC', rgb: true, mean: [200, 100, 0], std: 2};
 
-  describe('cv.flipUpDownSync', () => {
+      return cv.extractPatches(image, [{x: 1, y: 1, width: 1, height: 1}], opt).then(tensor => {
+        expect(Array.from(tensor)).to.eql([(205 - 200) / 2, (105 - 100) / 2, 5 / 2]);
+      });
+    });
 
-    it('should flip an image', () => {
-      const matrix = cv.matrix([
-        [1, 2, 0],
-        [3, 4, 0],
-        [0, 0, 0]
-      ]);
+    it('should write into an existing array', () => {
+      const out = new Float32Array(2 * 3 * 4);
+      const tensor = cv.extractPatchesSync(image, [{x: 0, y: 0, width: 4, height: 2}, {x: 0, y: 0, width: 4, height: 2}], {size: {width: 2, height: 2}, layout: 'NHWC', out});
 
-      const result = cv.flipUpDownSync(matrix);
+      expect(tensor).to.equal(out);
+      expect(out[0]).to.be.within(0, 8);
+      expect(Array.from(out.slice(0, 12))).to.eql(Array.from(out.slice(12)));
+    });
 
-      expect(result.toArray()).to.eql([
-        0, 0, 0,
-        3, 4, 0,
-        1, 2, 0
-      ]);
+    it('should write into an existing array asynchronously', () => {
+      const out = new Float32Array(12);
+
+      return cv.extractPatches(image, [{x: 0, y: 0, width: 2, height: 2}], {size: 2, out}).then(tensor => {
+        expect(tensor).to.equal(out);
+        expect(Array.from(out)).to.eql([0, 1, 4, 5, 100, 101, 104, 105, 200, 201, 204, 205]);
+      });
     });
 
-  });
+    it('should resize large patches', () => {
+      return cv.readImage(testImagePath).then(image => {
+        const rects = _.range(10).map(i => ({x: i * 50, y: i * 40, width: 300, height: 200}));
+        return Promise.all([cv.extractPatches(image, rects, {size: 32, dtype: 'uint8'}), image]);
+      }).then(([tensor, image]) => {
+        expect(tensor).to.be.a(Uint8Array);
+        expect(tensor.length).to.equal(10 * 3 * 32 * 32);
 
-  describe('cv.split', () => {
+        // The mean of the blue plane of the last patch should match the mean of the cropped region.
+        const blue = tensor.slice(9 * 3 * 32 * 32, 9 * 3 * 32 * 32 + 32 * 32);
+        const expected = cv.statsSync(image.cropSync({x: 450, y: 360, width: 300, height: 200})).mean[0];
 
-    it('should split matrix into channels', () => {
-      const matrix = cv.matrix({
-        width: 3,
-        height: 3,
-        type: cv.ImageType.BGR,
-        data: [
-          1, 1, 1,
-          2, 2, 2,
-          3, 3, 3,
+        expect(Math.abs(_.sum(Array.from(blue)) / blue.length - expected)).to.be.lessThan(2);
+      });
+    });
 
-          4, 4, 4,
-          5, 5, 5,
-          6, 6, 6,
+    it('should fail with a rect outside the image', () => {
+      expect(() => {
+        cv.extractPatchesSync(image, [{x: 3, y: 0, width: 2, height: 2}], {size: 2});
+      }).to.throwException(err => {
+        expect(err.message).to.equal('rects[0] (x=3..5, y=0..2) must be a non-empty rectangle inside the image bounds (w=4, h=2)');
+      });
+    });
 
-          7, 7, 7,
-          8, 8, 8,
-          9, 9, 9
-        ]
+    it('should fail with a rect whose width overflows', () => {
+      expect(() => {
+        cv.extractPatchesSync(image, [{x: 3, y: 0, width: 2147483647, height: 2}], {size: 2});
+      }).to.throwException(err => {
+        expect(err.message).to.equal('rects[0] (x=3..2147483650, y=0..2) must be a non-empty rectangle inside the image bounds (w=4, h=2)');
       });
+    });
 
-      return cv.split(matrix).then(channels => {
-        expect(channels).to.have.length(3);
+    it('should fail with an out array of the wrong size', () => {
+      expect(() => {
+        cv.extractPatchesSync(image, [{x: 0, y: 0, width: 2, height: 2}], {size: 2, out: new Float32Array(11)});
+      }).to.throwException(err => {
+        expect(err.message).to.equal('out must be a Float32Array with 12 elements');
+      });
+    });
 
-        expect(channels[0]).to.be.a(cv.Matrix);
-        expect(channels[1]).to.be.a(cv.Matrix);
-        expect(channels[2]).to.be.a(cv.Matrix);
+    it('should fail if the patches are too large for a typed array', () => {
+      expect(() => {
+        cv.extractPatchesSync(image, [{x: 0, y: 0, width: 2, height: 2}], {size: 100000});
+      }).to.throwException(err => {
+        expect(err.message).to.equal('the output for 1 patches of 100000x100000 pixels is too large for a typed array');
+      });
+    });
 
-        expect(channels[0].toArray()).to.eql([
-          1, 1, 1,
-          2, 2, 2,
-          3, 3, 3
-        ]);
+  });
 
-        expect(channels[1].toArray()).to.eql([
-          4, 4, 4,
-          5, 5, 5,
-          6, 6, 6
-        ]);
+  describe('cv.nms', () => {
+    const boxes = new Float32Array([
+      0, 0, 10, 10,
+      1, 1, 10, 10,
+      20, 20, 10, 10,
+      0, 0, 10, 10
+    ]);
 
-        expect(channels[2].toArray()).to.eql([
-          7, 7, 7,
-          8, 8, 8,
-          9, 9, 9
-        ]);
+    const scores = new Float32Array([0.9, 0.8, 0.7, 0.95]);
+
+    it('should return the indices of the kept boxes', () => {
+      return cv.nms(boxes, scores).then(keep => {
+        expect(keep).to.be.an(Int32Array);
+        expect(Array.from(keep)).to.eql([3, 2]);
+      });
+    });
+
+    it('should respect the iouThreshold, scoreThreshold and topK options', () => {
+      expect(Array.from(cv.nmsSync(boxes, scores, {iouThreshold: 0.7}))).to.eql([3, 1, 2]);
+      expect(Array.from(cv.nmsSync(boxes, scores, {iouThreshold: 0.7, topK: 2}))).to.eql([3, 1]);
+      expect(Array.from(cv.nmsSync(boxes, scores, {scoreThreshold: 0.75}))).to.eql([3]);
+    });
+
+    it('should fail if there is not one score per box', () => {
+      expect(() => {
+        cv.nmsSync(boxes, new Float32Array(3));
+      }).to.throwException(err => {
+        expect(err.message).to.equal('second argument (scores) must be a Float32Array with one score per box');
       });
     });
 
   });
 
-  describe('cv.splitSync', () => {
+  describe('cv.boxIoU', () => {
 
-    it('should split matrix into channels', () => {
-      const matrix = cv.matrix({
-        width: 3,
-        height: 3,
-        type: cv.ImageType.BGR,
-        data: [
-          1, 1, 1,
-          2, 2, 2,
-          3, 3, 3,
+    it('should compute the iou of each pair of boxes', () => {
+      const boxes1 = new Float32Array([0, 0, 10, 10]);
+      const boxes2 = new Float32Array([0, 0, 10, 10, 5, 0, 10, 10, 100, 100, 1, 1]);
 
-          4, 4, 4,
-          5, 5, 5,
-          6, 6, 6,
+      return cv.boxIoU(boxes1, boxes2).then(iou => {
+        expect(iou).to.be.a(Float32Array);
+        expect(iou.length).to.equal(3);
+        expect(iou[0]).to.equal(1);
+        expect(iou[1]).to.be.within(0.333, 0.334);
+        expect(iou[2]).to.equal(0);
+      });
+    });
 
-          7, 7, 7,
-          8, 8, 8,
-          9, 9, 9
-        ]
+    it('should fail if the boxes are not quadruples', () => {
+      expect(() => {
+        cv.boxIoUSync(new Float32Array(5), new Float32Array(4));
+      }).to.throwException(err => {
+        expect(err.message).to.equal('first argument (boxes1) must be a Float32Array of [x, y, width, height] quadruples');
       });
+    });
 
-      const channels =  cv.splitSync(matrix);
-      expect(channels).to.have.length(3);
+    it('should fail if the table is too large for a typed array', () => {
+      const boxes = new Float32Array(4 * 50000);
 
-      expect(channels[0]).to.be.a(cv.Matrix);
-      expect(channels[1]).to.be.a(cv.Matrix);
-      expect(channels[2]).to.be.a(cv.Matrix);
+      expect(() => {
+        cv.boxIoUSync(boxes, boxes);
+      }).to.throwException(err => {
+        expect(err.message).to.equal('the IoU table of 50000x50000 boxes is too large for a typed array');
+      });
+    });
 
-      expect(channels[0].type).to.equal(cv.ImageType.Gray);
-      expect(channels[1].type).to.equal(cv.ImageType.Gray);
-      expect(channels[2].type).to.equal(cv.ImageType.Gray);
+  });
 
-      expect(channels[0].toArray()).to.eql([
-        1, 1, 1,
-        2, 2, 2,
-        3, 3, 3
-      ]);
+  describe('cv.clipBoxes', () => {
 
-      expect(channels[1].toArray()).to.eql([
-        4, 4, 4,
-        5, 5, 5,
-        6, 6, 6
+    it('should clip the boxes to the given size', () => {
+      const boxes = new Float32Array([
+        -5, -5, 10, 10,
+        95, 50, 10, 10,
+        200, 200, 5, 5
       ]);
 
-      expect(channels[2].toArray()).to.eql([
-        7, 7, 7,
-        8, 8, 8,
-        9, 9, 9
+      expect(Array.from(cv.clipBoxesSync(boxes, {width: 100, height: 100}))).to.eql([
+        0, 0, 5, 5,
+        95, 50, 5, 10,
+        100, 100, 0, 0
       ]);
     });
 
   });
 
-  describe('cv.merge', () => {
+  describe('cv.stats', () => {
 
-    it('should merge channels into a matrix', () => {
-      const matrix = cv.matrix({
-        width: 3,
-        height: 3,
+    it('should compute per channel statistics', () => {
+      const image = cv.matrix({
+        width: 2,
+        height: 2,
         type: cv.ImageType.BGR,
         data: [
-          1, 1, 1,
-          2, 2, 2,
-          3, 3, 3,
-
-          4, 4, 4,
-          5, 5, 5,
-          6, 6, 6,
-
-          7, 7, 7,
-          8, 8, 8,
-          9, 9, 9
+          0, 10, 20, 30,
+          1, 1, 1, 1,
+          255, 0, 255, 0
         ]
       });
 
-      return cv.split(matrix).then(channels => {
-        return cv.merge(...channels);
-      }).then(merged => {
-        expect(merged.type).to.equal(cv.ImageType.BGR);
-        expect(merged.toArray()).to.eql([
-          1, 1, 1,
-          2, 2, 2,
-          3, 3, 3,
+      return cv.stats(image).then(stats => {
+        expect(stats.mean).to.be.a(Float64Array);
+        expect(Array.from(stats.mean)).to.eql([15, 1, 127.5]);
+        expect(Array.from(stats.stddev).map(it => Math.round(it * 100) / 100)).to.eql([11.18, 0, 127.5]);
+        expect(Array.from(stats.min)).to.eql([0, 1, 0]);
+        expect(Array.from(stats.max)).to.eql([30, 1, 255]);
+        expect(stats.count).to.equal(4);
+      });
+    });
 
-          4, 4, 4,
-          5, 5, 5,
-          6, 6, 6,
+    it('should only use the pixels in the mask', () => {
+      const image = cv.matrix({width: 3, height: 1, type: cv.ImageType.Gray, data: [10, 20, 90]});
+      const mask = cv.matrix({width: 3, height: 1, type: cv.ImageType.Gray, data: [1, 1, 0]});
 
-          7, 7, 7,
-          8, 8, 8,
-          9, 9, 9
-        ]);
+      return cv.stats(image, {mask}).then(stats => {
+        expect(Array.from(stats.mean)).to.eql([15]);
+        expect(Array.from(stats.max)).to.eql([20]);
+        expect(stats.count).to.equal(2);
       });
     });
 
   });
 
-  describe('cv.mergeSync', () => {
+  describe('cv.statsSync', () => {
 
-    it('should merge channels into a matrix', () => {
-      const matrix = cv.matrix({
-        width: 3,
-        height: 3,
-        type: cv.ImageType.BGR,
-        data: [
-          1, 1, 1,
-          2, 2, 2,
-          3, 3, 3,
+    it('should compute statistics of a large image', () => {
+      const image = cv.readImageSync(testImagePath, cv.ImageType.Gray);
+      const stats = cv.statsSync(image);
+      const data = image.toArray();
 
-          4, 4, 4,
-          5, 5, 5,
-          6, 6, 6,
+      expect(stats.count).to.equal(testImageWidth * testImageHeight);
+      expect(stats.mean[0]).to.be.within(_.mean(data) - 1e-6, _.mean(data) + 1e-6);
+      expect(stats.min[0]).to.equal(_.min(data));
+      expect(stats.max[0]).to.equal(_.max(data));
+    });
 
-          7, 7, 7,
-          8, 8, 8,
-          9, 9, 9
-        ]
+    it('should compute the standard deviation of values far from zero', () => {
+      const stats = cv.statsSync(cv.matrix([[1e9, 1e9 + 1, 1e9 + 2, 1e9 + 3]]));
+
+      expect(stats.mean[0]).to.equal(1e9 + 1.5);
+      expect(stats.stddev[0]).to.be.within(1.118, 1.1181);
+    });
+
+    it('should fail if the callback is not a function', () => {
+      expect(() => {
+        cv.statsSync(cv.matrix([[1]]), {}, null);
+      }).to.throwException(err => {
+        expect(err.message).to.equal('third argument (callback) must be a function');
       });
+    });
 
-      const channels = cv.splitSync(matrix);
-      const merged = cv.mergeSync(...channels);
+  });
 
-      expect(merged.type).to.equal(cv.ImageType.BGR);
-      expect(merged.toArray()).to.eql([
-        1, 1, 1,
-        2, 2, 2,
-        3, 3, 3,
+  describe('cv.histogram', () => {
 
-        4, 4, 4,
-        5, 5, 5,
-        6, 6, 6,
+    it('should compute a histogram per channel', () => {
+      const image = cv.matrix({width: 4, height: 1, type: cv.ImageType.Gray, data: [0, 1, 1, 255]});
 
-        7, 7, 7,
-        8, 8, 8,
-        9, 9, 9
-      ]);
+      return Promise.all([
+        cv.histogram(image),
+        cv.histogram(image, {bins: 2}),
+        cv.histogram(cv.matrix({width: 1, height: 2, type: cv.ImageType.BGR, data: [0, 128, 1, 1, 2, 255]}), {bins: 2})
+      ]).then(([full, two, bgr]) => {
+        expect(full.length).to.equal(1);
+        expect(full[0]).to.be.a(Uint32Array);
+        expect(full[0].length).to.equal(256);
+        expect(full[0][0]).to.equal(1);
+        expect(full[0][1]).to.equal(2);
+        expect(full[0][255]).to.equal(1);
+
+        expect(Array.from(two[0])).to.eql([3, 1]);
+
+        expect(bgr.map(it => Array.from(it))).to.eql([[1, 1], [2, 0], [1, 1]]);
+      });
     });
 
   });
 
-  describe('cv.lookup', () => {
+  describe('cv.histogramSync', () => {
 
-    it('should map a matrix through a lookup table', () => {
-      const matrix = cv.matrix({
-        width: 3,
-        height: 3,
-        type: cv.ImageType.Gray,
-        data: [
-          0,   32,  64,
-          96,  128, 160,
-          192, 224, 255
-        ]
-      });
+    it('should compute a histogram of a float matrix with a range', () => {
+      const matrix = cv.matrix([[0.1, 0.2, 0.6, 0.9]]);
+      const [hist] = cv.histogramSync(matrix, {bins: 4, range: [0, 1]});
 
-      const x = [0, 32, 64, 96, 128, 160, 192, 224, 255];
-      const y = [1, 10, 20, 40, 80,  120, 180, 220, 240]
+      expect(Array.from(hist)).to.eql([2, 0, 1, 1]);
+    });
 
-      const lookupTable = cv.matrix({
-        width: 256,
-        height: 1,
-        type: cv.ImageType.Gray,
-        data: _.range(256).map(it => spline(it, x, y))
+    it('should fail with an invalid range', () => {
+      expect(() => {
+        cv.histogramSync(cv.matrix([[1]]), {range: [1, 0]});
+      }).to.throwException(err => {
+        expect(err.message).to.equal('range must be an array [min, max] where min < max');
+      });
+    });
+
+    it('should fail if the callback is not a function', () => {
+      expect(() => {
+        cv.histogramSync(cv.matrix([[1]]), {bins: 2}, null);
+      }).to.throwException(err => {
+        expect(err.message).to.equal('third argument (callback) must be a function');
       });
+    });
 
-      const lu = lookupTable.toArray();
-
-      return cv.lookup(matrix, lookupTable).then(result => {
-        expect(result.type).to.equal(cv.ImageType.Gray);
+  });
 
-        expect(matrix.toArray()).to.eql([
-          0,   32,  64,
-          96,  128, 160,
-          192, 224, 255
-        ]);
+  describe('cv.countNonZero', () => {
 
-        expect(result.toArray()).to.eql([
-          lu[0],   lu[32],  lu[64],
-          lu[96],  lu[128], lu[160],
-          lu[192], lu[224], lu[255]
-        ]);
+    it('should count non-zero values', () => {
+      return cv.countNonZero(cv.matrix([[0, 1, 2], [0, 0, 3]])).then(count => {
+        expect(count).to.equal(3);
       });
     });
 
   });
 
-  describe('cv.lookupSync', () => {
+  describe('cv.countNonZeroSync', () => {
 
-    it('should map a matrix through a lookup table', () => {
-      const matrix = cv.matrix({
-        width: 3,
-        height: 3,
-        type: cv.ImageType.Gray,
-        data: [
-          0,   32,  64,
-          96,  128, 160,
-          192, 224, 255
-        ]
+    it('should fail with a multi channel image', () => {
+      expect(() => {
+        cv.countNonZeroSync(new cv.Matrix(2, 2, cv.ImageType.BGR));
+      }).to.throwException(err => {
+        expect(err.message).to.equal('first argument (image) must be a single channel Matrix');
       });
+    });
 
-      const x = [0, 32, 64, 96, 128, 160, 192, 224, 255];
-      const y = [1, 10, 20, 40, 80,  120, 180, 220, 240]
+  });
 
-      const lookupTable = cv.matrix({
-        width: 256,
-        height: 1,
-        type: cv.ImageType.Gray,
-        data: _.range(256).map(it => spline(it, x, y))
-      });
+  describe('cv.equalizeHist', () => {
 
-      const lu = lookupTable.toArray();
-      const result = cv.lookupSync(matrix, lookupTable);
+    it('should stretch the histogram of a gray image', () => {
+      const image = cv.matrix({width: 4, height: 1, type: cv.ImageType.Gray, data: [100, 101, 102, 103]});
 
-      expect(result.type).to.equal(cv.ImageType.Gray);
+      return cv.equalizeHist(image).then(result => {
+        expect(result.type).to.equal(cv.ImageType.Gray);
+        expect(result.toArray()).to.eql([0, 85, 170, 255]);
+      });
+    });
 
-      expect(matrix.toArray()).to.eql([
-        0,   32,  64,
-        96,  128, 160,
-        192, 224, 255
-      ]);
+    it('should equalize the luminance or each channel of a color image', () => {
+      return cv.readImage(alphaImagePath).then(image => {
+        return Promise.all([
+          cv.equalizeHist(image),
+          cv.equalizeHist(image, {mode: 'perChannel'})
+        ]).then(([luminance, perChannel]) => {
+          expect(luminance.type).to.equal(cv.ImageType.BGRA);
+          expect(perChannel.type).to.equal(cv.ImageType.BGRA);
+
+          // The alpha channel is kept as-is.
+          const alpha = cv.splitSync(image)[3].toArray();
+          expect(cv.splitSync(luminance)[3].toArray()).to.eql(alpha);
+          expect(cv.splitSync(perChannel)[3].toArray()).to.eql(alpha);
+        });
+      });
+    });
 
-      expect(result.toArray()).to.eql([
-        lu[0],   lu[32],  lu[64],
-        lu[96],  lu[128], lu[160],
-        lu[192], lu[224], lu[255]
-      ]);
+    it('should fail with an invalid mode', (done) => {
+      cv.equalizeHist(cv.matrix({width: 1, height: 1, type: cv.ImageType.BGR}), {mode: 'hsv'}).catch(err => {
+        expect(err.message).to.equal("mode must be one of ['luminance', 'perChannel']");
+        done();
+      });
     });
 
   });
 
-  describe('cv.gaussianBlur', () => {
-
-    it('should blur an image', () => {
-      const matrix = cv.matrix([
-        [0, 0, 0, 0, 0],
-        [0, 0, 0, 0, 0],
-        [0, 0, 10, 0, 0],
-        [0, 0, 0, 0, 0],
-        [0, 0, 0, 0, 0]
-      ]);
+  describe('cv.equalizeHistSync', () => {
 
-      return Promise.all([
-        cv.gaussianBlur(matrix, {kernelSize: 5}),
-        cv.gaussianBlur(matrix, {kernelSize: {width: 5, height: 1}}),
-        cv.gaussianBlur(matrix, {kernelSize: 5, sigma: 0.8}),
-      ]).then(([res1, res2, res3]) => {
-        res1 = res1.toArray().map(it => Math.round(it * 10));
-        res2 = res2.toArray().map(it => Math.round(it * 10));
-        res3 = res3.toArray().map(it => Math.round(it * 10));
+    it('should fail with a float image', () => {
+      expect(() => {
+        cv.equalizeHistSync(cv.matrix([[1, 2]]));
+      }).to.throwException(err => {
+        expect(err.message).to.equal('first argument (image) must be a Gray, BGR or BGRA image');
+      });
+    });
 
-        expect(res1).to.eql([
-          2, 3, 5,  3, 2,
-          3, 6, 9,  6, 3,
-          5, 9, 14, 9, 5,
-          3, 6, 9,  6, 3,
-          2, 3, 5,  3, 2
-        ]);
+  });
 
-        expect(res2).to.eql([
-          0,  0,  0,  0,  0,
-          0,  0,  0,  0,  0,
-          13, 25, 38, 25, 13,
-          0,  0,  0,  0,  0,
-          0,  0,  0,  0,  0
-        ]);
+  describe('cv.clahe', () => {
 
-        expect(res3).to.eql([
-          0, 1,  2,  1,  0,
-          1, 5,  11, 5,  1,
-          2, 11, 25, 11, 2,
-          1, 5,  11, 5,  1,
-          0, 1,  2,  1,  0
+    it('should equalize an image in tiles', () => {
+      return cv.readImage(testImagePath).then(image => {
+        return Promise.all([
+          cv.clahe(image),
+          cv.clahe(image, {clipLimit: 4, tileGrid: {width: 4, height: 2}, mode: 'perChannel'}),
+          cv.clahe(cv.convertColorSync(image, cv.Conversion.BGRToGray).convertToSync(cv.ImageType.Gray16, {scale: 257}), {tileGrid: 16})
         ]);
+      }).then(([luminance, perChannel, gray16]) => {
+        expect(luminance.type).to.equal(cv.ImageType.BGR);
+        expect(luminance.width).to.equal(testImageWidth);
+        expect(perChannel.type).to.equal(cv.ImageType.BGR);
+        expect(gray16.type).to.equal(cv.ImageType.Gray16);
       });
     });
 
   });
 
-  describe('cv.gaussianBlurSync', () => {
-
-    it('should blur an image', () => {
-      const matrix = cv.matrix([
-        [0, 0, 0],
-        [0, 1, 0],
-        [0, 0, 0]
-      ]);
-
-      let res1 = cv.gaussianBlurSync(matrix, {kernelSize: 3, xSigma: 0.5, ySigma: 0.5});
-      let res2 = cv.gaussianBlurSync(matrix, {kernelSize: {width: 3, height: 1}, sigma: 0.5});
-      let res3 = cv.gaussianBlurSync(matrix, {kernelSize: 3, sigma: 0.6});
-
-      res1 = res1.toArray().map(it => Math.round(it * 10));
-      res2 = res2.toArray().map(it => Math.round(it * 10));
-      res3 = res3.toArray().map(it => Math.round(it * 10));
+  describe('cv.claheSync', () => {
 
-      expect(res1).to.eql([
-        0, 2, 0,
-        2, 6, 2,
-        0, 2, 0
-      ]);
+    it('should increase the contrast of a low contrast image', () => {
+      const data = _.range(64 * 64).map(i => 100 + (i % 64) % 8);
+      const image = cv.matrix({width: 64, height: 64, type: cv.ImageType.Gray, data});
 
-      expect(res2).to.eql([
-        0, 0, 0,
-        2, 8, 2,
-        0, 0, 0
-      ]);
+      const before = cv.statsSync(image);
+      const after = cv.statsSync(cv.claheSync(image, {clipLimit: 40}));
 
-      expect(res3).to.eql([
-        1, 2, 1,
-        2, 4, 2,
-        1, 2, 1
-      ]);
+      expect(after.stddev[0]).to.be.greaterThan(before.stddev[0] * 2);
     });
 
   });
 
-  describe('cv.colorTemperature', () => {
-
-    it('should change the color temperature of the image', () => {
-      const matrix = cv.matrix({
-        width: 3,
-        height: 3,
-        type: cv.ImageType.BGR,
-        data: [
-          0,   0,   0,
-          128, 128, 128,
-          255, 255, 255,
+  describe('cv.perceptualHash', () => {
 
-          0,   0,   0,
-          128, 128, 128,
-          255, 255, 255,
+    it('should return similar hashes for similar images', () => {
+      return cv.readImage(testImagePath).then(image => {
+        const small = cv.resizeSync(image, {width: 200});
+        const gray = cv.convertColorSync(image, cv.Conversion.BGRToGray);
+        const flipped = cv.flipUpDownSync(image);
+
+        return Promise.all(['dhash', 'phash', 'ahash'].map(type => {
+          return Promise.all([image, small, gray, flipped].map(it => cv.perceptualHash(it, {type})));
+        }));
+      }).then(results => {
+        results.forEach(([original, small, gray, flipped]) => {
+          expect(original).to.match(/^[0-9a-f]{16}$/);
+
+          expect(cv.hashDistance(original, original)).to.equal(0);
+          expect(cv.hashDistance(original, small)).to.be.lessThan(6);
+          expect(cv.hashDistance(original, gray)).to.be.lessThan(3);
+          expect(cv.hashDistance(original, flipped)).to.be.greaterThan(10);
+        });
+      });
+    });
 
-          0,   0,   0,
-          128, 128, 128,
-          255, 255, 255
-        ]
+    it('should fail with an invalid type', (done) => {
+      cv.perceptualHash(cv.matrix([[1]]), {type: 'whash'}).catch(err => {
+        expect(err.message).to.equal("type must be one of ['dhash', 'phash', 'ahash']");
+        done();
       });
+    });
 
-      return cv.colorTemperature(matrix, 4000, 1).then(result => {
-        expect(result.toArray()).to.eql([
-          0,   0,   0,
-          95,  95,  95,
-          255, 255, 255,
+  });
 
-          0,   0,   0,
-          124, 124, 124,
-          255, 255, 255,
+  describe('cv.perceptualHashSync', () => {
 
-          0,   0,   0,
-          161, 161, 161,
-          255, 255, 255
-        ]);
-      });
+    it('should compute a dhash by default', () => {
+      // Every pixel is brighter than the one on its left.
+      const matrix = cv.matrix(_.range(8).map(() => _.range(9).map(it => it * 10)));
+      expect(cv.perceptualHashSync(matrix)).to.equal('ffffffffffffffff');
     });
 
   });
 
-  describe('cv.colorTemperatureSync', () => {
+  describe('cv.HashIndex', () => {
 
-    it('should change the color temperature of the image', () => {
-      const matrix = cv.matrix({
-        width: 3,
-        height: 3,
-        type: cv.ImageType.BGR,
-        data: [
-          0,   0,   0,
-          128, 128, 128,
-          255, 255, 255,
+    it('should find hashes within a hamming distance', () => {
+      const index = new cv.HashIndex();
 
-          0,   0,   0,
-          128, 128, 128,
-          255, 255, 255,
+      return index.add(['0000000000000000', '0000000000000003', 'ffffffffffffffff', '000000000000000f'], [1, 2, 3, 4])
+        .then(() => index.add('0000000000000000', 5))
+        .then(() => {
+          expect(index.size).to.equal(5);
+          return index.query('0000000000000001', 2);
+        })
+        .then(matches => {
+          expect(matches.map(it => it.distance)).to.eql([1, 1, 1]);
+          expect(_.sortBy(matches.map(it => it.id))).to.eql([1, 2, 5]);
+          expect(matches.find(it => it.id === 2).hash).to.equal('0000000000000003');
 
-          0,   0,   0,
-          128, 128, 128,
-          255, 255, 255
-        ]
-      });
+          return index.query(['ffffffffffffff00', '0000000000000000'], 8);
+        })
+        .then(([first, second]) => {
+          expect(first.map(it => it.id)).to.eql([3]);
+          expect(first[0].distance).to.equal(8);
+          expect(second.map(it => it.distance)).to.eql([0, 0, 2, 4]);
+        });
+    });
 
-      const result =  cv.colorTemperatureSync(matrix, 4000, 1);
+    it('should match a linear scan', () => {
+      const index = new cv.HashIndex();
+      const hashes = _.range(500).map(() => _.range(16).map(() => _.random(15).toString(16)).join(''));
 
-      expect(result.toArray()).to.eql([
-        0,   0,   0,
-        95,  95,  95,
-        255, 255, 255,
+      index.addSync(hashes, _.range(hashes.length));
 
-        0,   0,   0,
-        124, 124, 124,
-        255, 255, 255,
+      hashes.slice(0, 20).forEach(query => {
+        const expected = _.range(hashes.length).filter(i => cv.hashDistance(query, hashes[i]) <= 24);
+        const actual = index.querySync(query, 24).map(it => it.id);
 
-        0,   0,   0,
-        161, 161, 161,
-        255, 255, 255
-      ]);
+        expect(_.sortBy(actual)).to.eql(expected);
+      });
+    });
+
+    it('should fail with an invalid hash', () => {
+      expect(() => {
+        new cv.HashIndex().addSync('not a hash', 1);
+      }).to.throwException(err => {
+        expect(err.message).to.equal('first argument (hash) must be a hash returned by cv.perceptualHash or an array of them');
+      });
     });
 
   });
@@ -2198,6 +4357,99 @@ describe('simple-cv', () => {
 
   });
 
+  describe('cv.composite', () => {
+
+    // A 2x2 image where every pixel has the given channel values.
+    function solid(type, values) {
+      return cv.matrix({
+        width: 2,
+        height: 2,
+        type,
+        data: _.flatten(values.map(value => [value, value, value, value]))
+      });
+    }
+
+    it('should blend a BGRA overlay onto a BGR image', () => {
+      const base = solid(cv.ImageType.BGR, [100, 100, 100]);
+      const overlay = solid(cv.ImageType.BGRA, [200, 0, 50, 128]);
+
+      return cv.composite(base, overlay).then(result => {
+        expect(result).to.equal(base);
+        expect(base.toArray()).to.eql(solid(cv.ImageType.BGR, [150, 50, 75]).toArray());
+      });
+    });
+
+    it('should apply opacity to overlays without alpha', () => {
+      const base = solid(cv.ImageType.BGR, [100, 100, 100]);
+      cv.compositeSync(base, solid(cv.ImageType.BGR, [200, 0, 50]), {opacity: 0.5});
+
+      expect(base.toArray()).to.eql(solid(cv.ImageType.BGR, [150, 50, 75]).toArray());
+    });
+
+    it('should support multiply and screen blending', () => {
+      const multiplied = solid(cv.ImageType.BGR, [100, 100, 100]);
+      const screened = solid(cv.ImageType.BGR, [100, 100, 100]);
+
+      cv.compositeSync(multiplied, solid(cv.ImageType.BGR, [200, 200, 200]), {blend: 'multiply'});
+      cv.compositeSync(screened, solid(cv.ImageType.BGR, [200, 200, 200]), {blend: 'screen'});
+
+      expect(multiplied.toArray()).to.eql(solid(cv.ImageType.BGR, [78, 78, 78]).toArray());
+      expect(screened.toArray()).to.eql(solid(cv.ImageType.BGR, [222, 222, 222]).toArray());
+    });
+
+    it('should blend long rows like single pixels', () => {
+      const width = 19;
+      const pixel = (i, channels) => _.range(channels).map(c => (i * 37 + c * 101) % 256);
+
+      [cv.ImageType.Gray, cv.ImageType.BGR, cv.ImageType.BGRA].forEach(overlayType => {
+        const channels = overlayType === cv.ImageType.Gray ? 1 : overlayType === cv.ImageType.BGR ? 3 : 4;
+
+        ['over', 'multiply', 'screen'].forEach(blend => {
+          const base = cv.matrix({width, height: 1, type: cv.ImageType.BGR, data: planar(_.range(width).map(i => pixel(i + 7, 3)))});
+          const overlay = cv.matrix({width, height: 1, type: overlayType, data: planar(_.range(width).map(i => pixel(i, channels)))});
+
+          cv.compositeSync(base, overlay, {blend, opacity: 0.8});
+
+          const expected = _.range(width).map(i => {
+            const single = cv.matrix({width: 1, height: 1, type: cv.ImageType.BGR, data: pixel(i + 7, 3)});
+            cv.compositeSync(single, cv.matrix({width: 1, height: 1, type: overlayType, data: pixel(i, channels)}), {blend, opacity: 0.8});
+            return single.toArray();
+          });
+
+          expect(base.toArray()).to.eql(planar(expected));
+        });
+      });
+
+      // Pixel arrays to the channel-planar data used by the matrix constructor and toArray.
+      function planar(pixels) {
+        return _.flatten(_.range(pixels[0].length).map(c => pixels.map(p => p[c])));
+      }
+    });
+
+    it('should composite onto transparent BGRA images', () => {
+      const base = solid(cv.ImageType.BGRA, [10, 20, 30, 0]);
+      cv.compositeSync(base, solid(cv.ImageType.BGRA, [200, 0, 50, 128]));
+
+      expect(base.toArray()).to.eql(solid(cv.ImageType.BGRA, [200, 0, 50, 128]).toArray());
+    });
+
+    it('should only blend the part of the overlay inside the image', () => {
+      const base = solid(cv.ImageType.BGR, [0, 0, 0]);
+      cv.compositeSync(base, solid(cv.ImageType.Gray, [255]), {x: -1, y: -1});
+
+      expect(base.toArray()).to.eql([255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0]);
+    });
+
+    it('should fail with a gray base', () => {
+      expect(() => {
+        cv.compositeSync(solid(cv.ImageType.Gray, [0]), solid(cv.ImageType.Gray, [0]));
+      }).to.throwException(err => {
+        expect(err.message).to.equal('first argument (base) must be a BGR or BGRA image');
+      });
+    });
+
+  });
+
   describe('Rect', () => {
     const Rect = cv.Rect;
 